@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include "KernelRegistry.hpp"
+#include "DCTNative.hpp"
+#include "Interpolation.h"
+
+// times every registered block kernel for every block size and every instruction set this machine can run,
+// plus the native DCT and the plane wide ToPixels and interpolation filters. usage: kernel-benchmark [milliseconds per kernel] [name filter]
+
+namespace {
+
+constexpr auto Padding = 32;
+constexpr auto PlaneWidth = 1920;
+constexpr auto PlaneHeight = 1080;
+constexpr auto DegrainRadius = 2;
+
+volatile auto Sink = 0.;
+
+struct Plane final {
+	std::vector<float> Samples;
+	std::intptr_t Pitch;
+	std::uint8_t *Origin;
+	Plane(int nWidth, int nHeight, std::uint32_t nSeed) {
+		auto nStride = nWidth + 2 * Padding;
+		Samples.resize(static_cast<std::size_t>(nStride) * (nHeight + 2 * Padding));
+		auto Engine = std::mt19937{ nSeed };
+		auto Distribution = std::uniform_real_distribution<float>{ 0.f, 255.f };
+		for (auto &x : Samples)
+			x = Distribution(Engine);
+		Pitch = nStride * sizeof(float);
+		Origin = reinterpret_cast<std::uint8_t *>(Samples.data() + Padding * nStride + Padding);
+	}
+};
+
+struct Options final {
+	double SecondsPerKernel = .05;
+	std::string Filter;
+};
+
+auto ISAName(InstructionSet isa) {
+	switch (isa) {
+	case InstructionSet::SSE2:
+		return "sse2";
+	case InstructionSet::AVX2:
+		return "avx2";
+	case InstructionSet::AVX512:
+		return "avx512";
+	default:
+		return "c";
+	}
+}
+
+// doubles the iteration count until a run takes long enough, then reports the fastest of a few runs.
+template<typename BodyType>
+auto Measure(const Options &options, BodyType &&Body) {
+	using Clock = std::chrono::steady_clock;
+	auto Time = [&](std::int64_t nIterations) {
+		auto Start = Clock::now();
+		for (auto i = std::int64_t{ 0 }; i < nIterations; ++i)
+			Body();
+		return std::chrono::duration<double>{ Clock::now() - Start }.count();
+	};
+	auto nIterations = std::int64_t{ 1 };
+	auto Elapsed = Time(nIterations);
+	while (Elapsed < options.SecondsPerKernel / 4) {
+		nIterations *= 2;
+		Elapsed = Time(nIterations);
+	}
+	for (auto i = 0; i < 3; ++i)
+		Elapsed = std::min(Elapsed, Time(nIterations));
+	return Elapsed / nIterations;
+}
+
+auto Report(const Options &options, const std::string &Name, const std::string &Variant, double nBytes, auto &&Body) {
+	if (!options.Filter.empty() && (Name + " " + Variant).find(options.Filter) == std::string::npos)
+		return;
+	auto Seconds = Measure(options, Body);
+	std::printf("%-12s %-18s %12.1f ns/call %9.2f GB/s\n", Name.c_str(), Variant.c_str(), Seconds * 1e9, nBytes / Seconds / 1e9);
+	std::fflush(stdout);
+}
+
+// bytes each kernel kind reads or writes per call for a w x h block of float samples.
+template<KernelKind Kind>
+auto BytesPerCall(int nBlkWidth, int nBlkHeight) {
+	auto nSamples = static_cast<double>(nBlkWidth) * nBlkHeight;
+	switch (Kind) {
+	case KernelKind::SAD:
+	case KernelKind::SADLimit:
+	case KernelKind::SATD:
+		return nSamples * sizeof(float) * 2;
+	case KernelKind::SADx4:
+		return nSamples * sizeof(float) * 5;
+	case KernelKind::SADYUV:
+		return nSamples * sizeof(float) * 3;
+	case KernelKind::Luma:
+		return nSamples * sizeof(float);
+	case KernelKind::Copy:
+		return nSamples * sizeof(float) * 2;
+	case KernelKind::Overlaps:
+		return nSamples * (sizeof(float) + sizeof(double) * 3);
+	default:
+		return nSamples * sizeof(float) * (DegrainRadius * 2 + 2);
+	}
+}
+
+auto KindName(KernelKind Kind) {
+	switch (Kind) {
+	case KernelKind::SAD:
+		return "SAD";
+	case KernelKind::SADLimit:
+		return "SADLimit";
+	case KernelKind::SADx4:
+		return "SADx4";
+	case KernelKind::SADYUV:
+		return "SADYUV";
+	case KernelKind::SATD:
+		return "SATD";
+	case KernelKind::Luma:
+		return "Luma";
+	case KernelKind::Copy:
+		return "Copy";
+	case KernelKind::Overlaps:
+		return "Overlaps";
+	default:
+		return "Degrain";
+	}
+}
+
+struct Buffers final {
+	Plane Src{ 256, 256, 1 };
+	std::vector<Plane> Refs;
+	Plane Dst{ 256, 256, 9 };
+	std::vector<double> Window;
+	std::vector<double> Accumulator;
+	Buffers() {
+		for (auto i = 0; i < 4; ++i)
+			Refs.emplace_back(256, 256, 2 + i);
+		Window.assign(256 * 256, 32.);
+		Accumulator.assign(256 * 256, 0.);
+	}
+};
+
+template<KernelKind Kind>
+auto RunKernel(const Options &options, Buffers &b, BlockSize Size, InstructionSet isa) {
+	auto Kernel = KernelRegistry<Kind>::Find(Size.Width, Size.Height, isa);
+	if (!Kernel)
+		return;
+	// kinds without a variant for this instruction set would only repeat the previous row.
+	if (isa != InstructionSet::C && Kernel == KernelRegistry<Kind>::Find(Size.Width, Size.Height, static_cast<InstructionSet>(static_cast<std::int32_t>(isa) - 1)))
+		return;
+	auto Name = std::string{ KindName(Kind) };
+	auto Variant = std::to_string(Size.Width) + "x" + std::to_string(Size.Height) + " " + ISAName(isa);
+	auto nBytes = BytesPerCall<Kind>(Size.Width, Size.Height);
+	auto pSrc = b.Src.Origin;
+	auto nPitch = b.Src.Pitch;
+	auto pRef = b.Refs[0].Origin + sizeof(float);
+	if constexpr (Kind == KernelKind::SAD || Kind == KernelKind::SATD)
+		Report(options, Name, Variant, nBytes, [&] { Sink = Sink + Kernel(pSrc, nPitch, pRef, nPitch); });
+	else if constexpr (Kind == KernelKind::SADLimit)
+		Report(options, Name, Variant, nBytes, [&] { Sink = Sink + Kernel(pSrc, nPitch, pRef, nPitch, std::numeric_limits<double>::max()); });
+	else if constexpr (Kind == KernelKind::SADx4) {
+		const std::uint8_t *pRefs[] = { b.Refs[0].Origin, b.Refs[1].Origin, b.Refs[2].Origin, b.Refs[3].Origin };
+		double SADs[4];
+		Report(options, Name, Variant, nBytes, [&] {
+			Kernel(pSrc, nPitch, pRefs, nPitch, SADs);
+			Sink = Sink + SADs[0];
+		});
+	}
+	else if constexpr (Kind == KernelKind::SADYUV) {
+		auto Fused = Kernel(2, 2);
+		if (!Fused)
+			return;
+		const std::uint8_t *pSrcs[] = { pSrc, b.Refs[1].Origin, b.Refs[2].Origin };
+		const std::uint8_t *pRefs[] = { pRef, b.Refs[3].Origin, b.Dst.Origin };
+		std::int32_t nPitches[] = { static_cast<std::int32_t>(nPitch), static_cast<std::int32_t>(nPitch), static_cast<std::int32_t>(nPitch) };
+		auto SADUV = 0.;
+		Report(options, Name, Variant + " 420", nBytes, [&] {
+			Sink = Sink + Fused(pSrcs, nPitches, pRefs, nPitches, std::numeric_limits<double>::max(), &SADUV) + SADUV;
+		});
+	}
+	else if constexpr (Kind == KernelKind::Luma)
+		Report(options, Name, Variant, nBytes, [&] { Sink = Sink + Kernel(pSrc, nPitch); });
+	else if constexpr (Kind == KernelKind::Copy)
+		Report(options, Name, Variant, nBytes, [&] { Kernel(b.Dst.Origin, nPitch, pSrc, nPitch); });
+	else if constexpr (Kind == KernelKind::Overlaps) {
+		auto pDst = reinterpret_cast<std::uint8_t *>(b.Accumulator.data());
+		auto nDstPitch = static_cast<std::intptr_t>(256 * sizeof(double));
+		Report(options, Name, Variant, nBytes, [&] { Kernel(pDst, nDstPitch, pSrc, nPitch, b.Window.data(), 256); });
+	}
+	else {
+		const std::uint8_t *pRefs[DegrainRadius * 2];
+		std::int32_t nRefPitches[DegrainRadius * 2];
+		double WRefs[DegrainRadius * 2];
+		for (auto r = 0; r < DegrainRadius * 2; ++r) {
+			nRefPitches[r] = static_cast<std::int32_t>(nPitch);
+			WRefs[r] = 48.;
+		}
+		Report(options, Name, Variant, nBytes, [&] {
+			for (auto r = 0; r < DegrainRadius * 2; ++r)
+				pRefs[r] = b.Refs[r].Origin;
+			Kernel(DegrainRadius, b.Dst.Origin, static_cast<std::int32_t>(nPitch), pSrc, static_cast<std::int32_t>(nPitch), pRefs, nRefPitches, 64., WRefs);
+		});
+	}
+}
+
+template<KernelKind... Kinds>
+auto RunKernels(const Options &options, Buffers &b) {
+	auto Available = GetInstructionSet();
+	for (auto Size : RegisteredBlockSizes)
+		for (auto isa : RegisteredInstructionSets)
+			if (isa <= Available)
+				(RunKernel<Kinds>(options, b, Size, isa), ...);
+}
+
+// the native DCT picks its own instruction set, so there is one row per block size it covers.
+auto RunDCT(const Options &options, Buffers &b) {
+	auto Output = std::vector<float>(256 * 256);
+	for (auto Size : RegisteredBlockSizes) {
+		if (!DCTNative::Supports(Size.Width, Size.Height))
+			continue;
+		auto Transform = DCTNative{ Size.Width, Size.Height, 1 };
+		auto Variant = std::to_string(Size.Width) + "x" + std::to_string(Size.Height) + " " + ISAName(GetInstructionSet());
+		auto nBytes = 2. * Size.Width * Size.Height * sizeof(float);
+		Report(options, "DCT", Variant, nBytes, [&] {
+			Transform.DCTBytes2D(b.Src.Origin, static_cast<int>(b.Src.Pitch), reinterpret_cast<std::uint8_t *>(Output.data()), static_cast<int>(Size.Width * sizeof(float)));
+			Sink = Sink + Output[0];
+		});
+	}
+}
+
+using PlaneFilter = auto(*)(std::uint8_t *, const std::uint8_t *, std::int32_t, std::int32_t, std::int32_t, std::int32_t)->void;
+
+auto RunPlaneFilters(const Options &options) {
+	auto Src = Plane{ PlaneWidth * 2, PlaneHeight * 2, 11 };
+	auto Src2 = Plane{ PlaneWidth, PlaneHeight, 12 };
+	auto Dst = Plane{ PlaneWidth, PlaneHeight, 13 };
+	auto nPitch = static_cast<std::int32_t>(Dst.Pitch);
+	auto nSrcPitch = static_cast<std::int32_t>(Src.Pitch);
+	auto nSamples = static_cast<double>(PlaneWidth) * PlaneHeight;
+	auto Variant = std::to_string(PlaneWidth) + "x" + std::to_string(PlaneHeight);
+	struct Filter final {
+		const char *Name;
+		PlaneFilter Function;
+		bool Reduce;
+	};
+	const Filter Filters[] = {
+		{ "VBilinear", VerticalBilinear<float>, false },
+		{ "HBilinear", HorizontalBilinear<float>, false },
+		{ "DBilinear", DiagonalBilinear<float>, false },
+		{ "VBicubic", VerticalBicubic<float>, false },
+		{ "HBicubic", HorizontalBicubic<float>, false },
+		{ "DBicubic", DiagonalBicubic<float>, false },
+		{ "VWiener", VerticalWiener<float>, false },
+		{ "HWiener", HorizontalWiener<float>, false },
+		{ "DWiener", DiagonalWiener<float>, false },
+		{ "RB2Average", RB2F_C<float>, true },
+		{ "RB2Filtered", RB2Filtered<float>, true },
+		{ "RB2Bilinear", RB2BilinearFiltered<float>, true },
+		{ "RB2Quadratic", RB2Quadratic<float>, true },
+		{ "RB2Cubic", RB2Cubic<float>, true }
+	};
+	for (auto &x : Filters) {
+		auto pSrc = x.Reduce ? Src.Origin : Src2.Origin;
+		auto nFilterSrcPitch = x.Reduce ? nSrcPitch : nPitch;
+		auto nBytes = nSamples * sizeof(float) * (x.Reduce ? 5 : 2);
+		Report(options, x.Name, Variant, nBytes, [&] { x.Function(Dst.Origin, pSrc, nPitch, nFilterSrcPitch, PlaneWidth, PlaneHeight); });
+	}
+	Report(options, "Average2", Variant, nSamples * sizeof(float) * 3, [&] { Average2<float>(Dst.Origin, Src2.Origin, Dst.Origin, nPitch, PlaneWidth, PlaneHeight); });
+	auto Accumulator = std::vector<double>(static_cast<std::size_t>(PlaneWidth) * PlaneHeight, 0.);
+	auto pAccumulator = reinterpret_cast<std::uint8_t *>(Accumulator.data());
+	auto nAccumulatorPitch = static_cast<std::int32_t>(PlaneWidth * sizeof(double));
+	Report(options, "ToPixels", Variant, nSamples * (sizeof(double) + sizeof(float)), [&] { ToPixels<double, float>(Dst.Origin, nPitch, pAccumulator, nAccumulatorPitch, PlaneWidth, PlaneHeight); });
+}
+
+}
+
+auto main(int argc, char **argv)->int {
+	auto options = Options{};
+	if (argc > 1)
+		options.SecondsPerKernel = std::max(1., std::atof(argv[1])) / 1000.;
+	if (argc > 2)
+		options.Filter = argv[2];
+	std::printf("instruction set: %s\n", ISAName(GetInstructionSet()));
+	auto b = Buffers{};
+	RunKernels<KernelKind::SAD, KernelKind::SADLimit, KernelKind::SADx4, KernelKind::SADYUV, KernelKind::SATD,
+		KernelKind::Luma, KernelKind::Copy, KernelKind::Overlaps, KernelKind::Degrain>(options, b);
+	RunDCT(options, b);
+	RunPlaneFilters(options);
+	return Sink < 0. ? EXIT_FAILURE : EXIT_SUCCESS;
+}
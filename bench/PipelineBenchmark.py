@@ -0,0 +1,275 @@
+#!/usr/bin/env python3
+# end to end throughput of the plugin on synthetic clips, the numbers to quote for a performance change.
+# usage: PipelineBenchmark.py [name filter] [--frames n] [--threads n] [--plugin path] [--json path]
+#
+# every preset is one resolution, one scene and one pipeline, named like 1080p-pan-degrain2, and runs in a process of
+# its own so its peak RSS and the timing registry of the plugin (MVSF_TIMING, mvsf.Stats()) cover nothing else. each
+# scene is rendered once and loaded into memory before the clock starts, the source filter only copies it into frames.
+#
+# scenes:
+#	pan      a textured plane moving 3.25 pixels right and 1.5 up per frame
+#	zoom     the same plane scaled up by 2% per frame around the center
+#	objects  six textured rectangles moving on their own over a slowly panning background
+#	noise    the pan at a tenth of the speed under heavy grain
+# every scene but noise carries light grain, so Degrain has something to remove.
+#
+# pipelines:
+#	degrain1 .. degrain6  Super, Analyze with that radius, Degrain
+#	flowfps               Super, Analyze backward and forward, FlowFPS to twice the frame rate
+#	blockfps              Super, Analyze backward and forward, BlockFPS to twice the frame rate
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+Resolutions = {
+	"720p": (1280, 720),
+	"1080p": (1920, 1080),
+	"4k": (3840, 2160),
+}
+Scenes = ["pan", "zoom", "objects", "noise"]
+Pipelines = [f"degrain{r}" for r in range(1, 7)] + ["flowfps", "blockfps"]
+Stages = ["Super", "Analyze", "Degrain", "FlowFPS", "BlockFPS"]
+FrameRate = 24
+
+def preset_names():
+	return [f"{resolution}-{scene}-{pipeline}" for resolution in Resolutions for scene in Scenes for pipeline in Pipelines]
+
+# smooth random texture with detail from 4 to 128 pixels, values around center. sampled with bilinear
+# interpolation, so a scene can move it by fractions of a pixel.
+class Texture:
+	def __init__(self, numpy, width, height, seed, center, amplitude):
+		self.numpy = numpy
+		generator = numpy.random.default_rng(seed)
+		samples = numpy.zeros((height, width), numpy.float32)
+		for scale, weight in [(128, 0.45), (32, 0.3), (8, 0.15), (4, 0.1)]:
+			grid = generator.random((height // scale + 2, width // scale + 2), numpy.float32)
+			y, x = numpy.mgrid[0:height, 0:width].astype(numpy.float32) / scale
+			samples += weight * self.bilinear(grid, x, y)
+		self.samples = center + amplitude * (samples - 0.5) * 2
+
+	def bilinear(self, samples, x, y):
+		numpy = self.numpy
+		height, width = samples.shape
+		x = numpy.clip(x, 0, width - 1.001)
+		y = numpy.clip(y, 0, height - 1.001)
+		x0 = x.astype(numpy.int32)
+		y0 = y.astype(numpy.int32)
+		fx = x - x0
+		fy = y - y0
+		top = samples[y0, x0] * (1 - fx) + samples[y0, x0 + 1] * fx
+		bottom = samples[y0 + 1, x0] * (1 - fx) + samples[y0 + 1, x0 + 1] * fx
+		return top * (1 - fy) + bottom * fy
+
+	def sample(self, x, y):
+		return self.bilinear(self.samples, x, y)
+
+# renders the frames of a scene in 4:2:0, one array of [frame, row, column] per plane.
+def render_scene(numpy, scene, width, height, frames):
+	margin = 64
+	speed = 0.1 if scene == "noise" else 1.
+	velocity = (3.25 * speed, -1.5 * speed)
+	extent = (width + 2 * margin + int(abs(velocity[0]) * frames), height + 2 * margin + int(abs(velocity[1]) * frames))
+	planes = [
+		Texture(numpy, *extent, 1, 0.5, 0.4),
+		Texture(numpy, extent[0] // 2, extent[1] // 2, 2, 0.5, 0.1),
+		Texture(numpy, extent[0] // 2, extent[1] // 2, 3, 0.5, 0.1),
+	]
+	generator = numpy.random.default_rng(4)
+	objects = []
+	if scene == "objects":
+		size = height // 6
+		for i in range(6):
+			objects.append({
+				"texture": [Texture(numpy, size, size, 10 + 3 * i + p, 0.5, 0.45 if p == 0 else 0.15) for p in range(3)],
+				"origin": generator.random(2) * (width - size, height - size),
+				"velocity": generator.uniform(-6, 6, 2),
+				"size": size,
+			})
+		velocity = (0.5, 0.25)
+	grain = 8 / 255 if scene == "noise" else 2 / 255
+	result = [numpy.empty((frames, height // (2 if p else 1), width // (2 if p else 1)), numpy.float32) for p in range(3)]
+	for n in range(frames):
+		for p, texture in enumerate(planes):
+			scale = 2 if p else 1
+			y, x = numpy.mgrid[0:height // scale, 0:width // scale].astype(numpy.float32) * scale
+			if scene == "zoom":
+				zoom = 1.02 ** n
+				x = (x - width / 2) / zoom + width / 2
+				y = (y - height / 2) / zoom + height / 2
+			else:
+				x -= velocity[0] * n
+				y -= velocity[1] * n
+			x += margin + max(0., velocity[0]) * frames
+			y += margin + max(0., velocity[1]) * frames
+			samples = texture.sample(x / scale, y / scale)
+			for o in objects:
+				# bounces off the edges of the frame
+				position = o["origin"] + o["velocity"] * n
+				span = numpy.array([width - o["size"], height - o["size"]], numpy.float64)
+				position = numpy.abs((position + span) % (2 * span) - span)
+				left, top = (int(position[0]) // scale, int(position[1]) // scale)
+				extent = o["size"] // scale
+				oy, ox = numpy.mgrid[0:extent, 0:extent].astype(numpy.float32)
+				ox += (position[0] / scale) % 1
+				oy += (position[1] / scale) % 1
+				region = samples[top:top + extent, left:left + extent]
+				region[...] = o["texture"][p].sample(ox, oy)[:region.shape[0], :region.shape[1]]
+			samples += generator.normal(0, grain, samples.shape).astype(numpy.float32)
+			result[p][n] = numpy.clip(samples, 0, 1)
+	return result
+
+def scene_paths(directory, name):
+	resolution, scene, _ = name.split("-")
+	return [os.path.join(directory, f"{resolution}-{scene}-{p}.npy") for p in range(3)]
+
+def peak_rss_bytes():
+	if sys.platform == "win32":
+		import ctypes
+		from ctypes import wintypes
+		class Counters(ctypes.Structure):
+			_fields_ = [
+				("cb", wintypes.DWORD), ("PageFaultCount", wintypes.DWORD),
+				("PeakWorkingSetSize", ctypes.c_size_t), ("WorkingSetSize", ctypes.c_size_t),
+				("QuotaPeakPagedPoolUsage", ctypes.c_size_t), ("QuotaPagedPoolUsage", ctypes.c_size_t),
+				("QuotaPeakNonPagedPoolUsage", ctypes.c_size_t), ("QuotaNonPagedPoolUsage", ctypes.c_size_t),
+				("PagefileUsage", ctypes.c_size_t), ("PeakPagefileUsage", ctypes.c_size_t),
+			]
+		counters = Counters()
+		counters.cb = ctypes.sizeof(Counters)
+		process = ctypes.windll.kernel32.GetCurrentProcess()
+		ctypes.windll.psapi.GetProcessMemoryInfo(process, ctypes.byref(counters), counters.cb)
+		return counters.PeakWorkingSetSize
+	import resource
+	peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+	# kilobytes everywhere but macOS
+	return peak if sys.platform == "darwin" else peak * 1024
+
+def as_list(value):
+	if isinstance(value, (list, tuple)):
+		return list(value)
+	return [value]
+
+# runs one preset in this process and returns its numbers.
+def run_preset(name, options):
+	import numpy
+	import vapoursynth as vs
+	core = vs.core
+	if options.plugin:
+		core.std.LoadPlugin(options.plugin)
+	if options.threads:
+		core.num_threads = options.threads
+	resolution, scene, pipeline = name.split("-")
+	width, height = Resolutions[resolution]
+	frames = [numpy.load(x) for x in scene_paths(options.scenes, name)]
+
+	def copy_frame(n, f):
+		out = f.copy()
+		for p in range(3):
+			if hasattr(out, "get_write_array"):
+				target = numpy.asarray(out.get_write_array(p))
+			else:
+				target = numpy.asarray(out[p])
+			target[...] = frames[p][n]
+		return out
+
+	blank = core.std.BlankClip(format=vs.YUV420PS, width=width, height=height, length=options.frames, fpsnum=FrameRate, fpsden=1)
+	clip = core.std.ModifyFrame(blank, blank, copy_frame)
+	sup = core.mvsf.Super(clip)
+	if pipeline.startswith("degrain"):
+		vectors = core.mvsf.Analyze(sup, radius=int(pipeline[len("degrain"):]), overlap=4)
+		out = core.mvsf.Degrain(clip, sup, vectors)
+	else:
+		backward = core.mvsf.Analyze(sup, isb=1, overlap=4)
+		forward = core.mvsf.Analyze(sup, overlap=4)
+		interpolate = core.mvsf.FlowFPS if pipeline == "flowfps" else core.mvsf.BlockFPS
+		out = interpolate(clip, sup, backward, forward, num=2 * FrameRate, den=1)
+
+	start = time.perf_counter()
+	if hasattr(out, "frames"):
+		for _ in out.frames():
+			pass
+	else:
+		with open(os.devnull, "wb") as sink:
+			out.output(sink)
+	elapsed = time.perf_counter() - start
+
+	stages = {}
+	stats = core.mvsf.Stats() or {}
+	for instance, calls, total in zip(as_list(stats.get("filter", [])), as_list(stats.get("calls", [])), as_list(stats.get("total", []))):
+		instance = instance.decode() if isinstance(instance, bytes) else instance
+		stage = stages.setdefault(instance, {"calls": 0, "milliseconds": 0.})
+		stage["calls"] += calls
+		stage["milliseconds"] += total
+	return {
+		"preset": name,
+		"frames": out.num_frames,
+		"seconds": elapsed,
+		"fps": out.num_frames / elapsed,
+		"stages": stages,
+		"peak_rss": peak_rss_bytes(),
+		"source_bytes": sum(x.nbytes for x in frames),
+	}
+
+def main():
+	parser = argparse.ArgumentParser(description="end to end throughput of the plugin on synthetic clips")
+	parser.add_argument("filter", nargs="?", default="", help="only run presets whose name contains this")
+	parser.add_argument("--frames", type=int, default=24, help="source frames per preset")
+	parser.add_argument("--threads", type=int, default=0, help="VapourSynth threads, all cores when 0")
+	parser.add_argument("--plugin", default="", help="load the plugin from this path instead of the autoloaded one")
+	parser.add_argument("--json", default="", help="also write the results to this file")
+	parser.add_argument("--list", action="store_true", help="print the preset names and exit")
+	parser.add_argument("--run", default="", help=argparse.SUPPRESS)
+	parser.add_argument("--scenes", default="", help=argparse.SUPPRESS)
+	options = parser.parse_args()
+
+	if options.run:
+		print(json.dumps(run_preset(options.run, options)))
+		return 0
+	names = [x for x in preset_names() if options.filter in x]
+	if options.list:
+		print("\n".join(names))
+		return 0
+
+	import numpy
+	directory = tempfile.TemporaryDirectory()
+	environment = dict(os.environ, MVSF_TIMING="1")
+	forward = ["--frames", str(options.frames), "--threads", str(options.threads), "--scenes", directory.name]
+	if options.plugin:
+		forward += ["--plugin", options.plugin]
+	print(f"{'preset':<24}{'fps':>9}" + "".join(f"{x + ' ms':>14}" for x in Stages) + f"{'peak RSS MB':>13}{'source MB':>11}")
+	results = []
+	failed = False
+	for name in names:
+		# presets come grouped by scene, only the current one is kept on disk
+		paths = scene_paths(directory.name, name)
+		if not os.path.exists(paths[0]):
+			for x in os.listdir(directory.name):
+				os.remove(os.path.join(directory.name, x))
+			resolution, scene, _ = name.split("-")
+			for path, x in zip(paths, render_scene(numpy, scene, *Resolutions[resolution], options.frames)):
+				numpy.save(path, x)
+		process = subprocess.run([sys.executable, __file__, "--run", name] + forward, env=environment, capture_output=True, text=True)
+		if process.returncode:
+			print(f"{name:<24}failed: {process.stderr.strip().splitlines()[-1] if process.stderr.strip() else process.returncode}")
+			failed = True
+			continue
+		result = json.loads(process.stdout.strip().splitlines()[-1])
+		results.append(result)
+		# per call of each stage, summed over its instances and all threads
+		columns = ""
+		for stage in Stages:
+			x = result["stages"].get(stage)
+			columns += f"{x['milliseconds'] / x['calls']:>14.2f}" if x and x["calls"] else f"{'-':>14}"
+		print(f"{name:<24}{result['fps']:>9.2f}{columns}{result['peak_rss'] / 2 ** 20:>13.0f}{result['source_bytes'] / 2 ** 20:>11.0f}", flush=True)
+	directory.cleanup()
+	if options.json:
+		with open(options.json, "w") as file:
+			json.dump(results, file, indent="\t")
+	return 1 if failed else 0
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <optional>
+#include <string>
+#include <vector>
+#include "Core.hpp"
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// streams raw single precision frames from a file through Super, Analyze and Degrain or Compensate on one thread
+// and reports the time of every stage, for profiling and PGO training runs without a VapourSynth script around them.
+// the input holds the frames back to back, every frame its planes Y, U and V in turn, every plane its rows without
+// padding, samples in 0..1 like the clips the filters take. usage: raw-pipeline input width height [option value]...
+
+namespace {
+
+constexpr auto Usage =
+	"usage: raw-pipeline input width height [option value]...\n"
+	"  --format 420|422|444|gray   layout of the input, 420 by default\n"
+	"  --mode degrain|compensate   degrain over radius frames on each side, or compensate every frame from the one before\n"
+	"  --frames n                  stop after n frames\n"
+	"  --radius n                  1 by default\n"
+	"  --blksize n                 8 by default\n"
+	"  --overlap n                 0 by default\n"
+	"  --pel n                     2 by default\n"
+	"  --search n                  4 by default\n"
+	"  --dct n                     0 by default\n"
+	"  --wavefront n               threads searching one frame, 0 by default\n"
+	"  --thsad x                   400 for degrain and 10000 for compensate by default\n"
+	"  --output path               write the processed frames there, in the layout of the input\n";
+
+struct Options final {
+	std::string Input;
+	std::string Output;
+	mvsf::Format Format;
+	bool Compensate = false;
+	int Frames = 0;
+	int Radius = 1;
+	std::optional<double> ThSAD;
+	mvsf::SuperParameters Super;
+	mvsf::AnalyzeParameters Analyze;
+};
+
+auto ParseOptions(int argc, char **argv) -> std::optional<Options> {
+	if (argc < 4 || (argc - 4) % 2)
+		return std::nullopt;
+	auto options = Options{};
+	options.Input = argv[1];
+	options.Format.Width = std::atoi(argv[2]);
+	options.Format.Height = std::atoi(argv[3]);
+	for (auto i = 4; i < argc; i += 2) {
+		auto Key = std::string{ argv[i] };
+		auto Value = std::string{ argv[i + 1] };
+		auto Integer = std::atoi(Value.c_str());
+		if (Key == "--format") {
+			if (Value == "420")
+				options.Format.SubSamplingW = options.Format.SubSamplingH = 1;
+			else if (Value == "422")
+				options.Format.SubSamplingW = 1, options.Format.SubSamplingH = 0;
+			else if (Value == "444")
+				options.Format.SubSamplingW = options.Format.SubSamplingH = 0;
+			else if (Value == "gray")
+				options.Format.Planes = 1;
+			else
+				return std::nullopt;
+		}
+		else if (Key == "--mode") {
+			if (Value != "degrain" && Value != "compensate")
+				return std::nullopt;
+			options.Compensate = Value == "compensate";
+		}
+		else if (Key == "--frames")
+			options.Frames = Integer;
+		else if (Key == "--radius")
+			options.Radius = Integer;
+		else if (Key == "--blksize")
+			options.Analyze.BlkSize = Integer;
+		else if (Key == "--overlap")
+			options.Analyze.Overlap = Integer;
+		else if (Key == "--pel")
+			options.Super.Pel = Integer;
+		else if (Key == "--search")
+			options.Analyze.Search = Integer;
+		else if (Key == "--dct")
+			options.Analyze.DCT = Integer;
+		else if (Key == "--wavefront")
+			options.Analyze.Wavefront = Integer;
+		else if (Key == "--thsad")
+			options.ThSAD = std::atof(Value.c_str());
+		else if (Key == "--output")
+			options.Output = Value;
+		else
+			return std::nullopt;
+	}
+	if (options.Format.Width <= 0 || options.Format.Height <= 0 || options.Radius <= 0)
+		return std::nullopt;
+	if (options.Compensate)
+		options.Radius = 1;
+	return options;
+}
+
+// the whole input mapped read only, the frames are used in place.
+class MappedFile final {
+	const std::uint8_t *data = nullptr;
+	std::size_t size = 0;
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#endif
+public:
+	explicit MappedFile(const std::string &path) {
+#ifdef _WIN32
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		auto fileSize = LARGE_INTEGER{};
+		if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+			return;
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+			return;
+		data = static_cast<const std::uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		size = data ? static_cast<std::size_t>(fileSize.QuadPart) : 0;
+#else
+		auto descriptor = open(path.c_str(), O_RDONLY);
+		if (descriptor < 0)
+			return;
+		struct stat status = {};
+		if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+			auto address = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+			if (address != MAP_FAILED) {
+				madvise(address, status.st_size, MADV_SEQUENTIAL);
+				data = static_cast<const std::uint8_t *>(address);
+				size = status.st_size;
+			}
+		}
+		close(descriptor);
+#endif
+	}
+	MappedFile(const MappedFile &) = delete;
+	auto operator=(const MappedFile &)->MappedFile & = delete;
+	~MappedFile() {
+#ifdef _WIN32
+		if (data)
+			UnmapViewOfFile(data);
+		if (mapping)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+#else
+		if (data)
+			munmap(const_cast<std::uint8_t *>(data), size);
+#endif
+	}
+	auto Data() const {
+		return data;
+	}
+	auto Size() const {
+		return size;
+	}
+};
+
+auto FrameBytes(const mvsf::Format &format) {
+	auto bytes = std::size_t{ 0 };
+	for (auto plane = 0; plane < format.Planes; ++plane)
+		bytes += static_cast<std::size_t>(format.PlaneWidth(plane)) * format.PlaneHeight(plane) * sizeof(float);
+	return bytes;
+}
+
+auto RawFrame(const MappedFile &file, const mvsf::Format &format, int n) {
+	auto frame = mvsf::FrameView{};
+	auto pointer = file.Data() + FrameBytes(format) * n;
+	for (auto plane = 0; plane < format.Planes; ++plane) {
+		frame.Planes[plane] = pointer;
+		frame.Pitches[plane] = static_cast<std::intptr_t>(format.PlaneWidth(plane) * sizeof(float));
+		pointer += frame.Pitches[plane] * format.PlaneHeight(plane);
+	}
+	return frame;
+}
+
+auto WriteFrame(std::FILE *output, const mvsf::Format &format, mvsf::FrameView frame) {
+	for (auto plane = 0; plane < format.Planes; ++plane)
+		for (auto y = 0; y < format.PlaneHeight(plane); ++y)
+			std::fwrite(frame.Planes[plane] + y * frame.Pitches[plane], sizeof(float), format.PlaneWidth(plane), output);
+}
+
+class Stopwatch final {
+	using Clock = std::chrono::steady_clock;
+	Clock::time_point start = Clock::now();
+public:
+	auto Lap() {
+		auto now = Clock::now();
+		auto elapsed = std::chrono::duration<double>{ now - start }.count();
+		start = now;
+		return elapsed;
+	}
+};
+
+// the super frames of the window around the current frame, slot n % size holds frame n.
+struct SuperWindow final {
+	std::vector<mvsf::FrameBuffer> Frames;
+	std::vector<int> Indices;
+	SuperWindow(const mvsf::Format &format, int size) :Indices(size, -1) {
+		for (auto i = 0; i < size; ++i)
+			Frames.emplace_back(format);
+	}
+	auto Slot(int n) -> mvsf::FrameBuffer & {
+		return Frames[n % Frames.size()];
+	}
+};
+
+auto Run(const Options &options) {
+	auto file = MappedFile{ options.Input };
+	auto frameBytes = FrameBytes(options.Format);
+	if (file.Data() == nullptr || file.Size() < frameBytes) {
+		std::fprintf(stderr, "raw-pipeline: cannot map %s or it holds less than one frame.\n", options.Input.c_str());
+		return EXIT_FAILURE;
+	}
+	auto frames = static_cast<int>(file.Size() / frameBytes);
+	if (options.Frames > 0)
+		frames = std::min(frames, options.Frames);
+	auto output = static_cast<std::FILE *>(nullptr);
+	if (!options.Output.empty() && (output = std::fopen(options.Output.c_str(), "wb")) == nullptr) {
+		std::fprintf(stderr, "raw-pipeline: cannot open %s.\n", options.Output.c_str());
+		return EXIT_FAILURE;
+	}
+	auto radius = options.Radius;
+	auto super = mvsf::Super{ options.Format, options.Super };
+	auto analyze = mvsf::Analyze{ super.GetInfo(), options.Analyze };
+	auto window = SuperWindow{ super.GetSuperFormat(), 2 * radius + 1 };
+	auto vectors = std::vector<std::vector<std::int32_t>>(2 * radius, std::vector<std::int32_t>(analyze.GetVectorSize()));
+	auto pVectors = std::vector<const std::int32_t *>(2 * radius);
+	auto references = std::vector<mvsf::FrameView>(2 * radius);
+	auto destination = mvsf::FrameBuffer{ options.Format };
+	analyze.WriteDefault(1, true, vectors[0].data());
+	auto degrain = std::optional<mvsf::Degrain>{};
+	auto compensate = std::optional<mvsf::Compensate>{};
+	if (options.Compensate) {
+		auto parameters = mvsf::CompensateParameters{};
+		parameters.ThSAD = options.ThSAD.value_or(parameters.ThSAD);
+		compensate.emplace(super.GetInfo(), vectors[0].data(), parameters);
+	}
+	else {
+		auto parameters = mvsf::DegrainParameters{};
+		if (options.ThSAD)
+			parameters.ThSAD = { *options.ThSAD, *options.ThSAD, *options.ThSAD };
+		degrain.emplace(super.GetInfo(), vectors[0].data(), radius, parameters);
+	}
+	auto Prepare = [&](int n) -> mvsf::FrameView {
+		auto &slot = window.Slot(n);
+		if (window.Indices[n % window.Indices.size()] != n) {
+			super.Process(RawFrame(file, options.Format, n), slot.WritableView());
+			window.Indices[n % window.Indices.size()] = n;
+		}
+		return slot.View();
+	};
+	auto superTime = 0., analyzeTime = 0., filterTime = 0.;
+	auto total = Stopwatch{};
+	for (auto n = 0; n < frames; ++n) {
+		auto watch = Stopwatch{};
+		auto source = Prepare(n);
+		for (auto r = 0; r < radius; ++r) {
+			if (!options.Compensate && n + r + 1 < frames)
+				references[2 * r] = Prepare(n + r + 1);
+			if (n - r - 1 >= 0)
+				references[2 * r + 1] = Prepare(n - r - 1);
+		}
+		superTime += watch.Lap();
+		for (auto r = 0; r < radius; ++r) {
+			auto backward = !options.Compensate && n + r + 1 < frames;
+			auto forward = n - r - 1 >= 0;
+			if (backward)
+				analyze.Search(source, references[2 * r], r + 1, true, vectors[2 * r].data());
+			if (forward)
+				analyze.Search(source, references[2 * r + 1], r + 1, false, vectors[2 * r + 1].data());
+			pVectors[2 * r] = backward ? vectors[2 * r].data() : nullptr;
+			pVectors[2 * r + 1] = forward ? vectors[2 * r + 1].data() : nullptr;
+		}
+		analyzeTime += watch.Lap();
+		if (compensate)
+			compensate->Process(source, references[1], pVectors[1], destination.WritableView());
+		else
+			degrain->Process(RawFrame(file, options.Format, n), references.data(), pVectors.data(), destination.WritableView());
+		filterTime += watch.Lap();
+		if (output)
+			WriteFrame(output, options.Format, destination.View());
+	}
+	auto elapsed = total.Lap();
+	if (output)
+		std::fclose(output);
+	std::printf("%d frames of %dx%d in %.3f s, %.2f fps\n", frames, options.Format.Width, options.Format.Height, elapsed, frames / elapsed);
+	std::printf("  super      %9.3f ms/frame\n", superTime * 1000 / frames);
+	std::printf("  analyze    %9.3f ms/frame\n", analyzeTime * 1000 / frames);
+	std::printf("  %-10s %9.3f ms/frame\n", options.Compensate ? "compensate" : "degrain", filterTime * 1000 / frames);
+	return EXIT_SUCCESS;
+}
+
+}
+
+auto main(int argc, char **argv)->int {
+	auto options = ParseOptions(argc, argv);
+	if (!options) {
+		std::fputs(Usage, stderr);
+		return EXIT_FAILURE;
+	}
+	try {
+		return Run(*options);
+	}
+	catch (std::exception &e) {
+		std::fprintf(stderr, "raw-pipeline: %s\n", e.what());
+		return EXIT_FAILURE;
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "DCT.hpp"
+#include "GroupOfPlanes.h"
+
+// everything one Analyze or Recalculate frame searches with besides the frames themselves.
+struct AnalysisContext final {
+	std::unique_ptr<GroupOfPlanes> vectorFields;
+	std::unique_ptr<MVGroupOfFrames> pSrcGOF;
+	std::unique_ptr<MVGroupOfFrames> pRefGOF;
+	std::unique_ptr<DCTClass> DCTc;
+};
+
+// contexts are lent to one frame at a time and kept for the next, so a filter ends up with one context per thread
+// that runs it concurrently and nothing is allocated once every thread has had its first frame.
+class AnalysisContextPool final {
+	std::function<AnalysisContext *()> Create;
+	std::mutex lock;
+	std::vector<std::unique_ptr<AnalysisContext>> idle;
+public:
+	class Lease final {
+		AnalysisContextPool *pool;
+		std::unique_ptr<AnalysisContext> context;
+	public:
+		Lease(AnalysisContextPool *_pool, std::unique_ptr<AnalysisContext> _context) :pool{ _pool }, context{ std::move(_context) } {}
+		Lease(Lease &&) = delete;
+		Lease(const Lease &) = delete;
+		auto &operator=(Lease &&) = delete;
+		auto &operator=(const Lease &) = delete;
+		~Lease() {
+			auto guard = std::lock_guard{ pool->lock };
+			pool->idle.push_back(std::move(context));
+		}
+		auto operator->() const {
+			return context.get();
+		}
+		auto get() const {
+			return context.get();
+		}
+	};
+	explicit AnalysisContextPool(std::function<AnalysisContext *()> _Create) :Create{ std::move(_Create) } {}
+	AnalysisContextPool(AnalysisContextPool &&) = delete;
+	AnalysisContextPool(const AnalysisContextPool &) = delete;
+	auto &operator=(AnalysisContextPool &&) = delete;
+	auto &operator=(const AnalysisContextPool &) = delete;
+	auto Acquire() -> Lease {
+		{
+			auto guard = std::lock_guard{ lock };
+			if (!idle.empty()) {
+				auto context = std::move(idle.back());
+				idle.pop_back();
+				return Lease{ this, std::move(context) };
+			}
+		}
+		return Lease{ this, std::unique_ptr<AnalysisContext>{ Create() } };
+	}
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MVSF_X86 1
+#include <immintrin.h>
+#define MVSF_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define MVSF_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#endif
+
+enum class InstructionSet : std::int32_t {
+	C,
+	SSE2,
+	AVX2,
+	AVX512
+};
+
+inline auto DetectInstructionSet() {
+#if defined(MVSF_X86)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		return InstructionSet::AVX512;
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return InstructionSet::AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return InstructionSet::SSE2;
+#endif
+	return InstructionSet::C;
+}
+
+inline auto GetInstructionSet() {
+	static const auto DetectedInstructionSet = DetectInstructionSet();
+	return DetectedInstructionSet;
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include "VSHelper.h"
+#include "CopyCode.hpp"
+#include "MVClip.hpp"
+#include "MVFrame.h"
+#include "Overlap.h"
+
+// how Compensate puts a frame together from the blocks of a vector frame, shared by the filter and the core library.
+// a block whose SAD reaches thSAD is taken from the source super frame instead of the reference, and the part of the
+// frame the blocks don't cover from scSrc. pPlanes and pSrcPlanes are the planes of the reference and source super
+// frames, the chroma ones are null when the super clip has no chroma. DstTemp is only touched with overlap.
+inline void CompensateBlocks(const MVClipDicks& mvClip, const MVClipBalls& balls, int32_t nSuperModeYUV, int32_t time256, int32_t fieldShift, double thSAD,
+	uint8_t* const* pDst, const int32_t* nDstPitches, MVPlane* const* pPlanes, MVPlane* const* pSrcPlanes, const uint8_t* const* scSrc, const int32_t* scPitches,
+	COPYFunction BLITLUMA, COPYFunction BLITCHROMA, OverlapsFunction OVERSLUMA, OverlapsFunction OVERSCHROMA, ToPixelsFunction ToPixels,
+	OverlapWindows* OverWins, OverlapWindows* OverWinsUV, uint8_t* const* DstTemp, int32_t dstTempPitch, int32_t dstTempPitchUV) {
+	const int32_t nWidth = mvClip.GetWidth();
+	const int32_t nHeight = mvClip.GetHeight();
+	const int32_t xRatioUV = mvClip.GetXRatioUV();
+	const int32_t yRatioUV = mvClip.GetYRatioUV();
+	const int32_t nOverlapX = mvClip.GetOverlapX();
+	const int32_t nOverlapY = mvClip.GetOverlapY();
+	const int32_t nBlkSizeX = mvClip.GetBlkSizeX();
+	const int32_t nBlkSizeY = mvClip.GetBlkSizeY();
+	const int32_t nBlkX = mvClip.GetBlkX();
+	const int32_t nBlkY = mvClip.GetBlkY();
+	const int32_t nPel = mvClip.GetPel();
+	const int32_t nHPadding = mvClip.GetHPadding();
+	const int32_t nVPadding = mvClip.GetVPadding();
+	int32_t nWidth_B = nBlkX * (nBlkSizeX - nOverlapX) + nOverlapX;
+	int32_t nHeight_B = nBlkY * (nBlkSizeY - nOverlapY) + nOverlapY;
+	int32_t ySubUV = (yRatioUV == 2) ? 1 : 0;
+	int32_t xSubUV = (xRatioUV == 2) ? 1 : 0;
+	int32_t blx, bly;
+	if (nOverlapX == 0 && nOverlapY == 0) {
+		uint8_t* pDstCur[3] = { pDst[0], pDst[1], pDst[2] };
+		for (int32_t by = 0; by < nBlkY; ++by) {
+			int32_t xx = 0;
+			for (int32_t bx = 0; bx < nBlkX; ++bx) {
+				int32_t i = by * nBlkX + bx;
+				auto& block = balls[0][i];
+				blx = static_cast<int32_t>(block.GetX() * nPel + static_cast<int64_t>(block.GetMV().x) * time256 / 256);
+				bly = static_cast<int32_t>(block.GetY() * nPel + static_cast<int64_t>(block.GetMV().y) * time256 / 256 + fieldShift);
+				if (block.GetSAD() < thSAD) {
+					BLITLUMA(pDstCur[0] + xx, nDstPitches[0], pPlanes[0]->GetPointer(blx, bly), pPlanes[0]->GetPitch());
+					if (pPlanes[1]) BLITCHROMA(pDstCur[1] + (xx >> xSubUV), nDstPitches[1], pPlanes[1]->GetPointer(blx >> xSubUV, bly >> ySubUV), pPlanes[1]->GetPitch());
+					if (pPlanes[2]) BLITCHROMA(pDstCur[2] + (xx >> xSubUV), nDstPitches[2], pPlanes[2]->GetPointer(blx >> xSubUV, bly >> ySubUV), pPlanes[2]->GetPitch());
+				}
+				else {
+					int32_t blxsrc = bx * nBlkSizeX * nPel;
+					int32_t blysrc = by * nBlkSizeY * nPel + fieldShift;
+					BLITLUMA(pDstCur[0] + xx, nDstPitches[0], pSrcPlanes[0]->GetPointer(blxsrc, blysrc), pSrcPlanes[0]->GetPitch());
+					if (pSrcPlanes[1]) BLITCHROMA(pDstCur[1] + (xx >> xSubUV), nDstPitches[1], pSrcPlanes[1]->GetPointer(blxsrc >> xSubUV, blysrc >> ySubUV), pSrcPlanes[1]->GetPitch());
+					if (pSrcPlanes[2]) BLITCHROMA(pDstCur[2] + (xx >> xSubUV), nDstPitches[2], pSrcPlanes[2]->GetPointer(blxsrc >> xSubUV, blysrc >> ySubUV), pSrcPlanes[2]->GetPitch());
+				}
+				xx += nBlkSizeX * 4;
+			}
+			pDstCur[0] += nBlkSizeY * nDstPitches[0];
+			if (nSuperModeYUV & UVPLANES) {
+				pDstCur[1] += (nBlkSizeY >> ySubUV) * nDstPitches[1];
+				pDstCur[2] += (nBlkSizeY >> ySubUV) * nDstPitches[2];
+			}
+		}
+	}
+	else {
+		uint8_t* pDstTemp = DstTemp[0];
+		uint8_t* pDstTempU = DstTemp[1];
+		uint8_t* pDstTempV = DstTemp[2];
+		std::memset(DstTemp[0], 0, nHeight_B * dstTempPitch);
+		if (pPlanes[1])
+			std::memset(DstTemp[1], 0, (nHeight_B >> ySubUV) * dstTempPitchUV);
+		if (pPlanes[2])
+			std::memset(DstTemp[2], 0, (nHeight_B >> ySubUV) * dstTempPitchUV);
+		for (int32_t by = 0; by < nBlkY; by++) {
+			int32_t wby = ((by + nBlkY - 3) / (nBlkY - 2)) * 3;
+			int32_t xx = 0;
+			for (int32_t bx = 0; bx < nBlkX; bx++) {
+				int32_t wbx = (bx + nBlkX - 3) / (nBlkX - 2);
+				auto winOver = OverWins->GetWindow(wby + wbx);
+				auto winOverUV = static_cast<double*>(nullptr);
+				if (nSuperModeYUV & UVPLANES)
+					winOverUV = OverWinsUV->GetWindow(wby + wbx);
+				int32_t i = by * nBlkX + bx;
+				auto& block = balls[0][i];
+				blx = static_cast<int32_t>(block.GetX() * nPel + static_cast<int64_t>(block.GetMV().x) * time256 / 256);
+				bly = static_cast<int32_t>(block.GetY() * nPel + static_cast<int64_t>(block.GetMV().y) * time256 / 256 + fieldShift);
+				if (block.GetSAD() < thSAD) {
+					OVERSLUMA(pDstTemp + xx * 2, dstTempPitch, pPlanes[0]->GetPointer(blx, bly), pPlanes[0]->GetPitch(), winOver, nBlkSizeX);
+					if (pPlanes[1]) OVERSCHROMA(pDstTempU + (xx >> xSubUV) * 2, dstTempPitchUV, pPlanes[1]->GetPointer(blx >> xSubUV, bly >> ySubUV), pPlanes[1]->GetPitch(), winOverUV, nBlkSizeX >> xSubUV);
+					if (pPlanes[2]) OVERSCHROMA(pDstTempV + (xx >> xSubUV) * 2, dstTempPitchUV, pPlanes[2]->GetPointer(blx >> xSubUV, bly >> ySubUV), pPlanes[2]->GetPitch(), winOverUV, nBlkSizeX >> xSubUV);
+				}
+				else {
+					int32_t blxsrc = bx * (nBlkSizeX - nOverlapX) * nPel;
+					int32_t blysrc = by * (nBlkSizeY - nOverlapY) * nPel + fieldShift;
+					OVERSLUMA(pDstTemp + xx * 2, dstTempPitch, pSrcPlanes[0]->GetPointer(blxsrc, blysrc), pSrcPlanes[0]->GetPitch(), winOver, nBlkSizeX);
+					if (pSrcPlanes[1]) OVERSCHROMA(pDstTempU + (xx >> xSubUV) * 2, dstTempPitchUV, pSrcPlanes[1]->GetPointer(blxsrc >> xSubUV, blysrc >> ySubUV), pSrcPlanes[1]->GetPitch(), winOverUV, nBlkSizeX >> xSubUV);
+					if (pSrcPlanes[2]) OVERSCHROMA(pDstTempV + (xx >> xSubUV) * 2, dstTempPitchUV, pSrcPlanes[2]->GetPointer(blxsrc >> xSubUV, blysrc >> ySubUV), pSrcPlanes[2]->GetPitch(), winOverUV, nBlkSizeX >> xSubUV);
+				}
+				xx += (nBlkSizeX - nOverlapX) * 4;
+			}
+			pDstTemp += dstTempPitch * (nBlkSizeY - nOverlapY);
+			if (nSuperModeYUV & UVPLANES) {
+				pDstTempU += dstTempPitchUV * ((nBlkSizeY - nOverlapY) >> ySubUV);
+				pDstTempV += dstTempPitchUV * ((nBlkSizeY - nOverlapY) >> ySubUV);
+			}
+		}
+		ToPixels(pDst[0], nDstPitches[0], DstTemp[0], dstTempPitch, nWidth_B, nHeight_B);
+		if (pPlanes[1])
+			ToPixels(pDst[1], nDstPitches[1], DstTemp[1], dstTempPitchUV, nWidth_B >> xSubUV, nHeight_B >> ySubUV);
+		if (pPlanes[2])
+			ToPixels(pDst[2], nDstPitches[2], DstTemp[2], dstTempPitchUV, nWidth_B >> xSubUV, nHeight_B >> ySubUV);
+	}
+	if (nWidth_B < nWidth) {
+		vs_bitblt(pDst[0] + nWidth_B * 4, nDstPitches[0],
+			scSrc[0] + (nWidth_B + nHPadding) * 4 + nVPadding * scPitches[0], scPitches[0],
+			(nWidth - nWidth_B) * 4, nHeight_B);
+		for (int32_t i = 1; i < 3; ++i)
+			if (pPlanes[i])
+				vs_bitblt(pDst[i] + (nWidth_B >> xSubUV) * 4, nDstPitches[i],
+					scSrc[i] + ((nWidth_B >> xSubUV) + (nHPadding >> xSubUV)) * 4 + (nVPadding >> ySubUV) * scPitches[i], scPitches[i],
+					((nWidth - nWidth_B) >> xSubUV) * 4, nHeight_B >> ySubUV);
+	}
+	if (nHeight_B < nHeight) {
+		vs_bitblt(pDst[0] + nHeight_B * nDstPitches[0], nDstPitches[0],
+			scSrc[0] + nHPadding * 4 + (nHeight_B + nVPadding) * scPitches[0], scPitches[0],
+			nWidth * 4, nHeight - nHeight_B);
+		for (int32_t i = 1; i < 3; ++i)
+			if (pPlanes[i])
+				vs_bitblt(pDst[i] + (nHeight_B >> ySubUV) * nDstPitches[i], nDstPitches[i],
+					scSrc[i] + nHPadding * 4 + ((nHeight_B + nVPadding) >> ySubUV) * scPitches[i], scPitches[i],
+					(nWidth >> xSubUV) * 4, (nHeight - nHeight_B) >> ySubUV);
+	}
+}
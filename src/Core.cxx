@@ -0,0 +1,509 @@
+#include "Core.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include "VSHelper.h"
+#include "MVFrame.h"
+#include "MVInterface.h"
+#include "GroupOfPlanes.h"
+#include "DCTFFTW.hpp"
+#include "MVClip.hpp"
+#include "CompensateBlocks.hpp"
+#include "DegrainBlocks.hpp"
+#include "FilterParameters.hpp"
+#include "KernelRegistry.hpp"
+#include "Overlap.h"
+#include "ThreadPool.hpp"
+
+// the library's only translation unit, the algorithms are the ones the filters run and the parameters take the same
+// path through FilterParameters.hpp, only the frame bookkeeping around them is redone on plain pointers.
+
+namespace mvsf {
+
+namespace {
+
+constexpr MVPlaneSet PlaneSets[] = { YPLANE, UPLANE, VPLANE };
+
+auto Fail(const std::string &message) {
+	throw std::runtime_error{ message };
+}
+
+auto Pitch(FrameView frame, int plane) {
+	return static_cast<int32_t>(frame.Pitches[plane]);
+}
+
+auto Pitch(WritableFrameView frame, int plane) {
+	return static_cast<int32_t>(frame.Pitches[plane]);
+}
+
+// the header of a vector frame, checked the way MVClipDicks checks the first frame of a vector clip.
+auto ReadHeader(const std::int32_t *vectors, const char *filter) -> const MVAnalysisData & {
+	if (vectors == nullptr || vectors[1] != MotionMagicKey)
+		Fail(std::string{ filter } + ": Invalid motion vector clip.");
+	if (vectors[2] != MVAnalysisDataVersion)
+		Fail(std::string{ filter } + ": incompatible version of motion vector clip.");
+	return *reinterpret_cast<const MVAnalysisData *>(vectors + 1);
+}
+
+auto CheckThSCD1(double thSCD1, const char *filter) {
+	constexpr auto maxSAD = 8. * 8. * 255.;
+	if (thSCD1 > maxSAD)
+		Fail(std::string{ filter } + ": thscd1 can be at most " + std::to_string(maxSAD) + ".");
+}
+
+auto CheckSuper(const SuperInfo &super, const MVAnalysisData &header, const char *filter) {
+	if (header.GetWidth() != super.Source.Width || header.GetHeight() != super.Source.Height)
+		Fail(std::string{ filter } + ": wrong source or super clip frame size.");
+}
+
+auto MakeGroupOfFrames(const SuperInfo &super) {
+	auto xRatioUV = 1 << super.Source.SubSamplingW;
+	auto yRatioUV = 1 << super.Source.SubSamplingH;
+	return std::make_unique<MVGroupOfFrames>(super.Levels, super.Source.Width, super.Source.Height, super.Pel, super.HPad, super.VPad, super.ModeYUV, xRatioUV, yRatioUV);
+}
+
+auto UpdateGroupOfFrames(MVGroupOfFrames *gof, int32_t nMode, FrameView frame) {
+	auto Plane = [&](auto plane) {
+		return const_cast<uint8_t *>(frame.Planes[plane]);
+	};
+	gof->Update(nMode, Plane(0), Pitch(frame, 0), Plane(1), Pitch(frame, 1), Plane(2), Pitch(frame, 2));
+}
+
+}
+
+FrameBuffer::FrameBuffer(const Format &_format) :format{ _format } {
+	constexpr auto Alignment = std::size_t{ 64 / sizeof(float) };
+	std::size_t offsets[3] = {};
+	auto total = std::size_t{ 0 };
+	for (auto plane = 0; plane < format.Planes; ++plane) {
+		auto stride = (static_cast<std::size_t>(format.PlaneWidth(plane)) + Alignment - 1) / Alignment * Alignment;
+		offsets[plane] = total;
+		total += stride * format.PlaneHeight(plane);
+		view.Pitches[plane] = static_cast<std::intptr_t>(stride * sizeof(float));
+	}
+	samples.resize(total + Alignment);
+	auto misalignment = reinterpret_cast<std::uintptr_t>(samples.data()) / sizeof(float) % Alignment;
+	auto base = samples.data() + (misalignment ? Alignment - misalignment : 0);
+	for (auto plane = 0; plane < format.Planes; ++plane)
+		view.Planes[plane] = reinterpret_cast<std::uint8_t *>(base + offsets[plane]);
+}
+
+struct Super::Implementation final {
+	SuperInfo info;
+	Format superFormat;
+	int32_t sharp;
+	int32_t rfilter;
+	std::unique_ptr<MVGroupOfFrames> pSrcGOF;
+};
+
+Super::Super(const Format &source, const SuperParameters &parameters) :implementation{ std::make_unique<Implementation>() } {
+	auto &d = *implementation;
+	if (auto error = CheckSuperParameters(parameters))
+		Fail(std::string{ "Super: " } + error);
+	if ((source.Planes != 1 && source.Planes != 3) || source.SubSamplingW < 0 || source.SubSamplingW > 1 || source.SubSamplingH < 0 || source.SubSamplingH > 1 || source.Width <= 0 || source.Height <= 0)
+		Fail("Super: input clip must be single precision fp, with constant dimensions.");
+	auto resolved = parameters;
+	auto [nSuperWidth, nSuperHeight] = ResolveSuperParameters(resolved, source.Width, source.Height, 1 << source.SubSamplingW, 1 << source.SubSamplingH);
+	d.info.Source = source;
+	d.info.HPad = resolved.HPad;
+	d.info.VPad = resolved.VPad;
+	d.info.Pel = resolved.Pel;
+	d.info.Levels = resolved.Levels;
+	d.info.ModeYUV = resolved.Chroma && source.Planes == 3 ? YUVPLANES : YPLANE;
+	d.sharp = resolved.Sharp;
+	d.rfilter = resolved.RFilter;
+	d.superFormat = source;
+	d.superFormat.Width = nSuperWidth;
+	d.superFormat.Height = nSuperHeight;
+	d.pSrcGOF = MakeGroupOfFrames(d.info);
+}
+
+Super::Super(Super &&) noexcept = default;
+auto Super::operator=(Super &&) noexcept -> Super & = default;
+Super::~Super() = default;
+
+auto Super::GetInfo() const -> const SuperInfo & {
+	return implementation->info;
+}
+
+auto Super::GetSuperFormat() const -> const Format & {
+	return implementation->superFormat;
+}
+
+auto Super::Process(FrameView source, WritableFrameView destination) -> void {
+	auto &d = *implementation;
+	auto nModeYUV = static_cast<MVPlaneSet>(d.info.ModeYUV);
+	for (auto plane = 0; plane < d.superFormat.Planes; ++plane)
+		for (auto y = 0; y < d.superFormat.PlaneHeight(plane); ++y)
+			std::memset(destination.Planes[plane] + y * destination.Pitches[plane], 0, d.superFormat.PlaneWidth(plane) * sizeof(float));
+	d.pSrcGOF->Update(nModeYUV, destination.Planes[0], Pitch(destination, 0), destination.Planes[1], Pitch(destination, 1), destination.Planes[2], Pitch(destination, 2));
+	for (auto plane = 0; plane < d.info.Source.Planes; ++plane)
+		d.pSrcGOF->SetPlane(source.Planes[plane], Pitch(source, plane), PlaneSets[plane]);
+	d.pSrcGOF->Reduce(nModeYUV, d.rfilter);
+	d.pSrcGOF->Pad(nModeYUV);
+	d.pSrcGOF->Refine(nModeYUV, d.sharp);
+}
+
+struct Analyze::Implementation final {
+	MVAnalysisData analysisData;
+	int32_t headerSize;
+	int32_t nModeYUV;
+	SearchType searchType;
+	SearchType searchTypeCoarse;
+	int32_t nSearchParam;
+	int32_t nPelSearch;
+	double nLambda;
+	double lsad;
+	int32_t pnew;
+	int32_t plevel;
+	bool global;
+	int32_t pglobal;
+	int32_t pzero;
+	double badSAD;
+	int32_t badrange;
+	bool meander;
+	bool tryMany;
+	double staticRatio;
+	double prepass;
+	std::unique_ptr<ThreadPool> wavefrontPool;
+	std::unique_ptr<GroupOfPlanes> vectorFields;
+	std::unique_ptr<MVGroupOfFrames> pSrcGOF;
+	std::unique_ptr<MVGroupOfFrames> pRefGOF;
+	std::unique_ptr<DCTClass> DCTc;
+	auto WriteHeader(int delta, bool backward, std::int32_t *vectors) {
+		if (delta <= 0)
+			Fail("Analyze: delta must be positive.");
+		auto header = analysisData;
+		header.nDeltaFrame = delta;
+		header.isBackward = backward;
+		header.nMotionFlags = backward ? (header.nMotionFlags | MOTION_IS_BACKWARD) : (header.nMotionFlags & ~MOTION_IS_BACKWARD);
+		std::memcpy(vectors, &headerSize, sizeof(int32_t));
+		std::memcpy(vectors + 1, &header, sizeof(header));
+		return vectors + headerSize / sizeof(int32_t);
+	}
+};
+
+Analyze::Analyze(const SuperInfo &super, const AnalyzeParameters &parameters) :implementation{ std::make_unique<Implementation>() } {
+	auto &d = *implementation;
+	auto resolved = parameters;
+	ResolveAnalyzeParameters(resolved);
+	if (auto error = CheckAnalyzeParameters(resolved, super.Source.SubSamplingW, super.Source.SubSamplingH))
+		Fail(std::string{ "Analyze: " } + error);
+	auto blksize = resolved.BlkSize;
+	auto blksizev = *resolved.BlkSizeV;
+	auto chroma = resolved.Chroma && super.Source.Planes == 3;
+	auto overlap = resolved.Overlap;
+	auto overlapv = *resolved.OverlapV;
+	auto dctmode = resolved.DCT;
+	d.nLambda = *resolved.Lambda;
+	d.lsad = *resolved.LSAD;
+	d.plevel = *resolved.PLevel;
+	d.global = *resolved.Global;
+	d.pnew = *resolved.PNew;
+	d.pzero = *resolved.PZero;
+	d.pglobal = resolved.PGlobal;
+	d.badSAD = resolved.BadSAD;
+	d.badrange = resolved.BadRange;
+	d.meander = resolved.Meander;
+	d.tryMany = resolved.TryMany;
+	d.staticRatio = resolved.StaticTh;
+	d.prepass = resolved.Prepass;
+	d.searchType = SearchTypes[resolved.Search];
+	d.searchTypeCoarse = SearchTypes[resolved.SearchCoarse];
+	d.nSearchParam = SearchParameter(d.searchType, resolved.SearchParam);
+	d.nModeYUV = chroma ? YUVPLANES : YPLANE;
+	if ((d.nModeYUV & super.ModeYUV) != d.nModeYUV)
+		Fail("Analyze: super clip does not contain needed color data.");
+	d.lsad = d.lsad * (blksize * blksizev) / 64;
+	d.badSAD = d.badSAD * (blksize * blksizev) / 64;
+	auto &a = d.analysisData;
+	a = {};
+	a.nMagicKey = MotionMagicKey;
+	a.nVersion = MVAnalysisDataVersion;
+	a.nBlkSizeX = blksize;
+	a.nBlkSizeY = blksizev;
+	a.nOverlapX = overlap;
+	a.nOverlapY = overlapv;
+	a.nDeltaFrame = 1;
+	a.nMotionFlags = chroma ? MOTION_USE_CHROMA_MOTION : 0;
+	a.xRatioUV = 1 << super.Source.SubSamplingW;
+	a.yRatioUV = 1 << super.Source.SubSamplingH;
+	a.nWidth = super.Source.Width;
+	a.nHeight = super.Source.Height;
+	a.nPel = super.Pel;
+	a.nHPadding = super.HPad;
+	a.nVPadding = super.VPad;
+	a.nBlkX = (a.nWidth - a.nOverlapX) / (a.nBlkSizeX - a.nOverlapX);
+	a.nBlkY = (a.nHeight - a.nOverlapY) / (a.nBlkSizeY - a.nOverlapY);
+	int32_t nWidth_B = (a.nBlkSizeX - a.nOverlapX) * a.nBlkX + a.nOverlapX;
+	int32_t nHeight_B = (a.nBlkSizeY - a.nOverlapY) * a.nBlkY + a.nOverlapY;
+	int32_t nLevelsMax = 0;
+	while (((nWidth_B >> nLevelsMax) - a.nOverlapX) / (a.nBlkSizeX - a.nOverlapX) > 0 &&
+		((nHeight_B >> nLevelsMax) - a.nOverlapY) / (a.nBlkSizeY - a.nOverlapY) > 0)
+		nLevelsMax++;
+	a.nLvCount = resolved.Levels > 0 ? resolved.Levels : nLevelsMax + resolved.Levels;
+	if (a.nLvCount < 1 || a.nLvCount > nLevelsMax)
+		Fail("Analyze: invalid number of levels.");
+	if (a.nLvCount > super.Levels)
+		Fail("Analyze: super clip has " + std::to_string(super.Levels) + " levels. Analyze needs " + std::to_string(a.nLvCount) + " levels.");
+	d.nPelSearch = resolved.PelSearch > 0 ? resolved.PelSearch : a.nPel;
+	d.headerSize = std::max(4 + sizeof(a), std::size_t{ 256 });
+	if (resolved.Wavefront > 1)
+		d.wavefrontPool = std::make_unique<ThreadPool>(resolved.Wavefront - 1);
+	d.vectorFields = std::make_unique<GroupOfPlanes>(a.nBlkSizeX, a.nBlkSizeY, a.nLvCount, a.nPel, a.nMotionFlags, a.nOverlapX, a.nOverlapY, a.nBlkX, a.nBlkY, a.xRatioUV, a.yRatioUV, 0);
+	d.pSrcGOF = MakeGroupOfFrames(super);
+	d.pRefGOF = MakeGroupOfFrames(super);
+	if (dctmode != 0)
+		d.DCTc = CreateDCT(blksize, blksizev, dctmode);
+}
+
+Analyze::Analyze(Analyze &&) noexcept = default;
+auto Analyze::operator=(Analyze &&) noexcept -> Analyze & = default;
+Analyze::~Analyze() = default;
+
+auto Analyze::GetVectorSize() const -> std::size_t {
+	return implementation->headerSize / sizeof(int32_t) + implementation->vectorFields->GetArraySize();
+}
+
+auto Analyze::Search(FrameView superSource, FrameView superReference, int delta, bool backward, std::int32_t *vectors) -> void {
+	auto &d = *implementation;
+	auto pDst = d.WriteHeader(delta, backward, vectors);
+	UpdateGroupOfFrames(d.pSrcGOF.get(), d.nModeYUV, superSource);
+	UpdateGroupOfFrames(d.pRefGOF.get(), d.nModeYUV, superReference);
+	d.vectorFields->SearchMVs(d.pSrcGOF.get(), d.pRefGOF.get(), d.searchType, d.nSearchParam, d.nPelSearch, d.nLambda, d.lsad, d.pnew, d.plevel, d.global, pDst, nullptr, 0, d.DCTc.get(), d.pzero, d.pglobal, d.badSAD, d.badrange, d.meander, nullptr, d.tryMany, d.searchTypeCoarse, d.staticRatio, d.prepass, d.wavefrontPool.get());
+}
+
+auto Analyze::WriteDefault(int delta, bool backward, std::int32_t *vectors) -> void {
+	auto &d = *implementation;
+	d.vectorFields->WriteDefaultToArray(d.WriteHeader(delta, backward, vectors));
+}
+
+struct Degrain::Implementation final {
+	SuperInfo super;
+	int32_t radius;
+	std::vector<std::array<double, 3>> thSAD;
+	int32_t YUVplanes;
+	double nLimit[3];
+	std::vector<MVClipDicks> mvClips;
+	std::vector<MVClipBalls> balls;
+	std::vector<std::unique_ptr<MVGroupOfFrames>> pRefGOF;
+	DegrainGeometry geometry;
+	OverlapsFunction OVERS[3];
+	DenoiseFunction DEGRAIN[3];
+	bool process[3];
+	std::unique_ptr<OverlapWindows> OverWins[2];
+	std::vector<uint8_t> DstTemp;
+	std::vector<uint8_t> tmpBlock;
+};
+
+Degrain::Degrain(const SuperInfo &super, const std::int32_t *sample, int radius, const DegrainParameters &parameters) :implementation{ std::make_unique<Implementation>() } {
+	auto &d = *implementation;
+	if (radius <= 0)
+		Fail("Degrain: radius must be positive.");
+	if (auto error = CheckDegrainParameters(parameters))
+		Fail(std::string{ "Degrain: " } + error);
+	for (auto i = 0; i < 3; ++i)
+		d.nLimit[i] = parameters.Limit ? (*parameters.Limit)[i] : std::numeric_limits<double>::infinity();
+	d.YUVplanes = DegrainPlanes(parameters);
+	auto &header = ReadHeader(sample, "Degrain");
+	CheckThSCD1(parameters.ThSCD1, "Degrain");
+	CheckSuper(super, header, "Degrain");
+	d.super = super;
+	d.radius = radius;
+	d.thSAD = DegrainThSAD(parameters, radius);
+	for (auto r = 0; r < 2 * radius; ++r)
+		d.mvClips.emplace_back(header, parameters.ThSCD1, parameters.ThSCD2);
+	for (auto r = 0; r < 2 * radius; ++r) {
+		d.balls.emplace_back(&d.mvClips[r], nullptr);
+		d.pRefGOF.push_back(MakeGroupOfFrames(super));
+	}
+	for (auto &SADArray : d.thSAD) {
+		SADArray[0] = SADArray[0] * d.mvClips[0].GetThSCD1() / parameters.ThSCD1;
+		SADArray[1] = SADArray[2] = SADArray[1] * d.mvClips[0].GetThSCD1() / parameters.ThSCD1;
+	}
+	d.geometry = MakeDegrainGeometry(header, super.Source.SubSamplingW, super.Source.SubSamplingH);
+	auto &g = d.geometry;
+	d.process[0] = !!(d.YUVplanes & YPLANE);
+	d.process[1] = !!(d.YUVplanes & UPLANE & super.ModeYUV);
+	d.process[2] = !!(d.YUVplanes & VPLANE & super.ModeYUV);
+	if (g.nOverlapX[0] || g.nOverlapY[0]) {
+		d.OverWins[0] = std::make_unique<OverlapWindows>(g.nBlkSizeX[0], g.nBlkSizeY[0], g.nOverlapX[0], g.nOverlapY[0]);
+		if (super.Source.Planes == 3)
+			d.OverWins[1] = std::make_unique<OverlapWindows>(g.nBlkSizeX[1], g.nBlkSizeY[1], g.nOverlapX[1], g.nOverlapY[1]);
+		d.DstTemp.resize(g.dstTempPitch * g.nHeight[0]);
+		d.tmpBlock.resize(g.nBlkSizeX[0] * 4 * g.nBlkSizeY[0]);
+	}
+	d.OVERS[0] = GetKernel<KernelKind::Overlaps>(g.nBlkSizeX[0], g.nBlkSizeY[0]);
+	d.DEGRAIN[0] = GetKernel<KernelKind::Degrain>(g.nBlkSizeX[0], g.nBlkSizeY[0]);
+	d.OVERS[1] = d.OVERS[2] = GetKernel<KernelKind::Overlaps>(g.nBlkSizeX[1], g.nBlkSizeY[1]);
+	d.DEGRAIN[1] = d.DEGRAIN[2] = GetKernel<KernelKind::Degrain>(g.nBlkSizeX[1], g.nBlkSizeY[1]);
+}
+
+Degrain::Degrain(Degrain &&) noexcept = default;
+auto Degrain::operator=(Degrain &&) noexcept -> Degrain & = default;
+Degrain::~Degrain() = default;
+
+auto Degrain::Process(FrameView source, const FrameView *superReferences, const std::int32_t *const *vectors, WritableFrameView destination) -> void {
+	auto &d = *implementation;
+	const auto radius = d.radius;
+	auto isUsable = std::vector<bool>(2 * radius);
+	auto pPlanes = std::array{ std::vector<MVPlane *>(2 * radius), std::vector<MVPlane *>(2 * radius), std::vector<MVPlane *>(2 * radius) };
+	for (auto r = 0; r < 2 * radius; ++r) {
+		isUsable[r] = false;
+		if (vectors[r]) {
+			d.balls[r].Update(vectors[r]);
+			isUsable[r] = d.balls[r].IsUsable();
+		}
+		if (isUsable[r]) {
+			UpdateGroupOfFrames(d.pRefGOF[r].get(), d.YUVplanes, superReferences[r]);
+			for (auto plane = 0; plane < d.super.Source.Planes; ++plane)
+				if (d.YUVplanes & PlaneSets[plane])
+					pPlanes[plane][r] = d.pRefGOF[r]->GetFrame(0)->GetPlane(PlaneSets[plane]);
+		}
+	}
+	auto pBalls = std::vector<const MVClipBalls *>(2 * radius);
+	for (auto r = 0; r < 2 * radius; ++r)
+		pBalls[r] = &d.balls[r];
+	auto &g = d.geometry;
+	for (auto plane = 0; plane < d.super.Source.Planes; ++plane) {
+		auto pDst = destination.Planes[plane];
+		auto pSrc = source.Planes[plane];
+		if (!d.process[plane]) {
+			vs_bitblt(pDst, Pitch(destination, plane), pSrc, Pitch(source, plane), g.nWidth[plane] * 4, g.nHeight[plane]);
+			continue;
+		}
+		DegrainPlane(g, plane, radius, pDst, Pitch(destination, plane), pSrc, Pitch(source, plane),
+			pBalls.data(), isUsable, pPlanes[plane].data(), d.thSAD,
+			d.DEGRAIN[plane], d.OVERS[plane], d.OverWins[plane ? 1 : 0].get(), ToPixels<double, float>, LimitChanges_C<float>, d.nLimit[plane],
+			d.DstTemp.data(), d.tmpBlock.data());
+	}
+}
+
+struct Compensate::Implementation final {
+	SuperInfo super;
+	MVClipDicks mvClip;
+	MVClipBalls balls;
+	bool scBehavior;
+	double thSAD;
+	int32_t time256;
+	int32_t dstTempPitch;
+	int32_t dstTempPitchUV;
+	std::unique_ptr<OverlapWindows> OverWins;
+	std::unique_ptr<OverlapWindows> OverWinsUV;
+	OverlapsFunction OVERSLUMA;
+	OverlapsFunction OVERSCHROMA;
+	COPYFunction BLITLUMA;
+	COPYFunction BLITCHROMA;
+	std::unique_ptr<MVGroupOfFrames> pRefGOF;
+	std::unique_ptr<MVGroupOfFrames> pSrcGOF;
+	std::vector<uint8_t> DstTemp[3];
+};
+
+Compensate::Compensate(const SuperInfo &super, const std::int32_t *sample, const CompensateParameters &parameters) :implementation{ std::make_unique<Implementation>() } {
+	auto &d = *implementation;
+	if (parameters.Time < 0. || parameters.Time > 100.)
+		Fail("Compensate: time must be between 0.0 and 100.0 (inclusive).");
+	auto &header = ReadHeader(sample, "Compensate");
+	CheckThSCD1(parameters.ThSCD1, "Compensate");
+	CheckSuper(super, header, "Compensate");
+	d.super = super;
+	d.mvClip = MVClipDicks{ header, parameters.ThSCD1, parameters.ThSCD2 };
+	d.balls = MVClipBalls{ &d.mvClip, nullptr };
+	d.scBehavior = parameters.SCBehavior;
+	d.thSAD = parameters.ThSAD * d.mvClip.GetThSCD1() / parameters.ThSCD1;
+	d.time256 = static_cast<int32_t>(parameters.Time * 256. / 100.);
+	auto nBlkSizeX = header.GetBlkSizeX();
+	auto nBlkSizeY = header.GetBlkSizeY();
+	auto xRatioUV = header.GetXRatioUV();
+	auto yRatioUV = header.GetYRatioUV();
+	d.dstTempPitch = ((header.GetWidth() + 15) / 16) * 16 * 4 * 2;
+	d.dstTempPitchUV = (((header.GetWidth() / xRatioUV) + 15) / 16) * 16 * 4 * 2;
+	if (header.GetOverlapX() || header.GetOverlapY()) {
+		d.OverWins = std::make_unique<OverlapWindows>(nBlkSizeX, nBlkSizeY, header.GetOverlapX(), header.GetOverlapY());
+		d.DstTemp[0].resize(d.dstTempPitch * header.GetHeight());
+		if (super.ModeYUV & UVPLANES) {
+			d.OverWinsUV = std::make_unique<OverlapWindows>(nBlkSizeX / xRatioUV, nBlkSizeY / yRatioUV, header.GetOverlapX() / xRatioUV, header.GetOverlapY() / yRatioUV);
+			d.DstTemp[1].resize(d.dstTempPitchUV * header.GetHeight());
+			d.DstTemp[2].resize(d.dstTempPitchUV * header.GetHeight());
+		}
+	}
+	d.OVERSLUMA = GetKernel<KernelKind::Overlaps>(nBlkSizeX, nBlkSizeY);
+	d.BLITLUMA = GetKernel<KernelKind::Copy>(nBlkSizeX, nBlkSizeY);
+	d.OVERSCHROMA = GetKernel<KernelKind::Overlaps>(nBlkSizeX / xRatioUV, nBlkSizeY / yRatioUV);
+	d.BLITCHROMA = GetKernel<KernelKind::Copy>(nBlkSizeX / xRatioUV, nBlkSizeY / yRatioUV);
+	d.pRefGOF = MakeGroupOfFrames(super);
+	d.pSrcGOF = MakeGroupOfFrames(super);
+}
+
+Compensate::Compensate(Compensate &&) noexcept = default;
+auto Compensate::operator=(Compensate &&) noexcept -> Compensate & = default;
+Compensate::~Compensate() = default;
+
+auto Compensate::Process(FrameView superSource, FrameView superReference, const std::int32_t *vectors, WritableFrameView destination) -> void {
+	auto &d = *implementation;
+	uint8_t *pDst[3] = {};
+	const uint8_t *pRef[3] = {}, *pSrc[3] = {};
+	int32_t nDstPitches[3] = {}, nRefPitches[3] = {}, nSrcPitches[3] = {};
+	auto usable = false;
+	if (vectors) {
+		d.balls.Update(vectors);
+		usable = d.balls.IsUsable();
+	}
+	const auto &mvClip = d.mvClip;
+	const int32_t nWidth = mvClip.GetWidth();
+	const int32_t nHeight = mvClip.GetHeight();
+	const int32_t xRatioUV = mvClip.GetXRatioUV();
+	const int32_t yRatioUV = mvClip.GetYRatioUV();
+	const int32_t nSuperModeYUV = d.super.ModeYUV;
+	const int32_t nHPadding = mvClip.GetHPadding();
+	const int32_t nVPadding = mvClip.GetVPadding();
+	if (usable) {
+		for (auto i = 0; i < d.super.Source.Planes; i++) {
+			pDst[i] = destination.Planes[i];
+			nDstPitches[i] = Pitch(destination, i);
+			pSrc[i] = superSource.Planes[i];
+			nSrcPitches[i] = Pitch(superSource, i);
+			pRef[i] = superReference.Planes[i];
+			nRefPitches[i] = Pitch(superReference, i);
+		}
+		UpdateGroupOfFrames(d.pRefGOF.get(), nSuperModeYUV, superReference);
+		UpdateGroupOfFrames(d.pSrcGOF.get(), nSuperModeYUV, superSource);
+		MVPlane *pPlanes[3] = {};
+		MVPlane *pSrcPlanes[3] = {};
+		for (auto plane = 0; plane < d.super.Source.Planes; ++plane) {
+			pPlanes[plane] = d.pRefGOF->GetFrame(0)->GetPlane(PlaneSets[plane]);
+			pSrcPlanes[plane] = d.pSrcGOF->GetFrame(0)->GetPlane(PlaneSets[plane]);
+		}
+		const uint8_t *scSrc[3] = {};
+		int32_t scPitches[3] = {};
+		for (auto i = 0; i < 3; i++) {
+			scSrc[i] = d.scBehavior ? pSrc[i] : pRef[i];
+			scPitches[i] = d.scBehavior ? nSrcPitches[i] : nRefPitches[i];
+		}
+		uint8_t *DstTemp[3] = { d.DstTemp[0].data(), d.DstTemp[1].data(), d.DstTemp[2].data() };
+		CompensateBlocks(mvClip, d.balls, nSuperModeYUV, d.time256, 0, d.thSAD, pDst, nDstPitches, pPlanes, pSrcPlanes, scSrc, scPitches,
+			d.BLITLUMA, d.BLITCHROMA, d.OVERSLUMA, d.OVERSCHROMA, ToPixels<double, float>, d.OverWins.get(), d.OverWinsUV.get(), DstTemp, d.dstTempPitch, d.dstTempPitchUV);
+	}
+	else {
+		auto frame = !d.scBehavior && vectors ? superReference : superSource;
+		for (auto i = 0; i < d.super.Source.Planes; i++) {
+			pDst[i] = destination.Planes[i];
+			nDstPitches[i] = Pitch(destination, i);
+			pSrc[i] = frame.Planes[i];
+			nSrcPitches[i] = Pitch(frame, i);
+		}
+		int32_t nOffset[3];
+		nOffset[0] = nHPadding * 4 + nVPadding * nSrcPitches[0];
+		nOffset[1] = nHPadding * 4 / xRatioUV + (nVPadding / yRatioUV) * nSrcPitches[1];
+		nOffset[2] = nOffset[1];
+		vs_bitblt(pDst[0], nDstPitches[0], pSrc[0] + nOffset[0], nSrcPitches[0], nWidth * 4, nHeight);
+		if (nSuperModeYUV & UVPLANES) {
+			vs_bitblt(pDst[1], nDstPitches[1], pSrc[1] + nOffset[1], nSrcPitches[1], nWidth * 4 / xRatioUV, nHeight / yRatioUV);
+			vs_bitblt(pDst[2], nDstPitches[2], pSrc[2] + nOffset[2], nSrcPitches[2], nWidth * 4 / xRatioUV, nHeight / yRatioUV);
+		}
+	}
+}
+
+}
@@ -0,0 +1,196 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// Super, Analyze, Degrain and Compensate on plain single precision planes, without VapourSynth. this header is all
+// a program linking libmvsf-core sees. a frame is up to three planes of floats, laid out the way VapourSynth hands
+// them out: every plane has its own rows, pitches are in bytes. the parameters mean what the arguments of the filters
+// of the same names mean, and default to the same values. errors in the parameters throw std::runtime_error with the
+// message the filter would have set.
+//
+// every object keeps the scratch memory of the frame it works on, so one object must not process two frames at the
+// same time. run one set of objects per thread instead, they are cheap next to the frames.
+namespace mvsf {
+
+struct Format final {
+	int Width = 0;
+	int Height = 0;
+	int SubSamplingW = 1;
+	int SubSamplingH = 1;
+	// 1 for gray, 3 otherwise.
+	int Planes = 3;
+	auto PlaneWidth(int plane) const {
+		return plane ? Width >> SubSamplingW : Width;
+	}
+	auto PlaneHeight(int plane) const {
+		return plane ? Height >> SubSamplingH : Height;
+	}
+};
+
+struct FrameView final {
+	std::array<const std::uint8_t *, 3> Planes = {};
+	std::array<std::intptr_t, 3> Pitches = {};
+};
+
+struct WritableFrameView final {
+	std::array<std::uint8_t *, 3> Planes = {};
+	std::array<std::intptr_t, 3> Pitches = {};
+	operator FrameView() const {
+		return { { Planes[0], Planes[1], Planes[2] }, Pitches };
+	}
+};
+
+// owns the planes of one frame, each row starts on a 64 byte boundary.
+class FrameBuffer final {
+	Format format;
+	std::vector<float> samples;
+	WritableFrameView view;
+public:
+	explicit FrameBuffer(const Format &_format);
+	FrameBuffer(FrameBuffer &&) = default;
+	FrameBuffer(const FrameBuffer &) = delete;
+	auto operator=(FrameBuffer &&)->FrameBuffer & = default;
+	auto operator=(const FrameBuffer &)->FrameBuffer & = delete;
+	auto GetFormat() const -> const Format & {
+		return format;
+	}
+	auto View() const -> FrameView {
+		return view;
+	}
+	auto WritableView() -> WritableFrameView {
+		return view;
+	}
+};
+
+struct SuperParameters final {
+	int HPad = 8;
+	int VPad = 8;
+	int Pel = 2;
+	int Levels = 0;
+	bool Chroma = true;
+	int Sharp = 2;
+	int RFilter = 2;
+};
+
+// what Super leaves in the frame props of its first frame, all a consumer of super frames needs to know.
+struct SuperInfo final {
+	Format Source;
+	int HPad = 0;
+	int VPad = 0;
+	int Pel = 0;
+	int Levels = 0;
+	int ModeYUV = 0;
+};
+
+class Super final {
+	struct Implementation;
+	std::unique_ptr<Implementation> implementation;
+public:
+	Super(const Format &source, const SuperParameters &parameters = {});
+	Super(Super &&) noexcept;
+	auto operator=(Super &&) noexcept -> Super &;
+	~Super();
+	auto GetInfo() const -> const SuperInfo &;
+	// the format of the super frames, the planes of the pyramid stacked the way mvsf.Super stacks them.
+	auto GetSuperFormat() const -> const Format &;
+	auto Process(FrameView source, WritableFrameView destination) -> void;
+};
+
+// parameters whose defaults depend on TrueMotion or the block size are left empty to get those defaults.
+struct AnalyzeParameters final {
+	int BlkSize = 8;
+	std::optional<int> BlkSizeV;
+	int Levels = 0;
+	int Search = 4;
+	int SearchCoarse = 3;
+	int SearchParam = 2;
+	int PelSearch = 0;
+	bool Chroma = true;
+	bool TrueMotion = true;
+	std::optional<double> Lambda;
+	std::optional<double> LSAD;
+	std::optional<int> PLevel;
+	std::optional<bool> Global;
+	std::optional<int> PNew;
+	std::optional<int> PZero;
+	int PGlobal = 0;
+	int Overlap = 0;
+	std::optional<int> OverlapV;
+	int DCT = 0;
+	double BadSAD = 10000.;
+	int BadRange = 24;
+	bool Meander = true;
+	int Wavefront = 0;
+	bool TryMany = false;
+	double StaticTh = 0.;
+	double Prepass = 0.;
+};
+
+class Analyze final {
+	struct Implementation;
+	std::unique_ptr<Implementation> implementation;
+public:
+	Analyze(const SuperInfo &super, const AnalyzeParameters &parameters = {});
+	Analyze(Analyze &&) noexcept;
+	auto operator=(Analyze &&) noexcept -> Analyze &;
+	~Analyze();
+	// the number of int32 a vector frame takes, one row of the frames mvsf.Analyze returns.
+	auto GetVectorSize() const -> std::size_t;
+	// searches the vectors of source into reference, which is delta frames after source when backward and delta
+	// frames before it otherwise. vectors receives the header and the vectors just like a row of mvsf.Analyze.
+	auto Search(FrameView superSource, FrameView superReference, int delta, bool backward, std::int32_t *vectors) -> void;
+	// the vector frame of a reference past either end of the clip, one that no consumer will use.
+	auto WriteDefault(int delta, bool backward, std::int32_t *vectors) -> void;
+};
+
+struct DegrainParameters final {
+	std::array<double, 3> ThSAD = { 400., 400., 400. };
+	// empty for ThSAD.
+	std::optional<std::array<double, 3>> ThSAD2;
+	int Plane = 4;
+	std::optional<std::array<double, 3>> Limit;
+	double ThSCD1 = 400.;
+	double ThSCD2 = 130.;
+};
+
+class Degrain final {
+	struct Implementation;
+	std::unique_ptr<Implementation> implementation;
+public:
+	// sample is any vector frame written by an Analyze on super, it pins the block layout all later vectors must have.
+	Degrain(const SuperInfo &super, const std::int32_t *sample, int radius, const DegrainParameters &parameters = {});
+	Degrain(Degrain &&) noexcept;
+	auto operator=(Degrain &&) noexcept -> Degrain &;
+	~Degrain();
+	// references and vectors hold 2 * radius entries, backward and forward interleaved by distance: entry 2r is the
+	// backward search against frame n + r + 1, entry 2r + 1 the forward search against frame n - r - 1. that is the
+	// order mvsf.Degrain picks the rows of mvmulti in, not the order of mvmulti itself, whose rows run
+	// [b radius .. b1, f1 .. f radius]. references are super frames, null vectors mark a reference past either end of
+	// the clip, that reference is never read.
+	auto Process(FrameView source, const FrameView *superReferences, const std::int32_t *const *vectors, WritableFrameView destination) -> void;
+};
+
+struct CompensateParameters final {
+	bool SCBehavior = true;
+	double ThSAD = 10000.;
+	double Time = 100.;
+	double ThSCD1 = 400.;
+	double ThSCD2 = 130.;
+};
+
+class Compensate final {
+	struct Implementation;
+	std::unique_ptr<Implementation> implementation;
+public:
+	Compensate(const SuperInfo &super, const std::int32_t *sample, const CompensateParameters &parameters = {});
+	Compensate(Compensate &&) noexcept;
+	auto operator=(Compensate &&) noexcept -> Compensate &;
+	~Compensate();
+	// superReference is the frame the vectors point into, vectors are null when it lies past either end of the clip.
+	auto Process(FrameView superSource, FrameView superReference, const std::int32_t *vectors, WritableFrameView destination) -> void;
+};
+
+}
@@ -13,4 +13,12 @@ struct DCTClass {
 	auto operator=(const DCTClass &)->decltype(*this) = default;
 	virtual ~DCTClass() = default;
 	virtual auto DCTBytes2D(const std::uint8_t *, int, std::uint8_t *, int)->void = 0;
+	// count blocks side by side, each step bytes to the right of the previous one, transformed in one go. the
+	// coefficients of every block are written one after another with a pitch of sizex floats.
+	virtual auto DCTBlocks2D(const std::uint8_t *srcp, int src_pitch, int count, int step, std::uint8_t *dctp)->void {
+		for (auto i = 0; i < count; ++i)
+			DCTBytes2D(srcp + i * step, src_pitch, dctp + i * sizey * sizex * sizeof(float), sizex * sizeof(float));
+	}
+	// a new transform of the same size and mode with its own buffers, for use on another thread.
+	virtual auto Clone() const->DCTClass * = 0;
 };
@@ -1,18 +1,79 @@
 #pragma once
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <tuple>
+#include <utility>
 #include "fftw3.h"
 #include "DCT.hpp"
+#include "DCTNative.hpp"
 #include "Interface.vxx"
 
+// single precision DCT plans shared by every transform of the process, one per block size and batch length.
+// planning with FFTW_MEASURE is slow, so the wisdom is read from and written back to the file named by
+// MVSF_FFTW_WISDOM when it is set, and workers that start from that file get their plans at once. plans live as
+// long as the process and are executed through the new-array interface, which FFTW allows from any thread.
+class FFTWPlanCache final {
+	std::mutex lock;
+	std::map<std::tuple<int, int, int>, fftwf_plan> plans;
+	const char *wisdomFile = std::getenv("MVSF_FFTW_WISDOM");
+	FFTWPlanCache() {
+		if (wisdomFile)
+			fftwf_import_wisdom_from_filename(wisdomFile);
+	}
+public:
+	static auto &Instance() {
+		static auto cache = new FFTWPlanCache{};
+		return *cache;
+	}
+	// count blocks stored one after another are transformed by a single call of the plan.
+	auto Get(int sizex, int sizey, int count = 1) {
+		auto guard = std::lock_guard{ lock };
+		auto &plan = plans[{ sizex, sizey, count }];
+		if (!plan) {
+			// planning with FFTW_MEASURE overwrites its arrays, so it gets its own.
+			auto size2d = sizex * sizey;
+			auto src = reinterpret_cast<float *>(fftwf_malloc(sizeof(float) * size2d * count));
+			auto dst = reinterpret_cast<float *>(fftwf_malloc(sizeof(float) * size2d * count));
+			if (count == 1)
+				plan = fftwf_plan_r2r_2d(sizey, sizex, src, dst, FFTW_REDFT10, FFTW_REDFT10, FFTW_MEASURE);
+			else {
+				const int n[] = { sizey, sizex };
+				const fftwf_r2r_kind kinds[] = { FFTW_REDFT10, FFTW_REDFT10 };
+				plan = fftwf_plan_many_r2r(2, n, count, src, nullptr, 1, size2d, dst, nullptr, 1, size2d, kinds, FFTW_MEASURE);
+			}
+			fftwf_free(src);
+			fftwf_free(dst);
+			if (wisdomFile)
+				fftwf_export_wisdom_to_filename(wisdomFile);
+		}
+		return plan;
+	}
+};
+
 class DCTFFTW final :public DCTClass {
-	static inline auto g_fftw_plans_mutex = std::mutex{};
-	self(fSrc, static_cast<double *>(nullptr));
-	self(dctplan, static_cast<fftw_plan>(nullptr));
-	self(fSrcDCT, static_cast<double *>(nullptr));
-	self(dctshift, 0);
-	self(dctshift0, 0);
+	self(fSrc, static_cast<float *>(nullptr));
+	self(dctplan, static_cast<fftwf_plan>(nullptr));
+	self(fSrcDCT, static_cast<float *>(nullptr));
+	self(scale0, 0.f);
+	self(scale, 0.f);
+	// every level of the search has its own row length, so the batch arrays are sized for the longest row seen and
+	// the plans of all lengths are kept, a frame after the first allocates nothing and never takes the cache's lock.
+	self(batchCapacity, 0);
+	self(fBatch, static_cast<float *>(nullptr));
+	self(fBatchDCT, static_cast<float *>(nullptr));
+	std::map<int, fftwf_plan> batchplans;
+	auto Normalize(const float *srcDCT, std::uint8_t *dctp, int dct_pitch) {
+		for (auto j = 0; j < sizey; ++j) {
+			auto dstp = reinterpret_cast<float *>(dctp + dct_pitch * j);
+			for (auto i = 0; i < sizex; ++i)
+				dstp[i] = srcDCT[j * sizex + i] * scale;
+		}
+		reinterpret_cast<float *>(dctp)[0] = srcDCT[0] * scale0;
+	}
 public:
 	DCTFFTW() = delete;
 	DCTFFTW(int _sizex, int _sizey, int _dctmode) {
@@ -20,67 +81,60 @@ public:
 		sizey = _sizey;
 		dctmode = _dctmode;
 		auto size2d = sizey * sizex;
-		auto cursize = 1;
-		while (cursize < size2d) {
+		auto dctshift = 0;
+		for (auto cursize = 1; cursize < size2d; cursize <<= 1)
 			++dctshift;
-			cursize <<= 1;
-		}
-		dctshift0 = dctshift + 2;
-		fSrc = reinterpret_cast<double *>(fftw_malloc(sizeof(double) * size2d));
-		fSrcDCT = reinterpret_cast<double *>(fftw_malloc(sizeof(double) * size2d));
-		g_fftw_plans_mutex.lock();
-		dctplan = fftw_plan_r2r_2d(sizey, sizex, fSrc, fSrcDCT, FFTW_REDFT10, FFTW_REDFT10, FFTW_ESTIMATE);
-		g_fftw_plans_mutex.unlock();
+		scale0 = static_cast<float>(0.5 / std::pow(2, dctshift + 2));
+		scale = static_cast<float>(0.70710678118654752440084436210485 / std::pow(2, dctshift));
+		fSrc = reinterpret_cast<float *>(fftwf_malloc(sizeof(float) * size2d));
+		fSrcDCT = reinterpret_cast<float *>(fftwf_malloc(sizeof(float) * size2d));
+		dctplan = FFTWPlanCache::Instance().Get(sizex, sizey);
 	}
 	DCTFFTW(DCTFFTW &&) = delete;
 	DCTFFTW(const DCTFFTW &&) = delete;
 	auto &operator=(DCTFFTW &&) = delete;
 	auto &operator=(const DCTFFTW &) = delete;
 	~DCTFFTW() override {
-		g_fftw_plans_mutex.lock();
-		fftw_destroy_plan(dctplan);
-		g_fftw_plans_mutex.unlock();
-		fftw_free(fSrc);
-		fftw_free(fSrcDCT);
+		fftwf_free(fSrc);
+		fftwf_free(fSrcDCT);
+		fftwf_free(fBatch);
+		fftwf_free(fBatchDCT);
+	}
+	auto Clone() const->DCTClass * override {
+		return new DCTFFTW(sizex, sizey, dctmode);
 	}
 	auto DCTBytes2D(const std::uint8_t *srcp, int src_pitch, std::uint8_t *dctp, int dct_pitch)->void override {
-		auto Bytes2Float = [&]() {
-			auto floatpitch = sizex;
-			auto realdata = fSrc;
-			for (auto j = 0; j < sizey; ++j) {
-				for (auto i = 0; i < sizex; ++i) {
-					auto real_srcp = reinterpret_cast<const float *>(srcp);
-					realdata[i] = real_srcp[i];
-				}
-				srcp += src_pitch;
-				realdata += floatpitch;
-			}
-		};
-		auto Float2Bytes = [&]() {
-			constexpr auto coeff = 0.70710678118654752440084436210485;
-			auto dstp = reinterpret_cast<float *>(dctp);
-			auto realdata = fSrcDCT;
-			dct_pitch /= sizeof(float);
-			auto floatpitch = sizex;
-			auto f = realdata[0] * 0.5;
-			dstp[0] = static_cast<float>(f / std::pow(2, dctshift0));
-			for (auto i = 1; i < sizex; ++i) {
-				f = realdata[i] * coeff;
-				dstp[i] = static_cast<float>(f / std::pow(2, dctshift));
-			}
-			dstp += dct_pitch;
-			realdata += floatpitch;
-			for (auto j = 1; j < sizey; ++j) {
-				for (auto i = 0; i < sizex; ++i) {
-					f = realdata[i] * coeff;
-					dstp[i] = static_cast<float>(f / std::pow(2, dctshift));
-				}
-				dstp += dct_pitch;
-				realdata += floatpitch;
-			}
-		};
-		Bytes2Float();
-		fftw_execute_r2r(dctplan, fSrc, fSrcDCT);
-		Float2Bytes();
+		for (auto j = 0; j < sizey; ++j)
+			std::copy_n(reinterpret_cast<const float *>(srcp + src_pitch * j), sizex, fSrc + j * sizex);
+		fftwf_execute_r2r(dctplan, fSrc, fSrcDCT);
+		Normalize(fSrcDCT, dctp, dct_pitch);
 	}
-};
\ No newline at end of file
+	// the blocks are gathered into one array so that a single many-transform plan covers all of them.
+	auto DCTBlocks2D(const std::uint8_t *srcp, int src_pitch, int count, int step, std::uint8_t *dctp)->void override {
+		auto size2d = sizey * sizex;
+		if (count > batchCapacity) {
+			fftwf_free(fBatch);
+			fftwf_free(fBatchDCT);
+			fBatch = reinterpret_cast<float *>(fftwf_malloc(sizeof(float) * size2d * count));
+			fBatchDCT = reinterpret_cast<float *>(fftwf_malloc(sizeof(float) * size2d * count));
+			batchCapacity = count;
+		}
+		auto &batchplan = batchplans[count];
+		if (!batchplan)
+			batchplan = FFTWPlanCache::Instance().Get(sizex, sizey, count);
+		for (auto k = 0; k < count; ++k)
+			for (auto j = 0; j < sizey; ++j)
+				std::copy_n(reinterpret_cast<const float *>(srcp + k * step + src_pitch * j), sizex, fBatch + k * size2d + j * sizex);
+		fftwf_execute_r2r(batchplan, fBatch, fBatchDCT);
+		auto dct_pitch = static_cast<int>(sizex * sizeof(float));
+		for (auto k = 0; k < count; ++k)
+			Normalize(fBatchDCT + k * size2d, dctp + k * size2d * sizeof(float), dct_pitch);
+	}
+};
+
+// the native transform where it covers the block size, FFTW for the rest.
+inline auto CreateDCT(int sizex, int sizey, int dctmode) -> std::unique_ptr<DCTClass> {
+	if (DCTNative::Supports(sizex, sizey))
+		return std::make_unique<DCTNative>(sizex, sizey, dctmode);
+	return std::make_unique<DCTFFTW>(sizex, sizey, dctmode);
+}
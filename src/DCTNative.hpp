@@ -0,0 +1,167 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <vector>
+#include "CPUFeatures.hpp"
+#include "DCT.hpp"
+
+// the same DCT-II as DCTFFTW (FFTW_REDFT10 in both directions, then the same normalization) written as two matrix
+// passes in float. every output row of a pass is a weighted sum of the rows of its input, so both passes come down
+// to acc[x] += weight * row[x] over whole rows, which vectorizes for every width that is a multiple of the vector.
+struct DCTNativeTables final {
+	int sizex;
+	int sizey;
+	std::vector<float> basisx; // basisx[x * sizex + u], weight of input column x in output column u
+	std::vector<float> basisy; // basisy[v * sizey + y], weight of input row y in output row v
+	std::vector<float> scale;  // scale[v * sizex + u], the normalization of DCTFFTW folded into one factor
+};
+
+using DCTNativeFunction = void(*)(const DCTNativeTables &, const std::uint8_t *, int, std::uint8_t *, int, float *);
+
+static inline auto AccumulateRow_C(float *acc, const float *row, float weight, int width) {
+	for (auto x = 0; x < width; ++x)
+		acc[x] += weight * row[x];
+}
+
+// rows holds sizey rows of sizex floats for the result of the first pass.
+static auto DCT2D_C(const DCTNativeTables &t, const std::uint8_t *srcp, int src_pitch, std::uint8_t *dctp, int dct_pitch, float *rows) {
+	for (auto y = 0; y < t.sizey; ++y) {
+		auto pSrc = reinterpret_cast<const float *>(srcp + src_pitch * y);
+		auto pRow = rows + y * t.sizex;
+		for (auto u = 0; u < t.sizex; ++u)
+			pRow[u] = 0.f;
+		for (auto x = 0; x < t.sizex; ++x)
+			AccumulateRow_C(pRow, &t.basisx[x * t.sizex], pSrc[x], t.sizex);
+	}
+	for (auto v = 0; v < t.sizey; ++v) {
+		auto pDst = reinterpret_cast<float *>(dctp + dct_pitch * v);
+		for (auto u = 0; u < t.sizex; ++u)
+			pDst[u] = 0.f;
+		for (auto y = 0; y < t.sizey; ++y)
+			AccumulateRow_C(pDst, rows + y * t.sizex, t.basisy[v * t.sizey + y], t.sizex);
+		for (auto u = 0; u < t.sizex; ++u)
+			pDst[u] *= t.scale[v * t.sizex + u];
+	}
+}
+
+#if defined(MVSF_X86)
+
+// one row of nVectors vectors stays in registers while the rows of the input are folded into it.
+template<int nVectors>
+static auto DCT2D_SSE2(const DCTNativeTables &t, const std::uint8_t *srcp, int src_pitch, std::uint8_t *dctp, int dct_pitch, float *rows) {
+	__m128 acc[nVectors];
+	for (auto y = 0; y < t.sizey; ++y) {
+		auto pSrc = reinterpret_cast<const float *>(srcp + src_pitch * y);
+		for (auto i = 0; i < nVectors; ++i)
+			acc[i] = _mm_setzero_ps();
+		for (auto x = 0; x < nVectors * 4; ++x) {
+			auto w = _mm_set1_ps(pSrc[x]);
+			for (auto i = 0; i < nVectors; ++i)
+				acc[i] = _mm_add_ps(acc[i], _mm_mul_ps(w, _mm_loadu_ps(&t.basisx[x * t.sizex + i * 4])));
+		}
+		for (auto i = 0; i < nVectors; ++i)
+			_mm_storeu_ps(rows + y * t.sizex + i * 4, acc[i]);
+	}
+	for (auto v = 0; v < t.sizey; ++v) {
+		for (auto i = 0; i < nVectors; ++i)
+			acc[i] = _mm_setzero_ps();
+		for (auto y = 0; y < t.sizey; ++y) {
+			auto w = _mm_set1_ps(t.basisy[v * t.sizey + y]);
+			for (auto i = 0; i < nVectors; ++i)
+				acc[i] = _mm_add_ps(acc[i], _mm_mul_ps(w, _mm_loadu_ps(rows + y * t.sizex + i * 4)));
+		}
+		auto pDst = reinterpret_cast<float *>(dctp + dct_pitch * v);
+		for (auto i = 0; i < nVectors; ++i)
+			_mm_storeu_ps(pDst + i * 4, _mm_mul_ps(acc[i], _mm_loadu_ps(&t.scale[v * t.sizex + i * 4])));
+	}
+}
+
+template<int nVectors>
+MVSF_TARGET_AVX2 static auto DCT2D_AVX2(const DCTNativeTables &t, const std::uint8_t *srcp, int src_pitch, std::uint8_t *dctp, int dct_pitch, float *rows) {
+	__m256 acc[nVectors];
+	for (auto y = 0; y < t.sizey; ++y) {
+		auto pSrc = reinterpret_cast<const float *>(srcp + src_pitch * y);
+		for (auto i = 0; i < nVectors; ++i)
+			acc[i] = _mm256_setzero_ps();
+		for (auto x = 0; x < nVectors * 8; ++x) {
+			auto w = _mm256_set1_ps(pSrc[x]);
+			for (auto i = 0; i < nVectors; ++i)
+				acc[i] = _mm256_fmadd_ps(w, _mm256_loadu_ps(&t.basisx[x * t.sizex + i * 8]), acc[i]);
+		}
+		for (auto i = 0; i < nVectors; ++i)
+			_mm256_storeu_ps(rows + y * t.sizex + i * 8, acc[i]);
+	}
+	for (auto v = 0; v < t.sizey; ++v) {
+		for (auto i = 0; i < nVectors; ++i)
+			acc[i] = _mm256_setzero_ps();
+		for (auto y = 0; y < t.sizey; ++y) {
+			auto w = _mm256_set1_ps(t.basisy[v * t.sizey + y]);
+			for (auto i = 0; i < nVectors; ++i)
+				acc[i] = _mm256_fmadd_ps(w, _mm256_loadu_ps(rows + y * t.sizex + i * 8), acc[i]);
+		}
+		auto pDst = reinterpret_cast<float *>(dctp + dct_pitch * v);
+		for (auto i = 0; i < nVectors; ++i)
+			_mm256_storeu_ps(pDst + i * 8, _mm256_mul_ps(acc[i], _mm256_loadu_ps(&t.scale[v * t.sizex + i * 8])));
+	}
+}
+
+#endif
+
+class DCTNative final :public DCTClass {
+	DCTNativeTables tables;
+	std::vector<float> rows;
+	DCTNativeFunction Transform;
+public:
+	// the matrix passes cost sizex + sizey multiply-adds per coefficient, past 32 FFTW wins.
+	static auto Supports(int _sizex, int _sizey) {
+		return _sizex <= 32 && _sizey <= 32;
+	}
+	DCTNative(int _sizex, int _sizey, int _dctmode) {
+		sizex = _sizex;
+		sizey = _sizey;
+		dctmode = _dctmode;
+		auto size2d = sizey * sizex;
+		auto dctshift = 0;
+		for (auto cursize = 1; cursize < size2d; cursize <<= 1)
+			++dctshift;
+		auto Basis = [](int n, int i, int k) {
+			return static_cast<float>(2 * std::cos(std::numbers::pi * (2 * i + 1) * k / (2 * n)));
+		};
+		tables.sizex = sizex;
+		tables.sizey = sizey;
+		tables.basisx.resize(sizex * sizex);
+		for (auto x = 0; x < sizex; ++x)
+			for (auto u = 0; u < sizex; ++u)
+				tables.basisx[x * sizex + u] = Basis(sizex, x, u);
+		tables.basisy.resize(sizey * sizey);
+		for (auto v = 0; v < sizey; ++v)
+			for (auto y = 0; y < sizey; ++y)
+				tables.basisy[v * sizey + y] = Basis(sizey, y, v);
+		tables.scale.assign(size2d, static_cast<float>(std::numbers::sqrt2 / 2 / std::pow(2, dctshift)));
+		tables.scale[0] = static_cast<float>(0.5 / std::pow(2, dctshift + 2));
+		rows.resize(size2d);
+		Transform = DCT2D_C;
+#if defined(MVSF_X86)
+		if (GetInstructionSet() >= InstructionSet::AVX2 && sizex % 8 == 0)
+			Transform = sizex == 8 ? DCT2D_AVX2<1> : sizex == 16 ? DCT2D_AVX2<2> : DCT2D_AVX2<4>;
+		else if (GetInstructionSet() >= InstructionSet::SSE2 && sizex % 4 == 0)
+			Transform = sizex == 4 ? DCT2D_SSE2<1> : sizex == 8 ? DCT2D_SSE2<2> : sizex == 16 ? DCT2D_SSE2<4> : DCT2D_SSE2<8>;
+#endif
+	}
+	DCTNative(DCTNative &&) = delete;
+	DCTNative(const DCTNative &) = delete;
+	auto &operator=(DCTNative &&) = delete;
+	auto &operator=(const DCTNative &) = delete;
+	auto Clone() const->DCTClass * override {
+		return new DCTNative(sizex, sizey, dctmode);
+	}
+	auto DCTBytes2D(const std::uint8_t *srcp, int src_pitch, std::uint8_t *dctp, int dct_pitch)->void override {
+		Transform(tables, srcp, src_pitch, dctp, dct_pitch, rows.data());
+	}
+	auto DCTBlocks2D(const std::uint8_t *srcp, int src_pitch, int count, int step, std::uint8_t *dctp)->void override {
+		auto dct_pitch = static_cast<int>(sizex * sizeof(float));
+		for (auto i = 0; i < count; ++i)
+			Transform(tables, srcp + i * step, src_pitch, dctp + i * sizey * dct_pitch, dct_pitch, rows.data());
+	}
+};
@@ -0,0 +1,193 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include "VSHelper.h"
+#include "DegrainFunctions.hpp"
+#include "MVClip.hpp"
+#include "MVFrame.h"
+#include "Overlap.h"
+
+// how Degrain picks and weighs the reference blocks of one source block, shared by the filter and the core library.
+using LimitFunction = auto(*)(uint8_t*, intptr_t, const uint8_t*, intptr_t, intptr_t, intptr_t, double)->void;
+
+template <typename PixelType>
+static void LimitChanges_C(uint8_t* pDst8, intptr_t nDstPitch, const uint8_t* pSrc8, intptr_t nSrcPitch, intptr_t nWidth, intptr_t nHeight, double nLimit) {
+	for (int32_t h = 0; h < nHeight; h++) {
+		for (int32_t i = 0; i < nWidth; i++) {
+			const PixelType* pSrc = (const PixelType*)pSrc8;
+			PixelType* pDst = (PixelType*)pDst8;
+			pDst[i] = (PixelType)VSMIN(VSMAX(pDst[i], (pSrc[i] - nLimit)), (pSrc[i] + nLimit));
+		}
+		pDst8 += nDstPitch;
+		pSrc8 += nSrcPitch;
+	}
+}
+
+inline double DegrainWeight(double thSAD, double blockSAD) {
+	if (blockSAD >= thSAD)
+		return 0.;
+	return (thSAD - blockSAD) * (thSAD + blockSAD) * 256 / (thSAD * thSAD + blockSAD * blockSAD);
+}
+
+inline void useBlock(const uint8_t*& p, int32_t& np, double& WRef, bool isUsable, const MVClipBalls& mvclip, int32_t i, const MVPlane* pPlane, const uint8_t** pSrcCur, int32_t xx, const int32_t* nSrcPitch, int32_t nLogPel, int32_t plane, int32_t xSubUV, int32_t ySubUV, const double* thSAD) {
+	if (isUsable) {
+		auto& block = mvclip[0][i];
+		int32_t blx = (block.GetX() << nLogPel) + block.GetMV().x;
+		int32_t bly = (block.GetY() << nLogPel) + block.GetMV().y;
+		p = pPlane->GetPointer(plane ? blx >> xSubUV : blx, plane ? bly >> ySubUV : bly);
+		np = pPlane->GetPitch();
+		double blockSAD = block.GetSAD();
+		WRef = DegrainWeight(thSAD[plane], blockSAD);
+	}
+	else {
+		p = pSrcCur[plane] + xx;
+		np = nSrcPitch[plane];
+		WRef = 0.;
+	}
+}
+
+static inline void normalizeWeights(auto radius, double& WSrc, double* WRefs) {
+	WSrc = 256.;
+	double WSum = WSrc + 1.;
+	for (int32_t r = 0; r < radius * 2; r++)
+		WSum += WRefs[r];
+	for (int32_t r = 0; r < radius * 2; r++) {
+		WRefs[r] = WRefs[r] * 256 / WSum;
+		WSrc -= WRefs[r];
+	}
+}
+
+// the block grid of a Degrain frame per plane. nWidth_B and nHeight_B are the part of the plane the blocks cover, the
+// rest keeps the source.
+struct DegrainGeometry {
+	int32_t nBlkX;
+	int32_t nBlkY;
+	int32_t nLogPel;
+	int32_t xSubUV;
+	int32_t ySubUV;
+	int32_t dstTempPitch;
+	int32_t nWidth[3];
+	int32_t nHeight[3];
+	int32_t nOverlapX[3];
+	int32_t nOverlapY[3];
+	int32_t nBlkSizeX[3];
+	int32_t nBlkSizeY[3];
+	int32_t nWidth_B[3];
+	int32_t nHeight_B[3];
+};
+
+inline auto MakeDegrainGeometry(const MVAnalysisData& header, int32_t xSubUV, int32_t ySubUV) {
+	auto g = DegrainGeometry{};
+	g.nBlkX = header.GetBlkX();
+	g.nBlkY = header.GetBlkY();
+	g.nLogPel = (header.GetPel() == 4) ? 2 : (header.GetPel() == 2) ? 1 : 0;
+	g.xSubUV = xSubUV;
+	g.ySubUV = ySubUV;
+	g.dstTempPitch = ((header.GetWidth() + 15) / 16) * 16 * 4 * 2;
+	g.nWidth[0] = header.GetWidth();
+	g.nWidth[1] = g.nWidth[2] = g.nWidth[0] >> xSubUV;
+	g.nHeight[0] = header.GetHeight();
+	g.nHeight[1] = g.nHeight[2] = g.nHeight[0] >> ySubUV;
+	g.nOverlapX[0] = header.GetOverlapX();
+	g.nOverlapX[1] = g.nOverlapX[2] = g.nOverlapX[0] >> xSubUV;
+	g.nOverlapY[0] = header.GetOverlapY();
+	g.nOverlapY[1] = g.nOverlapY[2] = g.nOverlapY[0] >> ySubUV;
+	g.nBlkSizeX[0] = header.GetBlkSizeX();
+	g.nBlkSizeX[1] = g.nBlkSizeX[2] = g.nBlkSizeX[0] >> xSubUV;
+	g.nBlkSizeY[0] = header.GetBlkSizeY();
+	g.nBlkSizeY[1] = g.nBlkSizeY[2] = g.nBlkSizeY[0] >> ySubUV;
+	g.nWidth_B[0] = g.nBlkX * (g.nBlkSizeX[0] - g.nOverlapX[0]) + g.nOverlapX[0];
+	g.nWidth_B[1] = g.nWidth_B[2] = g.nWidth_B[0] >> xSubUV;
+	g.nHeight_B[0] = g.nBlkY * (g.nBlkSizeY[0] - g.nOverlapY[0]) + g.nOverlapY[0];
+	g.nHeight_B[1] = g.nHeight_B[2] = g.nHeight_B[0] >> ySubUV;
+	return g;
+}
+
+// degrains one plane of a frame block by block, with overlap the blocks are blended in DstTemp first. balls, isUsable,
+// pPlanes and thSAD hold one entry per reference in the order the caller keeps them, pPlanes are the planes of the
+// reference super frames. DstTemp and tmpBlock are only touched with overlap.
+inline void DegrainPlane(const DegrainGeometry& g, int32_t plane, int32_t radius, uint8_t* pDst, int32_t nDstPitch, const uint8_t* pSrc, int32_t nSrcPitch,
+	const MVClipBalls* const* balls, const std::vector<bool>& isUsable, MVPlane* const* pPlanes, const std::vector<std::array<double, 3>>& thSAD,
+	DenoiseFunction DEGRAIN, OverlapsFunction OVERS, OverlapWindows* OverWins, ToPixelsFunction ToPixels, LimitFunction LimitChanges, double nLimit,
+	uint8_t* DstTemp, uint8_t* tmpBlock) {
+	const int32_t nBlkX = g.nBlkX;
+	const int32_t nBlkY = g.nBlkY;
+	const int32_t nBlkSizeX = g.nBlkSizeX[plane];
+	const int32_t nBlkSizeY = g.nBlkSizeY[plane];
+	const int32_t nOverlapX = g.nOverlapX[plane];
+	const int32_t nOverlapY = g.nOverlapY[plane];
+	const int32_t nWidth = g.nWidth[plane];
+	const int32_t nHeight = g.nHeight[plane];
+	const int32_t nWidth_B = g.nWidth_B[plane];
+	const int32_t nHeight_B = g.nHeight_B[plane];
+	const int32_t dstTempPitch = g.dstTempPitch;
+	const int32_t tmpBlockPitch = g.nBlkSizeX[0] * 4;
+	// useBlock addresses the source by plane.
+	const uint8_t* pSrcCur[3] = {};
+	int32_t nSrcPitches[3] = {};
+	pSrcCur[plane] = pSrc;
+	nSrcPitches[plane] = nSrcPitch;
+	auto pDstCur = pDst;
+	auto pointers = std::vector<const uint8_t*>(2 * radius);
+	auto strides = std::vector<int32_t>(2 * radius);
+	auto WRefs = std::vector<double>(2 * radius);
+	double WSrc;
+	if (g.nOverlapX[0] == 0 && g.nOverlapY[0] == 0) {
+		for (int32_t by = 0; by < nBlkY; by++) {
+			int32_t xx = 0;
+			for (int32_t bx = 0; bx < nBlkX; bx++) {
+				int32_t i = by * nBlkX + bx;
+				for (int32_t r = 0; r < radius * 2; r++)
+					useBlock(pointers[r], strides[r], WRefs[r], isUsable[r], *balls[r], i, pPlanes[r], pSrcCur, xx, nSrcPitches, g.nLogPel, plane, g.xSubUV, g.ySubUV, thSAD[r].data());
+				normalizeWeights(radius, WSrc, WRefs.data());
+				DEGRAIN(radius, pDstCur + xx, nDstPitch, pSrcCur[plane] + xx, nSrcPitch, pointers.data(), strides.data(), WSrc, WRefs.data());
+				xx += nBlkSizeX * 4;
+				if (bx == nBlkX - 1 && g.nWidth_B[0] < g.nWidth[0])
+					vs_bitblt(pDstCur + nWidth_B * 4, nDstPitch,
+						pSrcCur[plane] + nWidth_B * 4, nSrcPitch,
+						(nWidth - nWidth_B) * 4, nBlkSizeY);
+			}
+			pDstCur += nBlkSizeY * nDstPitch;
+			pSrcCur[plane] += nBlkSizeY * nSrcPitch;
+			if (by == nBlkY - 1 && g.nHeight_B[0] < g.nHeight[0])
+				vs_bitblt(pDstCur, nDstPitch,
+					pSrcCur[plane], nSrcPitch,
+					nWidth * 4, nHeight - nHeight_B);
+		}
+	}
+	else {
+		uint8_t* pDstTemp = DstTemp;
+		std::memset(pDstTemp, 0, dstTempPitch * g.nHeight_B[0]);
+		for (int32_t by = 0; by < nBlkY; by++) {
+			int32_t wby = ((by + nBlkY - 3) / (nBlkY - 2)) * 3;
+			int32_t xx = 0;
+			for (int32_t bx = 0; bx < nBlkX; bx++) {
+				int32_t wbx = (bx + nBlkX - 3) / (nBlkX - 2);
+				auto winOver = OverWins->GetWindow(wby + wbx);
+				int32_t i = by * nBlkX + bx;
+				for (int32_t r = 0; r < radius * 2; r++)
+					useBlock(pointers[r], strides[r], WRefs[r], isUsable[r], *balls[r], i, pPlanes[r], pSrcCur, xx, nSrcPitches, g.nLogPel, plane, g.xSubUV, g.ySubUV, thSAD[r].data());
+				normalizeWeights(radius, WSrc, WRefs.data());
+				DEGRAIN(radius, tmpBlock, tmpBlockPitch, pSrcCur[plane] + xx, nSrcPitch, pointers.data(), strides.data(), WSrc, WRefs.data());
+				OVERS(pDstTemp + xx * 2, dstTempPitch, tmpBlock, tmpBlockPitch, winOver, nBlkSizeX);
+				xx += (nBlkSizeX - nOverlapX) * 4;
+			}
+			pSrcCur[plane] += (nBlkSizeY - nOverlapY) * nSrcPitch;
+			pDstTemp += (nBlkSizeY - nOverlapY) * dstTempPitch;
+		}
+		ToPixels(pDst, nDstPitch, DstTemp, dstTempPitch, nWidth_B, nHeight_B);
+		if (g.nWidth_B[0] < g.nWidth[0])
+			vs_bitblt(pDst + nWidth_B * 4, nDstPitch,
+				pSrc + nWidth_B * 4, nSrcPitch,
+				(nWidth - nWidth_B) * 4, nHeight_B);
+		if (g.nHeight_B[0] < g.nHeight[0])
+			vs_bitblt(pDst + nDstPitch * nHeight_B, nDstPitch,
+				pSrc + nSrcPitch * nHeight_B, nSrcPitch,
+				nWidth * 4, nHeight - nHeight_B);
+	}
+	if (nLimit < std::numeric_limits<double>::infinity())
+		LimitChanges(pDst, nDstPitch, pSrc, nSrcPitch, nWidth, nHeight, nLimit);
+}
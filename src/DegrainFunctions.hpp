@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+
+using DenoiseFunction = auto(*)(int, uint8_t*, int32_t, const uint8_t*, int32_t, const uint8_t**, const int32_t*, double, const double*)->void;
+
+template<int32_t blockWidth, int32_t blockHeight, typename PixelType>
+void Degrain_C(auto radius, uint8_t* pDst8, int32_t nDstPitch, const uint8_t* pSrc8, int32_t nSrcPitch, const uint8_t** pRefs8, const int32_t* nRefPitches, double WSrc, const double* WRefs) {
+	for (int32_t y = 0; y < blockHeight; y++) {
+		for (int32_t x = 0; x < blockWidth; x++) {
+			const PixelType* pSrc = (const PixelType*)pSrc8;
+			PixelType* pDst = (PixelType*)pDst8;
+			double sum = pSrc[x] * WSrc;
+			for (int32_t r = 0; r < radius * 2; r++) {
+				const PixelType* pRef = (const PixelType*)pRefs8[r];
+				sum += pRef[x] * WRefs[r];
+			}
+			pDst[x] = static_cast<PixelType>(sum / 256);
+		}
+		pDst8 += nDstPitch;
+		pSrc8 += nSrcPitch;
+		for (int32_t r = 0; r < radius * 2; r++)
+			pRefs8[r] += nRefPitches[r];
+	}
+}
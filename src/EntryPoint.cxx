@@ -12,6 +12,7 @@
 #include "MVFlowFPS.hxx"
 #include "MVBlockFPS.hxx"
 #include "MVSCDetection.hxx"
+#include "FilterTiming.hpp"
 
 VS_EXTERNAL_API(void) VapourSynthPluginInit(VSConfigPlugin configFunc, VSRegisterFunction registerFunc, VSPlugin *plugin) {
 	VaporGlobals::Identifier = "com.zonked.mvsf";
@@ -31,4 +32,5 @@ VS_EXTERNAL_API(void) VapourSynthPluginInit(VSConfigPlugin configFunc, VSRegiste
 	mvflowfpsRegister(registerFunc, plugin);
 	mvblockfpsRegister(registerFunc, plugin);
 	mvscdetectionRegister(registerFunc, plugin);
+	mvstatsRegister(registerFunc, plugin);
 }
@@ -0,0 +1,128 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "Core.hpp"
+#include "MVFrame.h"
+#include "MVInterface.h"
+#include "Overlap.h"
+
+// the defaults and checks of Super, Analyze and Degrain, shared by the filters and libmvsf-core. the filters read
+// their arguments into the parameter structs of Core.hpp, whose initializers are the defaults, so a default or a check
+// changed here changes both. the checks return the error message without the name of the filter, or nullptr.
+
+auto CheckSuperParameters(const mvsf::SuperParameters &parameters) -> const char * {
+	if (parameters.Pel != 1 && parameters.Pel != 2 && parameters.Pel != 4)
+		return "pel must be 1, 2, or 4.";
+	if (parameters.Sharp < 0 || parameters.Sharp > 2)
+		return "sharp must be between 0 and 2 (inclusive).";
+	if (parameters.RFilter < 0 || parameters.RFilter > 4)
+		return "rfilter must be between 0 and 4 (inclusive).";
+	return nullptr;
+}
+
+// replaces levels outside 1 to the most the clip has room for with the most, and returns the dimensions of the super
+// frames.
+auto ResolveSuperParameters(mvsf::SuperParameters &parameters, int32_t width, int32_t height, int32_t xRatioUV, int32_t yRatioUV) {
+	int32_t nLevelsMax = 0;
+	while (PlaneHeightLuma(height, nLevelsMax, yRatioUV, parameters.VPad) >= yRatioUV * 2 &&
+		PlaneWidthLuma(width, nLevelsMax, xRatioUV, parameters.HPad) >= xRatioUV * 2)
+		++nLevelsMax;
+	if (parameters.Levels <= 0 || parameters.Levels > nLevelsMax)
+		parameters.Levels = nLevelsMax;
+	auto nSuperWidth = width + 2 * parameters.HPad;
+	auto nSuperHeight = static_cast<int32_t>(PlaneSuperOffset(false, height, parameters.Levels, parameters.Pel, parameters.VPad, nSuperWidth, yRatioUV) / nSuperWidth);
+	if (yRatioUV == 2 && nSuperHeight & 1)
+		++nSuperHeight;
+	if (xRatioUV == 2 && nSuperWidth & 1)
+		++nSuperWidth;
+	return std::pair{ nSuperWidth, nSuperHeight };
+}
+
+constexpr SearchType SearchTypes[] = { ONETIME, NSTEP, LOGARITHMIC, EXHAUSTIVE, HEX2SEARCH, UMHSEARCH, HSEARCH, VSEARCH };
+
+auto SearchParameter(SearchType searchType, int32_t searchparam) {
+	if (searchType == NSTEP)
+		return searchparam < 0 ? 0 : searchparam;
+	return searchparam < 1 ? 1 : searchparam;
+}
+
+// fills in the parameters left empty, their defaults depend on truemotion and the block size.
+auto ResolveAnalyzeParameters(mvsf::AnalyzeParameters &parameters) {
+	auto truemotion = parameters.TrueMotion;
+	parameters.BlkSizeV = parameters.BlkSizeV.value_or(parameters.BlkSize);
+	parameters.OverlapV = parameters.OverlapV.value_or(parameters.Overlap);
+	parameters.Lambda = parameters.Lambda.value_or(truemotion ? (1000 * parameters.BlkSize * *parameters.BlkSizeV / 64) : 0.);
+	parameters.LSAD = parameters.LSAD.value_or(truemotion ? 1200. : 400.);
+	parameters.PLevel = parameters.PLevel.value_or(truemotion ? 1 : 0);
+	parameters.Global = parameters.Global.value_or(truemotion);
+	parameters.PNew = parameters.PNew.value_or(truemotion ? 50 : 0);
+	parameters.PZero = parameters.PZero.value_or(*parameters.PNew);
+}
+
+// takes resolved parameters and the subsampling of the super clip.
+auto CheckAnalyzeParameters(const mvsf::AnalyzeParameters &parameters, int32_t subSamplingW, int32_t subSamplingH) -> const char * {
+	auto blksize = parameters.BlkSize;
+	auto blksizev = *parameters.BlkSizeV;
+	auto overlap = parameters.Overlap;
+	auto overlapv = *parameters.OverlapV;
+	if (parameters.Search < 0 || parameters.Search > 7)
+		return "search must be between 0 and 7 (inclusive).";
+	if (parameters.SearchCoarse < 0 || parameters.SearchCoarse > 7)
+		return "search_coarse must be between 0 and 7 (inclusive).";
+	if (parameters.StaticTh < 0)
+		return "staticth must not be negative.";
+	if (parameters.Prepass < 0)
+		return "prepass must not be negative.";
+	if (parameters.Wavefront < 0)
+		return "wavefront must not be negative.";
+	if (parameters.DCT < 0 || parameters.DCT > 10)
+		return "dct must be between 0 and 10 (inclusive).";
+	if (parameters.DCT >= 5 && (blksize != blksizev || blksize < 4 || blksize > 256 || (blksize & (blksize - 1))))
+		return "dct 5..10 can only work with square blocks.";
+	constexpr std::pair<int32_t, int32_t> blockSizes[] = { { 2, 2 }, { 4, 4 }, { 8, 4 }, { 8, 8 }, { 16, 2 }, { 16, 8 }, { 16, 16 }, { 32, 32 }, { 32, 16 }, { 64, 32 }, { 64, 64 }, { 128, 64 }, { 128, 128 }, { 256, 128 }, { 256, 256 } };
+	if (std::find(std::begin(blockSizes), std::end(blockSizes), std::pair{ blksize, blksizev }) == std::end(blockSizes))
+		return "the block size must be 2x2, 4x4, 8x4, 8x8, 16x2, 16x8, 16x16, 32x16, 32x32, 64x32, 64x64, 128x64, 128x128, 256x128, or 256x256.";
+	if (*parameters.PLevel < 0 || *parameters.PLevel > 2)
+		return "plevel must be between 0 and 2 (inclusive).";
+	if (*parameters.PNew < 0 || *parameters.PNew > 256)
+		return "pnew must be between 0 and 256 (inclusive).";
+	if (*parameters.PZero < 0 || *parameters.PZero > 256)
+		return "pzero must be between 0 and 256 (inclusive).";
+	if (parameters.PGlobal < 0 || parameters.PGlobal > 256)
+		return "pglobal must be between 0 and 256 (inclusive).";
+	if (overlap < 0 || overlap > blksize / 2 || overlapv < 0 || overlapv > blksizev / 2)
+		return "overlap must be at most half of blksize, overlapv must be at most half of blksizev, and they both need to be at least 0.";
+	if (overlap % (1 << subSamplingW) || overlapv % (1 << subSamplingH))
+		return "The requested overlap is incompatible with the super clip's subsampling.";
+	return nullptr;
+}
+
+auto CheckDegrainParameters(const mvsf::DegrainParameters &parameters) -> const char * {
+	if (parameters.Limit)
+		for (auto x : *parameters.Limit)
+			if (x < 0.)
+				return "limit cannot be negative.";
+	if (parameters.Plane < 0 || parameters.Plane > 4)
+		return "plane must be between 0 and 4 (inclusive).";
+	return nullptr;
+}
+
+auto DegrainPlanes(const mvsf::DegrainParameters &parameters) {
+	constexpr int32_t planes[5] = { YPLANE, UPLANE, VPLANE, UVPLANES, YUVPLANES };
+	return planes[parameters.Plane];
+}
+
+// the thsad of every reference in the order Degrain keeps them, backward and forward interleaved by distance, before
+// they are scaled by thscd1.
+auto DegrainThSAD(const mvsf::DegrainParameters &parameters, int32_t radius) {
+	auto thsad2 = parameters.ThSAD2.value_or(parameters.ThSAD);
+	auto thSAD = std::vector<std::array<double, 3>>(2 * radius);
+	for (auto r = 0; r < radius; ++r)
+		for (auto c = 0; c < 3; ++c)
+			thSAD[2 * r + 1][c] = thSAD[2 * r][c] = CosineAnnealing(parameters.ThSAD[c], thsad2[c], r + 1, radius);
+	return thSAD;
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "VapourSynth.h"
+
+// wall clock time one filter instance spent on each of its frames, split into setup (fetching frames and preparing
+// the output), kernel and teardown (freeing frames and writing props). all in milliseconds. frames are not kept, only
+// running sums and a histogram of the whole time of each frame, so the memory stays the same however long it runs.
+class FilterTiming final {
+	// bins a sixteenth of an octave wide from 2^-10 ms (about a microsecond) to 2^20 ms, the times outside go to the
+	// bins at either end.
+	static constexpr auto BinsPerOctave = 16;
+	static constexpr auto LowestOctave = -10;
+	static constexpr auto Octaves = 30;
+	std::mutex lock;
+	int64_t calls = 0;
+	double setup = 0.;
+	double kernel = 0.;
+	double teardown = 0.;
+	double minimum = std::numeric_limits<double>::infinity();
+	double maximum = 0.;
+	std::array<int64_t, BinsPerOctave * Octaves> histogram = {};
+	static auto Bin(double time) {
+		auto position = (std::log2(time) - LowestOctave) * BinsPerOctave;
+		return static_cast<std::size_t>(std::clamp(position, 0., BinsPerOctave * Octaves - 1.));
+	}
+public:
+	const std::string filter;
+	explicit FilterTiming(const char *_filter) :filter{ _filter } {}
+	auto Record(double setupTime, double kernelTime, double teardownTime) {
+		auto guard = std::lock_guard{ lock };
+		auto total = setupTime + kernelTime + teardownTime;
+		++calls;
+		setup += setupTime;
+		kernel += kernelTime;
+		teardown += teardownTime;
+		minimum = std::min(minimum, total);
+		maximum = std::max(maximum, total);
+		++histogram[Bin(total)];
+	}
+	// appends one entry per key to out, min, max and the percentiles are taken over the whole time of each frame. a
+	// percentile is the geometric middle of its bin, within about 2% of the exact one, and never outside min and max.
+	auto Summarize(VSMap *out, const VSAPI *vsapi) {
+		auto guard = std::lock_guard{ lock };
+		auto Percentile = [&](double p) {
+			if (calls == 0)
+				return 0.;
+			auto rank = std::max(static_cast<int64_t>(std::ceil(p / 100 * calls)), int64_t{ 1 });
+			auto bin = std::size_t{ 0 };
+			auto seen = histogram[0];
+			while (seen < rank)
+				seen += histogram[++bin];
+			return std::clamp(std::exp2(LowestOctave + (bin + .5) / BinsPerOctave), minimum, maximum);
+		};
+		vsapi->propSetData(out, "filter", filter.c_str(), -1, paAppend);
+		vsapi->propSetInt(out, "calls", calls, paAppend);
+		vsapi->propSetFloat(out, "setup", setup, paAppend);
+		vsapi->propSetFloat(out, "kernel", kernel, paAppend);
+		vsapi->propSetFloat(out, "teardown", teardown, paAppend);
+		vsapi->propSetFloat(out, "total", setup + kernel + teardown, paAppend);
+		vsapi->propSetFloat(out, "min", calls ? minimum : 0., paAppend);
+		vsapi->propSetFloat(out, "max", maximum, paAppend);
+		vsapi->propSetFloat(out, "p50", Percentile(50), paAppend);
+		vsapi->propSetFloat(out, "p90", Percentile(90), paAppend);
+		vsapi->propSetFloat(out, "p99", Percentile(99), paAppend);
+	}
+};
+
+// every timed filter instance of the process, in the order they were created. instances outlive their filters so a
+// script can still ask for the numbers after its clips are gone. timing is off unless MVSF_TIMING is set to
+// something other than 0, in which case Create hands out nullptr and the filters skip every measurement.
+class TimingRegistry final {
+	std::mutex lock;
+	std::vector<std::unique_ptr<FilterTiming>> instances;
+	const bool enabled = [] {
+		auto value = std::getenv("MVSF_TIMING");
+		return value && std::string{ value } != "0";
+	}();
+	TimingRegistry() = default;
+public:
+	static auto &Instance() {
+		static auto registry = new TimingRegistry{};
+		return *registry;
+	}
+	auto Create(const char *filter) -> FilterTiming * {
+		if (!enabled)
+			return nullptr;
+		auto guard = std::lock_guard{ lock };
+		instances.push_back(std::make_unique<FilterTiming>(filter));
+		return instances.back().get();
+	}
+	auto Summarize(VSMap *out, const VSAPI *vsapi) {
+		auto guard = std::lock_guard{ lock };
+		for (auto &x : instances)
+			x->Summarize(out, vsapi);
+	}
+};
+
+// marks the phases of one frame. Kernel and Teardown close the phase before them, Finish closes teardown, records the
+// frame and writes [setup, kernel, teardown] as <filter>_timing on dst. frames that fail on the way are not recorded.
+class FrameTimer final {
+	using Clock = std::chrono::steady_clock;
+	FilterTiming *timing;
+	Clock::time_point start;
+	Clock::time_point kernel;
+	Clock::time_point teardown;
+	static auto Milliseconds(Clock::time_point from, Clock::time_point to) {
+		return std::chrono::duration<double, std::milli>{ to - from }.count();
+	}
+public:
+	explicit FrameTimer(FilterTiming *_timing) :timing{ _timing } {
+		if (timing)
+			start = Clock::now();
+	}
+	auto Kernel() {
+		if (timing)
+			kernel = Clock::now();
+	}
+	auto Teardown() {
+		if (timing)
+			teardown = Clock::now();
+	}
+	auto Finish(VSFrameRef *dst, const VSAPI *vsapi) {
+		if (!timing)
+			return;
+		auto end = Clock::now();
+		const double phases[] = { Milliseconds(start, kernel), Milliseconds(kernel, teardown), Milliseconds(teardown, end) };
+		timing->Record(phases[0], phases[1], phases[2]);
+		auto props = vsapi->getFramePropsRW(dst);
+		auto key = timing->filter + "_timing";
+		vsapi->propSetFloatArray(props, key.c_str(), phases, 3);
+	}
+};
+
+static void VS_CC mvstatsCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
+	TimingRegistry::Instance().Summarize(out, vsapi);
+}
+
+void mvstatsRegister(VSRegisterFunction registerFunc, VSPlugin *plugin) {
+	registerFunc("Stats", "", mvstatsCreate, 0, plugin);
+}
@@ -68,7 +68,7 @@ public:
 		double lsad, int32_t pnew, int32_t plevel, bool global,
 		int32_t* out, int32_t* outfilebuf, int32_t fieldShift, DCTClass* _DCT,
 		int32_t pzero, int32_t pglobal, double badSAD, int32_t badrange, bool meander, int32_t* vecPrev, bool tryMany,
-		SearchType coarseSearchType) {
+		SearchType coarseSearchType, double staticRatio, double prepassThreshold, ThreadPool* wavefrontPool) {
 		int32_t i;
 		out[0] = GetArraySize();
 		out[1] = 1;
@@ -85,11 +85,12 @@ public:
 		SearchType searchTypeSmallest = (nLevelCount == 1 || searchType == HSEARCH || searchType == VSEARCH) ? searchType : coarseSearchType;
 		int32_t nSearchParamSmallest = (nLevelCount == 1) ? nPelSearch : nSearchParam;
 		bool tryManyLevel = tryMany && nLevelCount > 1;
+		planes[nLevelCount - 1]->ResetVectors();
 		planes[nLevelCount - 1]->SearchMVs(pSrcGOF->GetFrame(nLevelCount - 1),
 			pRefGOF->GetFrame(nLevelCount - 1),
 			searchTypeSmallest, nSearchParamSmallest, nLambda, lsad, pnew, plevel,
 			out, &globalMV, outfilebuf, fieldShiftCur, _DCT, &meanLumaChange, divideExtra,
-			pzero, pglobal, badSAD, badrange, meander, vecPrev, tryManyLevel);
+			pzero, pglobal, badSAD, badrange, meander, vecPrev, tryManyLevel, staticRatio, prepassThreshold, wavefrontPool);
 		out += planes[nLevelCount - 1]->GetArraySize(divideExtra);
 		if (vecPrev) vecPrev += planes[nLevelCount - 1]->GetArraySize(divideExtra);
 		for (i = nLevelCount - 2; i >= 0; --i) {
@@ -103,11 +104,37 @@ public:
 			planes[i]->SearchMVs(pSrcGOF->GetFrame(i), pRefGOF->GetFrame(i),
 				searchTypeLevel, nSearchParamLevel, nLambda, lsad, pnew, plevel,
 				out, &globalMV, outfilebuf, fieldShiftCur, _DCT, &meanLumaChange, divideExtra,
-				pzero, pglobal, badSAD, badrange, meander, vecPrev, tryManyLevel);
+				pzero, pglobal, badSAD, badrange, meander, vecPrev, tryManyLevel, staticRatio, prepassThreshold, wavefrontPool);
 			out += int32_t(planes[i]->GetArraySize(divideExtra));
 			if (vecPrev) vecPrev += planes[i]->GetArraySize(divideExtra);
 		}
 	}
+	// for several searches of the same source against different references, called again whenever the source changes.
+	void KeepSourceBlocks(bool keep) {
+		for (int32_t i = 0; i < nLevelCount; ++i)
+			planes[i]->KeepSourceBlocks(keep);
+	}
+	void EnableStats(bool enable) {
+		for (int32_t i = 0; i < nLevelCount; ++i)
+			planes[i]->EnableStats(enable);
+	}
+	// what the last search did on level i, 0 is the finest.
+	const SearchCounters& GetStats(int32_t i) {
+		return planes[i]->GetStats();
+	}
+	int32_t GetBlockCount(int32_t i) {
+		return planes[i]->GetnBlkCount();
+	}
+	// share of the blocks of the last search, over all levels, that the static block test ended early.
+	double GetStaticSkipRate() {
+		int32_t skips = 0;
+		int32_t blocks = 0;
+		for (int32_t i = 0; i < nLevelCount; ++i) {
+			skips += planes[i]->GetStaticSkips();
+			blocks += planes[i]->GetnBlkCount();
+		}
+		return static_cast<double>(skips) / blocks;
+	}
 	void WriteDefaultToArray(int32_t* array) {
 		array[0] = GetArraySize();
 		array[1] = 0;
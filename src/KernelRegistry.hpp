@@ -0,0 +1,172 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include "CPUFeatures.hpp"
+#include "SADFunctions.hpp"
+#include "Variance.hpp"
+#include "CopyCode.hpp"
+#include "Overlap.h"
+#include "DegrainFunctions.hpp"
+
+enum class KernelKind : std::int32_t {
+	SAD,
+	SADLimit,
+	SADx4,
+	SADYUV,
+	SATD,
+	Luma,
+	Copy,
+	Overlaps,
+	Degrain
+};
+
+struct BlockSize final {
+	int Width;
+	int Height;
+};
+
+// every luma block size Analyze accepts, together with the chroma sizes they turn into.
+constexpr auto RegisteredBlockSizes = std::array{
+	BlockSize{ 2, 2 }, BlockSize{ 2, 4 }, BlockSize{ 4, 2 }, BlockSize{ 4, 4 }, BlockSize{ 4, 8 },
+	BlockSize{ 8, 1 }, BlockSize{ 8, 2 }, BlockSize{ 8, 4 }, BlockSize{ 8, 8 }, BlockSize{ 8, 16 },
+	BlockSize{ 16, 1 }, BlockSize{ 16, 2 }, BlockSize{ 16, 4 }, BlockSize{ 16, 8 }, BlockSize{ 16, 16 }, BlockSize{ 16, 32 },
+	BlockSize{ 32, 8 }, BlockSize{ 32, 16 }, BlockSize{ 32, 32 }, BlockSize{ 32, 64 },
+	BlockSize{ 64, 16 }, BlockSize{ 64, 32 }, BlockSize{ 64, 64 }, BlockSize{ 64, 128 },
+	BlockSize{ 128, 32 }, BlockSize{ 128, 64 }, BlockSize{ 128, 128 }, BlockSize{ 128, 256 },
+	BlockSize{ 256, 64 }, BlockSize{ 256, 128 }, BlockSize{ 256, 256 }
+};
+
+constexpr auto RegisteredInstructionSets = std::array{
+	InstructionSet::C,
+	InstructionSet::SSE2,
+	InstructionSet::AVX2,
+	InstructionSet::AVX512
+};
+
+// one specialization per kind, Get<w, h, isa>() names the kernel for that block size and instruction set, or nullptr.
+// kinds without SIMD variants return the same kernel for every instruction set.
+template<KernelKind Kind>
+struct KernelTraits;
+
+template<>
+struct KernelTraits<KernelKind::SAD> final {
+	using Function = SADFunction;
+	template<int nBlkWidth, int nBlkHeight, InstructionSet isa>
+	static constexpr auto Get() -> Function {
+		return SadKernel<nBlkWidth, nBlkHeight, isa>();
+	}
+};
+
+template<>
+struct KernelTraits<KernelKind::SADLimit> final {
+	using Function = SADLimitFunction;
+	template<int nBlkWidth, int nBlkHeight, InstructionSet isa>
+	static constexpr auto Get() -> Function {
+		return SadLimitKernel<nBlkWidth, nBlkHeight, isa>();
+	}
+};
+
+template<>
+struct KernelTraits<KernelKind::SADx4> final {
+	using Function = SADx4Function;
+	template<int nBlkWidth, int nBlkHeight, InstructionSet isa>
+	static constexpr auto Get() -> Function {
+		return Sadx4Kernel<nBlkWidth, nBlkHeight, isa>();
+	}
+};
+
+// the fused kernel also depends on the chroma subsampling, so the registry hands out its selector.
+template<>
+struct KernelTraits<KernelKind::SADYUV> final {
+	using Function = SADYUVSelector;
+	template<int nBlkWidth, int nBlkHeight, InstructionSet isa>
+	static constexpr auto Get() -> Function {
+		return SadYUVKernel<nBlkWidth, nBlkHeight, isa>;
+	}
+};
+
+template<>
+struct KernelTraits<KernelKind::SATD> final {
+	using Function = SADFunction;
+	template<int nBlkWidth, int nBlkHeight, InstructionSet isa>
+	static constexpr auto Get() -> Function {
+		if constexpr ((nBlkWidth == 4 && nBlkHeight == 4) || (nBlkWidth % 8 == 0 && nBlkHeight % 4 == 0))
+			return SatdKernel<nBlkWidth, nBlkHeight, isa>();
+		else
+			return nullptr;
+	}
+};
+
+template<>
+struct KernelTraits<KernelKind::Luma> final {
+	using Function = LUMAFunction;
+	template<int nBlkWidth, int nBlkHeight, InstructionSet isa>
+	static constexpr auto Get() -> Function {
+		return Luma_C<nBlkWidth, nBlkHeight>;
+	}
+};
+
+template<>
+struct KernelTraits<KernelKind::Copy> final {
+	using Function = COPYFunction;
+	template<int nBlkWidth, int nBlkHeight, InstructionSet isa>
+	static constexpr auto Get() -> Function {
+		return Copy_C<nBlkWidth, nBlkHeight>;
+	}
+};
+
+template<>
+struct KernelTraits<KernelKind::Overlaps> final {
+	using Function = OverlapsFunction;
+	template<int nBlkWidth, int nBlkHeight, InstructionSet isa>
+	static constexpr auto Get() -> Function {
+		return Overlaps_C<nBlkWidth, nBlkHeight, double, float>;
+	}
+};
+
+template<>
+struct KernelTraits<KernelKind::Degrain> final {
+	using Function = DenoiseFunction;
+	template<int nBlkWidth, int nBlkHeight, InstructionSet isa>
+	static constexpr auto Get() -> Function {
+		return Degrain_C<nBlkWidth, nBlkHeight, float>;
+	}
+};
+
+// built entirely at compile time and never written to, so filters may query it concurrently.
+template<KernelKind Kind>
+class KernelRegistry final {
+	using Function = typename KernelTraits<Kind>::Function;
+	struct Entry final {
+		BlockSize Size;
+		InstructionSet ISA;
+		Function Kernel;
+	};
+	template<std::size_t SizeIndex, std::size_t ISAIndex>
+	static constexpr auto MakeEntry() {
+		constexpr auto Size = RegisteredBlockSizes[SizeIndex];
+		constexpr auto ISA = RegisteredInstructionSets[ISAIndex];
+		return Entry{ Size, ISA, KernelTraits<Kind>::template Get<Size.Width, Size.Height, ISA>() };
+	}
+	template<std::size_t... Indexes>
+	static constexpr auto MakeEntries(std::index_sequence<Indexes...>) {
+		constexpr auto ISACount = RegisteredInstructionSets.size();
+		return std::array{ MakeEntry<Indexes / ISACount, Indexes % ISACount>()... };
+	}
+public:
+	static constexpr auto Entries = MakeEntries(std::make_index_sequence<RegisteredBlockSizes.size() * RegisteredInstructionSets.size()>{});
+	static constexpr auto Find(int nBlkWidth, int nBlkHeight, InstructionSet isa) -> Function {
+		for (auto &x : Entries)
+			if (x.Size.Width == nBlkWidth && x.Size.Height == nBlkHeight && x.ISA == isa)
+				return x.Kernel;
+		return nullptr;
+	}
+};
+
+// the kernel for the instruction set of this machine, nullptr for block sizes the kind does not support.
+template<KernelKind Kind>
+auto GetKernel(int nBlkWidth, int nBlkHeight) {
+	return KernelRegistry<Kind>::Find(nBlkWidth, nBlkHeight, GetInstructionSet());
+}
@@ -1,14 +1,74 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <tuple>
+#include <vector>
 #include "VapourSynth.h"
 #include "VSHelper.h"
 #include "DCTFFTW.hpp"
+#include "AnalysisContext.hpp"
+#include "FilterParameters.hpp"
+#include "FilterTiming.hpp"
 #include "GroupOfPlanes.h"
 #include "MVInterface.h"
 
+// the temporal predictor of frame n is the vectors frame n - 1 found, every row its own, except for the first frame
+// of every chain of Chain frames, which has none. every chain keeps the vectors of the furthest frame searched in it
+// so far, a frame that does not follow them searches the frames of its chain before it first, so the vectors never
+// depend on the order frames are requested in or on the threads that run them. the frames of one chain are searched
+// one at a time, different chains at the same time. beyond one chain per thread of the core the least recently used
+// chain is dropped, which only costs searching its frames again.
+class TemporalVectorCache final {
+public:
+	static constexpr auto Chain = 8;
+	struct Entry final {
+		// held for the whole search of a frame, so a frame waits for the one before it instead of searching it again.
+		std::mutex search;
+		std::mutex lock;
+		int32_t frame = -1;
+		// empty for a row without a reference.
+		std::vector<std::vector<int32_t>> vectors;
+		auto Follows(int32_t first, int32_t n) const {
+			return frame >= first && frame < n;
+		}
+	};
+private:
+	std::mutex lock;
+	std::map<int32_t, std::pair<std::shared_ptr<Entry>, int64_t>> chains;
+	int64_t uses = 0;
+	const std::size_t capacity;
+public:
+	explicit TemporalVectorCache(std::size_t _capacity) :capacity{ std::max(_capacity, std::size_t{ 1 }) } {}
+	// the entry of the chain of frame n.
+	auto Get(int32_t n) {
+		auto guard = std::lock_guard{ lock };
+		auto &[entry, lastUse] = chains[n / Chain];
+		if (!entry)
+			entry = std::make_shared<Entry>();
+		lastUse = ++uses;
+		auto result = entry;
+		if (chains.size() > capacity)
+			chains.erase(std::min_element(chains.begin(), chains.end(), [](auto &x, auto &y) {
+				return x.second.second < y.second.second;
+			}));
+		return result;
+	}
+};
+
+// the part of a chain a temporal frame has to search: frames first to n, the vectors of the frame before first unless
+// first starts the chain. taken in arInitial, so it stays valid whatever the cache holds by the time the frames arrive.
+struct TemporalRequest {
+	int32_t first;
+	std::vector<std::vector<int32_t>> vectors;
+};
+
 struct MVAnalyzeData {
 	VSNodeRef *node;
 	VSVideoInfo vi;
@@ -31,7 +91,16 @@ struct MVAnalyzeData {
 	double badSAD;
 	int32_t badrange;
 	bool meander;
+	int32_t wavefront;
+	ThreadPool *wavefrontPool;
+	AnalysisContextPool *contexts;
+	bool temporal;
+	TemporalVectorCache *temporalVectors;
 	bool tryMany;
+	double staticRatio;
+	double prepass;
+	bool stats;
+	FilterTiming *timing;
 	int32_t dctmode;
 	int32_t nModeYUV;
 	int32_t headerSize;
@@ -49,6 +118,7 @@ struct MVAnalyzeData {
 	bool isb;
 	bool chroma;
 	int32_t delta;
+	int32_t radius;
 	bool truemotion;
 	int32_t overlap;
 	int32_t overlapv;
@@ -62,294 +132,372 @@ static void VS_CC mvanalyzeInit(VSMap *in, VSMap *out, void **instanceData, VSNo
 	vsapi->setVideoInfo(&d->vi, 1, node);
 }
 
+// the reference of one vector row, radius mode writes the backward rows from the farthest reference inwards and then
+// the forward rows outwards, the layout of mvmulti.
+static auto GetReference(const MVAnalyzeData *d, int32_t n, int32_t row) {
+	auto isb = d->analysisData.isBackward;
+	auto delta = d->analysisData.nDeltaFrame;
+	if (d->radius > 0) {
+		isb = row < d->radius;
+		delta = isb ? d->radius - row : row - d->radius + 1;
+	}
+	auto nref = delta > 0 ? n + (isb ? delta : -delta) : -delta;
+	return std::tuple{ isb, delta, nref };
+}
+
+// the search counters of one row, an array over the levels from the finest up for the per level ones. rows without
+// a reference get zeros so that row r always starts at the same index.
+static auto WriteSearchStats(VSMap *props, GroupOfPlanes *vectorFields, int32_t levels, bool searched, int32_t row, const VSAPI *vsapi) {
+	auto mode = row == 0 ? paReplace : paAppend;
+	auto wins = std::array<int64_t, SearchCounters::WinnerCount>{};
+	auto blocks = int64_t{ 0 };
+	for (auto i : Range{ levels }) {
+		auto counters = searched ? vectorFields->GetStats(i) : SearchCounters{};
+		auto nBlkCount = vectorFields->GetBlockCount(i);
+		vsapi->propSetInt(props, "Analyze_sad", counters.sad, mode);
+		vsapi->propSetInt(props, "Analyze_satd", counters.satd, mode);
+		vsapi->propSetInt(props, "Analyze_dct", counters.dct, mode);
+		vsapi->propSetFloat(props, "Analyze_refine", static_cast<double>(counters.refine) / nBlkCount, mode);
+		vsapi->propSetInt(props, "Analyze_earlyexit", counters.earlyExit, mode);
+		vsapi->propSetInt(props, "Analyze_badsad", counters.badSAD, mode);
+		for (auto k : Range{ SearchCounters::WinnerCount })
+			wins[k] += counters.wins[k];
+		blocks += nBlkCount;
+		mode = paAppend;
+	}
+	// share of the blocks over all levels whose vector came from zero, global, the coarse level, the spatial
+	// neighbours, the temporal predictor or the search itself.
+	for (auto k : Range{ SearchCounters::WinnerCount })
+		vsapi->propSetFloat(props, "Analyze_predictor", static_cast<double>(wins[k]) / blocks, k == 0 ? mode : paAppend);
+}
+
+// the field order of frame n, false with the error set when fields need a _Field property the frame lacks.
+static auto GetFieldOrder(const MVAnalyzeData *d, const VSFrameRef *frame, int32_t n, bool &tff, VSFrameContext *frameCtx, const VSAPI *vsapi) {
+	int err;
+	tff = !!vsapi->propGetInt(vsapi->getFramePropsRO(frame), "_Field", 0, &err);
+	if (err && d->fields && !d->tffexists) {
+		vsapi->setFilterError("Analyze: _Field property not found in input frame. Therefore, you must pass tff argument.", frameCtx);
+		return false;
+	}
+	if (d->tffexists)
+		tff = !!(static_cast<int>(d->tff) ^ (n % 2));
+	return true;
+}
+
+static auto UpdateSource(const MVAnalyzeData *d, AnalysisContext *context, const VSFrameRef *src, int32_t rows, const VSAPI *vsapi) {
+	const uint8_t *pSrc[3] = { nullptr };
+	int32_t nSrcPitch[3] = { 0 };
+	for (int32_t plane = 0; plane < d->supervi->format->numPlanes; plane++) {
+		pSrc[plane] = vsapi->getReadPtr(src, plane);
+		nSrcPitch[plane] = vsapi->getStride(src, plane);
+	}
+	context->pSrcGOF->Update(d->nModeYUV, (uint8_t *)pSrc[0], nSrcPitch[0], (uint8_t *)pSrc[1], nSrcPitch[1], (uint8_t *)pSrc[2], nSrcPitch[2]);
+	context->vectorFields->KeepSourceBlocks(rows > 1);
+}
+
+// searches one row of frame n, whose super frame is the source of context, into pDst. false with the error set when
+// the reference lacks its _Field property.
+static auto SearchRow(const MVAnalyzeData *d, AnalysisContext *context, int32_t n, int32_t row, bool srctff, int32_t *pDst, int32_t *vecPrev, VSFrameContext *frameCtx, const VSAPI *vsapi) {
+	auto [isb, delta, nref] = GetReference(d, n, row);
+	const VSFrameRef *ref = vsapi->getFrameFilter(nref, d->node, frameCtx);
+	bool reftff;
+	if (!GetFieldOrder(d, ref, nref, reftff, frameCtx, vsapi)) {
+		vsapi->freeFrame(ref);
+		return false;
+	}
+	int32_t fieldShift = 0;
+	if (d->fields && d->analysisData.nPel > 1 && (delta % 2))
+		fieldShift = (srctff && !reftff) ? d->analysisData.nPel / 2 : ((reftff && !srctff) ? -(d->analysisData.nPel / 2) : 0);
+	const uint8_t *pRef[3] = { nullptr };
+	int32_t nRefPitch[3] = { 0 };
+	for (int32_t plane = 0; plane < d->supervi->format->numPlanes; plane++) {
+		pRef[plane] = vsapi->getReadPtr(ref, plane);
+		nRefPitch[plane] = vsapi->getStride(ref, plane);
+	}
+	context->pRefGOF->Update(d->nModeYUV, (uint8_t *)pRef[0], nRefPitch[0], (uint8_t *)pRef[1], nRefPitch[1], (uint8_t *)pRef[2], nRefPitch[2]);
+	context->vectorFields->SearchMVs(context->pSrcGOF.get(), context->pRefGOF.get(), d->searchType, d->nSearchParam, d->nPelSearch, d->nLambda, d->lsad, d->pnew, d->plevel, d->global, pDst, nullptr, fieldShift, context->DCTc.get(), d->pzero, d->pglobal, d->badSAD, d->badrange, d->meander, vecPrev, d->tryMany, d->searchTypeCoarse, d->staticRatio, d->prepass, d->wavefrontPool);
+	vsapi->freeFrame(ref);
+	return true;
+}
+
 static const VSFrameRef *VS_CC mvanalyzeGetFrame(int32_t n, int32_t activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
 	MVAnalyzeData *d = reinterpret_cast<MVAnalyzeData *>(*instanceData);
+	auto rows = d->radius > 0 ? 2 * d->radius : 1;
+	auto IsValidFrame = [&](auto x) {
+		return x >= 0 && (x < d->vi.numFrames || !d->vi.numFrames);
+	};
 	if (activationReason == arInitial) {
-		int32_t nref;
-		if (d->analysisData.nDeltaFrame > 0) {
-			int32_t offset = (d->analysisData.isBackward) ? d->analysisData.nDeltaFrame : -d->analysisData.nDeltaFrame;
-			nref = n + offset;
-			if (nref >= 0 && (nref < d->vi.numFrames || !d->vi.numFrames)) {
-				if (n < nref) {
-					vsapi->requestFrameFilter(n, d->node, frameCtx);
-					vsapi->requestFrameFilter(nref, d->node, frameCtx);
-				}
-				else {
-					vsapi->requestFrameFilter(nref, d->node, frameCtx);
-					vsapi->requestFrameFilter(n, d->node, frameCtx);
-				}
-			}
-			else {
-				vsapi->requestFrameFilter(n, d->node, frameCtx);
+		auto first = n;
+		if (d->temporal) {
+			auto cache = d->temporalVectors->Get(n);
+			auto request = new TemporalRequest{ n - n % TemporalVectorCache::Chain, std::vector<std::vector<int32_t>>(rows) };
+			auto guard = std::lock_guard{ cache->lock };
+			if (cache->Follows(request->first, n)) {
+				request->first = cache->frame + 1;
+				request->vectors = cache->vectors;
 			}
+			first = request->first;
+			*frameData = request;
 		}
-		else {
-			nref = -d->analysisData.nDeltaFrame;
-			if (n < nref) {
-				vsapi->requestFrameFilter(n, d->node, frameCtx);
-				vsapi->requestFrameFilter(nref, d->node, frameCtx);
-			}
-			else {
-				vsapi->requestFrameFilter(nref, d->node, frameCtx);
-				vsapi->requestFrameFilter(n, d->node, frameCtx);
+		auto frames = std::vector<int32_t>{};
+		for (auto m : Range{ first, n + 1 }) {
+			frames.push_back(m);
+			for (auto row : Range{ rows }) {
+				auto [isb, delta, nref] = GetReference(d, m, row);
+				if (IsValidFrame(nref) && std::find(frames.begin(), frames.end(), nref) == frames.end())
+					frames.push_back(nref);
 			}
 		}
+		std::sort(frames.begin(), frames.end());
+		for (auto x : frames)
+			vsapi->requestFrameFilter(x, d->node, frameCtx);
 	}
 	else if (activationReason == arAllFramesReady) {
-		GroupOfPlanes *vectorFields = new GroupOfPlanes(d->analysisData.nBlkSizeX, d->analysisData.nBlkSizeY, d->analysisData.nLvCount, d->analysisData.nPel, d->analysisData.nMotionFlags, d->analysisData.nOverlapX, d->analysisData.nOverlapY, d->analysisData.nBlkX, d->analysisData.nBlkY, d->analysisData.xRatioUV, d->analysisData.yRatioUV, d->divideExtra);
-		const uint8_t *pSrc[3] = { nullptr };
-		const uint8_t *pRef[3] = { nullptr };
-		uint8_t *pDst = { nullptr };
-		int32_t nSrcPitch[3] = { 0 };
-		int32_t nRefPitch[3] = { 0 };
-		int32_t nref;
-		if (d->analysisData.nDeltaFrame > 0) {
-			int32_t offset = (d->analysisData.isBackward) ? d->analysisData.nDeltaFrame : -d->analysisData.nDeltaFrame;
-			nref = n + offset;
-		}
-		else
-			nref = -d->analysisData.nDeltaFrame;
+		auto timer = FrameTimer{ d->timing };
+		auto context = d->contexts->Acquire();
+		auto vectorFields = context->vectorFields.get();
+		auto request = std::unique_ptr<TemporalRequest>{ reinterpret_cast<TemporalRequest *>(*frameData) };
+		auto Predictor = [&](auto row) {
+			return request && !request->vectors[row].empty() ? request->vectors[row].data() : nullptr;
+		};
 		const VSFrameRef *src = vsapi->getFrameFilter(n, d->node, frameCtx);
-		const VSMap *srcprops = vsapi->getFramePropsRO(src);
-		int err;
-		bool srctff = !!vsapi->propGetInt(srcprops, "_Field", 0, &err);
-		if (err && d->fields && !d->tffexists) {
-			vsapi->setFilterError("Analyze: _Field property not found in input frame. Therefore, you must pass tff argument.", frameCtx);
-			delete vectorFields;
+		bool srctff;
+		if (!GetFieldOrder(d, src, n, srctff, frameCtx, vsapi)) {
 			vsapi->freeFrame(src);
 			return nullptr;
 		}
-		if (d->tffexists)
-			srctff = !!(static_cast<int>(d->tff) ^ (n % 2));
-		for (int32_t plane = 0; plane < d->supervi->format->numPlanes; plane++) {
-			pSrc[plane] = vsapi->getReadPtr(src, plane);
-			nSrcPitch[plane] = vsapi->getStride(src, plane);
-		}
-		int32_t dst_height = 1;
+		// every row is a complete vector frame, radius mode searches all references of frame n in one go.
+		int32_t dst_height = rows;
 		int32_t dst_width = d->headerSize / sizeof(int32_t) + vectorFields->GetArraySize();
 		dst_width *= 4;
 		VSFrameRef *dst = vsapi->newVideoFrame(d->vi.format, dst_width, dst_height, src, core);
-		pDst = vsapi->getWritePtr(dst, 0);
-		memcpy(pDst, &d->headerSize, sizeof(int32_t));
-		if (d->divideExtra)
-			memcpy(pDst + sizeof(int32_t), &d->analysisDataDivided, sizeof(d->analysisData));
-		else
-			memcpy(pDst + sizeof(int32_t), &d->analysisData, sizeof(d->analysisData));
-		pDst += d->headerSize;
-		if (nref >= 0 && (nref < d->vi.numFrames || !d->vi.numFrames)) {
-			const VSFrameRef *ref = vsapi->getFrameFilter(nref, d->node, frameCtx);
-			const VSMap *refprops = vsapi->getFramePropsRO(ref);
-			bool reftff = !!vsapi->propGetInt(refprops, "_Field", 0, &err);
-			if (err && d->fields && !d->tffexists) {
-				vsapi->setFilterError("Analyze: _Field property not found in input frame. Therefore, you must pass tff argument.", frameCtx);
-				delete vectorFields;
-				vsapi->freeFrame(src);
-				vsapi->freeFrame(ref);
-				vsapi->freeFrame(dst);
-				return nullptr;
+		auto dstPitch = vsapi->getStride(dst, 0);
+		timer.Kernel();
+		auto found = std::vector<std::vector<int32_t>>(rows);
+		auto cache = std::shared_ptr<TemporalVectorCache::Entry>{};
+		auto searching = std::unique_lock<std::mutex>{};
+		if (d->temporal) {
+			cache = d->temporalVectors->Get(n);
+			searching = std::unique_lock{ cache->search };
+			// a frame searched since arInitial may have come closer.
+			{
+				auto guard = std::lock_guard{ cache->lock };
+				if (cache->Follows(request->first, n)) {
+					request->first = cache->frame + 1;
+					request->vectors = cache->vectors;
+				}
 			}
-			if (d->tffexists)
-				reftff = !!(static_cast<int>(d->tff) ^ (nref % 2));
-			int32_t fieldShift = 0;
-			if (d->fields && d->analysisData.nPel > 1 && (d->analysisData.nDeltaFrame % 2))
-				fieldShift = (srctff && !reftff) ? d->analysisData.nPel / 2 : ((reftff && !srctff) ? -(d->analysisData.nPel / 2) : 0);
-			for (int32_t plane = 0; plane < d->supervi->format->numPlanes; plane++) {
-				pRef[plane] = vsapi->getReadPtr(ref, plane);
-				nRefPitch[plane] = vsapi->getStride(ref, plane);
+			// the frames of the chain between the predecessor the cache had and n.
+			for (auto m : Range{ request->first, n }) {
+				const VSFrameRef *earlier = vsapi->getFrameFilter(m, d->node, frameCtx);
+				bool earliertff;
+				auto searched = GetFieldOrder(d, earlier, m, earliertff, frameCtx, vsapi);
+				if (searched)
+					UpdateSource(d, context.get(), earlier, rows, vsapi);
+				for (auto row : Range{ rows }) {
+					found[row].clear();
+					if (!searched || !IsValidFrame(std::get<2>(GetReference(d, m, row))))
+						continue;
+					found[row].resize(vectorFields->GetArraySize());
+					searched = SearchRow(d, context.get(), m, row, earliertff, found[row].data(), Predictor(row), frameCtx, vsapi);
+				}
+				vsapi->freeFrame(earlier);
+				if (!searched) {
+					vsapi->freeFrame(src);
+					vsapi->freeFrame(dst);
+					return nullptr;
+				}
+				std::swap(request->vectors, found);
 			}
-			MVGroupOfFrames *pSrcGOF = new MVGroupOfFrames(d->nSuperLevels, d->analysisData.nWidth, d->analysisData.nHeight, d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, d->analysisData.xRatioUV, d->analysisData.yRatioUV);
-			MVGroupOfFrames *pRefGOF = new MVGroupOfFrames(d->nSuperLevels, d->analysisData.nWidth, d->analysisData.nHeight, d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, d->analysisData.xRatioUV, d->analysisData.yRatioUV);
-			pSrcGOF->Update(d->nModeYUV, (uint8_t *)pSrc[0], nSrcPitch[0], (uint8_t *)pSrc[1], nSrcPitch[1], (uint8_t *)pSrc[2], nSrcPitch[2]);
-			pRefGOF->Update(d->nModeYUV, (uint8_t *)pRef[0], nRefPitch[0], (uint8_t *)pRef[1], nRefPitch[1], (uint8_t *)pRef[2], nRefPitch[2]);
-			DCTClass *DCTc = nullptr;
-			if (d->dctmode != 0)
-				DCTc = new DCTFFTW(d->blksize, d->blksizev, d->dctmode);
-			vectorFields->SearchMVs(pSrcGOF, pRefGOF, d->searchType, d->nSearchParam, d->nPelSearch, d->nLambda, d->lsad, d->pnew, d->plevel, d->global, reinterpret_cast<int32_t*>(pDst), nullptr, fieldShift, DCTc, d->pzero, d->pglobal, d->badSAD, d->badrange, d->meander, nullptr, d->tryMany, d->searchTypeCoarse);
-			if (d->divideExtra)
-				vectorFields->ExtraDivide(reinterpret_cast<int32_t*>(pDst));
-			delete vectorFields;
-			if (DCTc)
-				delete DCTc;
-			delete pSrcGOF;
-			delete pRefGOF;
-			vsapi->freeFrame(ref);
 		}
-		else {
-			vectorFields->WriteDefaultToArray(reinterpret_cast<int32_t*>(pDst));
-			delete vectorFields;
+		UpdateSource(d, context.get(), src, rows, vsapi);
+		for (auto row : Range{ rows }) {
+			auto [isb, delta, nref] = GetReference(d, n, row);
+			auto analysisData = d->divideExtra ? d->analysisDataDivided : d->analysisData;
+			analysisData.nDeltaFrame = delta;
+			analysisData.isBackward = isb;
+			analysisData.nMotionFlags = isb ? (analysisData.nMotionFlags | MOTION_IS_BACKWARD) : (analysisData.nMotionFlags & ~MOTION_IS_BACKWARD);
+			uint8_t *pDst = vsapi->getWritePtr(dst, 0) + row * dstPitch;
+			memcpy(pDst, &d->headerSize, sizeof(int32_t));
+			memcpy(pDst + sizeof(int32_t), &analysisData, sizeof(analysisData));
+			pDst += d->headerSize;
+			auto staticSkipRate = 0.;
+			auto searched = IsValidFrame(nref);
+			found[row].clear();
+			if (searched) {
+				if (!SearchRow(d, context.get(), n, row, srctff, reinterpret_cast<int32_t *>(pDst), Predictor(row), frameCtx, vsapi)) {
+					vsapi->freeFrame(src);
+					vsapi->freeFrame(dst);
+					return nullptr;
+				}
+				if (d->temporal) {
+					auto pVectors = reinterpret_cast<const int32_t *>(pDst);
+					found[row].assign(pVectors, pVectors + vectorFields->GetArraySize());
+				}
+				if (d->divideExtra)
+					vectorFields->ExtraDivide(reinterpret_cast<int32_t*>(pDst));
+				staticSkipRate = vectorFields->GetStaticSkipRate();
+			}
+			else
+				vectorFields->WriteDefaultToArray(reinterpret_cast<int32_t*>(pDst));
+			// one entry per row.
+			if (d->staticRatio > 0)
+				vsapi->propSetFloat(vsapi->getFramePropsRW(dst), "Analyze_staticskip", staticSkipRate, row == 0 ? paReplace : paAppend);
+			if (d->stats)
+				WriteSearchStats(vsapi->getFramePropsRW(dst), vectorFields, d->analysisData.nLvCount, searched, row, vsapi);
 		}
+		if (d->temporal) {
+			auto guard = std::lock_guard{ cache->lock };
+			if (n > cache->frame) {
+				cache->frame = n;
+				cache->vectors = std::move(found);
+			}
+		}
+		timer.Teardown();
 		vsapi->freeFrame(src);
+		timer.Finish(dst, vsapi);
 		return dst;
 	}
+	else if (activationReason == arError)
+		delete reinterpret_cast<TemporalRequest *>(*frameData);
 	return nullptr;
 }
 
 static void VS_CC mvanalyzeFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
 	MVAnalyzeData *d = reinterpret_cast<MVAnalyzeData *>(instanceData);
 	vsapi->freeNode(d->node);
+	delete d->contexts;
+	delete d->temporalVectors;
+	delete d->wavefrontPool;
 	delete d;
 }
 
 auto CreateVector(auto in, auto out, auto core, auto vsapi) {
 	MVAnalyzeData d;
 	int err;
-	d.blksize = int64ToIntS(vsapi->propGetInt(in, "blksize", 0, &err));
-	if (err)
-		d.blksize = 8;
-	d.blksizev = int64ToIntS(vsapi->propGetInt(in, "blksizev", 0, &err));
-	if (err)
-		d.blksizev = d.blksize;
-	d.levels = int64ToIntS(vsapi->propGetInt(in, "levels", 0, &err));
-	d.search = int64ToIntS(vsapi->propGetInt(in, "search", 0, &err));
-	if (err)
-		d.search = 4;
-	d.search_coarse = int64ToIntS(vsapi->propGetInt(in, "search_coarse", 0, &err));
-	if (err)
-		d.search_coarse = 3;
-	d.searchparam = int64ToIntS(vsapi->propGetInt(in, "searchparam", 0, &err));
-	if (err)
-		d.searchparam = 2;
-	d.nPelSearch = int64ToIntS(vsapi->propGetInt(in, "pelsearch", 0, &err));
+	auto parameters = mvsf::AnalyzeParameters{};
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "blksize", 0, &err)); !err)
+		parameters.BlkSize = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "blksizev", 0, &err)); !err)
+		parameters.BlkSizeV = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "levels", 0, &err)); !err)
+		parameters.Levels = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "search", 0, &err)); !err)
+		parameters.Search = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "search_coarse", 0, &err)); !err)
+		parameters.SearchCoarse = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "searchparam", 0, &err)); !err)
+		parameters.SearchParam = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "pelsearch", 0, &err)); !err)
+		parameters.PelSearch = x;
+	if (auto x = !!vsapi->propGetInt(in, "chroma", 0, &err); !err)
+		parameters.Chroma = x;
+	if (auto x = !!vsapi->propGetInt(in, "truemotion", 0, &err); !err)
+		parameters.TrueMotion = x;
+	if (auto x = vsapi->propGetFloat(in, "lambda", 0, &err); !err)
+		parameters.Lambda = x;
+	if (auto x = vsapi->propGetFloat(in, "lsad", 0, &err); !err)
+		parameters.LSAD = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "plevel", 0, &err)); !err)
+		parameters.PLevel = x;
+	if (auto x = !!vsapi->propGetInt(in, "global", 0, &err); !err)
+		parameters.Global = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "pnew", 0, &err)); !err)
+		parameters.PNew = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "pzero", 0, &err)); !err)
+		parameters.PZero = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "pglobal", 0, &err)); !err)
+		parameters.PGlobal = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "overlap", 0, &err)); !err)
+		parameters.Overlap = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "overlapv", 0, &err)); !err)
+		parameters.OverlapV = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "dct", 0, &err)); !err)
+		parameters.DCT = x;
+	if (auto x = vsapi->propGetFloat(in, "badsad", 0, &err); !err)
+		parameters.BadSAD = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "badrange", 0, &err)); !err)
+		parameters.BadRange = x;
+	if (auto x = !!vsapi->propGetInt(in, "meander", 0, &err); !err)
+		parameters.Meander = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "wavefront", 0, &err)); !err)
+		parameters.Wavefront = x;
+	if (auto x = !!vsapi->propGetInt(in, "trymany", 0, &err); !err)
+		parameters.TryMany = x;
+	if (auto x = vsapi->propGetFloat(in, "staticth", 0, &err); !err)
+		parameters.StaticTh = x;
+	if (auto x = vsapi->propGetFloat(in, "prepass", 0, &err); !err)
+		parameters.Prepass = x;
+	ResolveAnalyzeParameters(parameters);
+	d.blksize = parameters.BlkSize;
+	d.blksizev = *parameters.BlkSizeV;
+	d.levels = parameters.Levels;
+	d.search = parameters.Search;
+	d.search_coarse = parameters.SearchCoarse;
+	d.searchparam = parameters.SearchParam;
+	d.nPelSearch = parameters.PelSearch;
+	d.chroma = parameters.Chroma;
+	d.truemotion = parameters.TrueMotion;
+	d.nLambda = *parameters.Lambda;
+	d.lsad = *parameters.LSAD;
+	d.plevel = *parameters.PLevel;
+	d.global = *parameters.Global;
+	d.pnew = *parameters.PNew;
+	d.pzero = *parameters.PZero;
+	d.pglobal = parameters.PGlobal;
+	d.overlap = parameters.Overlap;
+	d.overlapv = *parameters.OverlapV;
+	d.dctmode = parameters.DCT;
+	d.badSAD = parameters.BadSAD;
+	d.badrange = parameters.BadRange;
+	d.meander = parameters.Meander;
+	d.wavefront = parameters.Wavefront;
+	d.tryMany = parameters.TryMany;
+	d.staticRatio = parameters.StaticTh;
+	d.prepass = parameters.Prepass;
 	d.isb = !!vsapi->propGetInt(in, "isb", 0, &err);
-	d.chroma = !!vsapi->propGetInt(in, "chroma", 0, &err);
-	if (err)
-		d.chroma = 1;
 	d.delta = int64ToIntS(vsapi->propGetInt(in, "delta", 0, &err));
 	if (err)
 		d.delta = 1;
-	d.truemotion = !!vsapi->propGetInt(in, "truemotion", 0, &err);
-	if (err)
-		d.truemotion = 1;
-	d.nLambda = vsapi->propGetFloat(in, "lambda", 0, &err);
-	if (err)
-		d.nLambda = d.truemotion ? (1000 * d.blksize * d.blksizev / 64) : 0.;
-	d.lsad = vsapi->propGetFloat(in, "lsad", 0, &err);
-	if (err)
-		d.lsad = d.truemotion ? 1200. : 400.;
-	d.plevel = int64ToIntS(vsapi->propGetInt(in, "plevel", 0, &err));
-	if (err)
-		d.plevel = d.truemotion ? 1 : 0;
-	d.global = !!vsapi->propGetInt(in, "global", 0, &err);
-	if (err)
-		d.global = d.truemotion ? 1 : 0;
-	d.pnew = int64ToIntS(vsapi->propGetInt(in, "pnew", 0, &err));
-	if (err)
-		d.pnew = d.truemotion ? 50 : 0;
-	d.pzero = int64ToIntS(vsapi->propGetInt(in, "pzero", 0, &err));
-	if (err)
-		d.pzero = d.pnew;
-	d.pglobal = int64ToIntS(vsapi->propGetInt(in, "pglobal", 0, &err));
-	d.overlap = int64ToIntS(vsapi->propGetInt(in, "overlap", 0, &err));
-	d.overlapv = int64ToIntS(vsapi->propGetInt(in, "overlapv", 0, &err));
+	d.radius = int64ToIntS(vsapi->propGetInt(in, "radius", 0, &err));
+	if (!err && d.radius <= 0) {
+		vsapi->setError(out, "Analyze: radius must be positive.");
+		return d;
+	}
 	if (err)
-		d.overlapv = d.overlap;
-	d.dctmode = int64ToIntS(vsapi->propGetInt(in, "dct", 0, &err));
+		d.radius = 0;
+	else {
+		d.isb = false;
+		d.delta = 1;
+	}
 	d.divideExtra = int64ToIntS(vsapi->propGetInt(in, "divide", 0, &err));
-	d.badSAD = vsapi->propGetFloat(in, "badsad", 0, &err);
-	if (err)
-		d.badSAD = 10000.;
-	d.badrange = int64ToIntS(vsapi->propGetInt(in, "badrange", 0, &err));
-	if (err)
-		d.badrange = 24;
-	d.meander = !!vsapi->propGetInt(in, "meander", 0, &err);
-	if (err)
-		d.meander = 1;
-	d.tryMany = !!vsapi->propGetInt(in, "trymany", 0, &err);
+	d.wavefrontPool = nullptr;
+	d.contexts = nullptr;
+	d.temporalVectors = nullptr;
+	d.temporal = !!vsapi->propGetInt(in, "temporal", 0, &err);
+	d.stats = !!vsapi->propGetInt(in, "stats", 0, &err);
 	d.fields = !!vsapi->propGetInt(in, "fields", 0, &err);
 	d.tff = !!vsapi->propGetInt(in, "tff", 0, &err);
 	d.tffexists = !err;
-	if (d.search < 0 || d.search > 7) {
-		vsapi->setError(out, "Analyze: search must be between 0 and 7 (inclusive).");
-		return d;
-	}
-	if (d.search_coarse < 0 || d.search_coarse > 7) {
-		vsapi->setError(out, "Analyze: search_coarse must be between 0 and 7 (inclusive).");
-		return d;
-	}
-	if (d.dctmode < 0 || d.dctmode > 10) {
-		vsapi->setError(out, "Analyze: dct must be between 0 and 10 (inclusive).");
-		return d;
-	}
-	if (d.dctmode >= 5 && !((d.blksize == 4 && d.blksizev == 4) ||
-		(d.blksize == 8 && d.blksizev == 8) ||
-		(d.blksize == 16 && d.blksizev == 16) ||
-		(d.blksize == 32 && d.blksizev == 32) ||
-		(d.blksize == 64 && d.blksizev == 64) ||
-		(d.blksize == 128 && d.blksizev == 128) ||
-		(d.blksize == 256 && d.blksizev == 256))) {
-		vsapi->setError(out, "Analyze: dct 5..10 can only work with square blocks.");
-		return d;
-	}
 	if (d.divideExtra < 0 || d.divideExtra > 2) {
 		vsapi->setError(out, "Analyze: divide must be between 0 and 2 (inclusive).");
 		return d;
 	}
-	d.analysisData.nBlkSizeX = d.blksize;
-	d.analysisData.nBlkSizeY = d.blksizev;
-	if ((d.analysisData.nBlkSizeX != 2 || d.analysisData.nBlkSizeY != 2) &&
-		(d.analysisData.nBlkSizeX != 4 || d.analysisData.nBlkSizeY != 4) &&
-		(d.analysisData.nBlkSizeX != 8 || d.analysisData.nBlkSizeY != 4) &&
-		(d.analysisData.nBlkSizeX != 8 || d.analysisData.nBlkSizeY != 8) &&
-		(d.analysisData.nBlkSizeX != 16 || d.analysisData.nBlkSizeY != 2) &&
-		(d.analysisData.nBlkSizeX != 16 || d.analysisData.nBlkSizeY != 8) &&
-		(d.analysisData.nBlkSizeX != 16 || d.analysisData.nBlkSizeY != 16) &&
-		(d.analysisData.nBlkSizeX != 32 || d.analysisData.nBlkSizeY != 32) &&
-		(d.analysisData.nBlkSizeX != 32 || d.analysisData.nBlkSizeY != 16) &&
-		(d.analysisData.nBlkSizeX != 64 || d.analysisData.nBlkSizeY != 32) &&
-		(d.analysisData.nBlkSizeX != 64 || d.analysisData.nBlkSizeY != 64) &&
-		(d.analysisData.nBlkSizeX != 128 || d.analysisData.nBlkSizeY != 64) &&
-		(d.analysisData.nBlkSizeX != 128 || d.analysisData.nBlkSizeY != 128) &&
-		(d.analysisData.nBlkSizeX != 256 || d.analysisData.nBlkSizeY != 128) &&
-		(d.analysisData.nBlkSizeX != 256 || d.analysisData.nBlkSizeY != 256)) {
-		vsapi->setError(out, "Analyze: the block size must be 2x2, 4x4, 8x4, 8x8, 16x2, 16x8, 16x16, 32x16, 32x32, 64x32, 64x64, 128x64, 128x128, 256x128, or 256x256.");
-		return d;
-	}
-	d.analysisData.nDeltaFrame = d.delta;
-	if (d.plevel < 0 || d.plevel > 2) {
-		vsapi->setError(out, "Analyze: plevel must be between 0 and 2 (inclusive).");
-		return d;
-	}
-	if (d.pnew < 0 || d.pnew > 256) {
-		vsapi->setError(out, "Analyze: pnew must be between 0 and 256 (inclusive).");
-		return d;
-	}
-	if (d.pzero < 0 || d.pzero > 256) {
-		vsapi->setError(out, "Analyze: pzero must be between 0 and 256 (inclusive).");
-		return d;
-	}
-	if (d.pglobal < 0 || d.pglobal > 256) {
-		vsapi->setError(out, "Analyze: pglobal must be between 0 and 256 (inclusive).");
-		return d;
-	}
-	if (d.overlap < 0 || d.overlap > d.blksize / 2 ||
-		d.overlapv < 0 || d.overlapv > d.blksizev / 2) {
-		vsapi->setError(out, "Analyze: overlap must be at most half of blksize, overlapv must be at most half of blksizev, and they both need to be at least 0.");
-		return d;
-	}
 	if (d.divideExtra && (d.blksize < 8 || d.blksizev < 8)) {
 		vsapi->setError(out, "Analyze: blksize and blksizev must be at least 8 when divide=True.");
 		return d;
 	}
+	d.analysisData.nBlkSizeX = d.blksize;
+	d.analysisData.nBlkSizeY = d.blksizev;
+	d.analysisData.nDeltaFrame = d.delta;
 	d.analysisData.nOverlapX = d.overlap;
 	d.analysisData.nOverlapY = d.overlapv;
 	d.analysisData.isBackward = d.isb;
-	SearchType searchTypes[] = { ONETIME, NSTEP, LOGARITHMIC, EXHAUSTIVE, HEX2SEARCH, UMHSEARCH, HSEARCH, VSEARCH };
-	d.searchType = searchTypes[d.search];
-	d.searchTypeCoarse = searchTypes[d.search_coarse];
-	if (d.searchType == NSTEP)
-		d.nSearchParam = (d.searchparam < 0) ? 0 : d.searchparam;
-	else
-		d.nSearchParam = (d.searchparam < 1) ? 1 : d.searchparam;
 	d.analysisData.nMagicKey = MotionMagicKey;
 	d.analysisData.nVersion = MVAnalysisDataVersion;
 	d.headerSize = VSMAX(4 + sizeof(d.analysisData), 256);
 
-	auto args = ArgumentList{ in };
-	auto Core = VaporCore{ core };
-	auto sup = static_cast<Clip>(args["super"]);
-	sup = Core["std"]["Expr"]("clips", sup, "expr", "x 255 *");
-	d.node = sup.VideoNode;
-	sup.VideoNode = nullptr;
+	d.node = vsapi->propGetNode(in, "super", 0, nullptr);
 
 	d.supervi = vsapi->getVideoInfo(d.node);
 	d.vi = *d.supervi;
@@ -358,6 +506,14 @@ auto CreateVector(auto in, auto out, auto core, auto vsapi) {
 		vsapi->freeNode(d.node);
 		return d;
 	}
+	if (auto error = CheckAnalyzeParameters(parameters, d.vi.format->subSamplingW, d.vi.format->subSamplingH)) {
+		vsapi->setError(out, (std::string{ "Analyze: " } + error).c_str());
+		vsapi->freeNode(d.node);
+		return d;
+	}
+	d.searchType = SearchTypes[d.search];
+	d.searchTypeCoarse = SearchTypes[d.search_coarse];
+	d.nSearchParam = SearchParameter(d.searchType, d.searchparam);
 	if (d.vi.format->colorFamily == cmGray)
 		d.chroma = 0;
 	if (d.vi.format->colorFamily == cmRGB)
@@ -368,12 +524,6 @@ auto CreateVector(auto in, auto out, auto core, auto vsapi) {
 	d.analysisData.nMotionFlags = 0;
 	d.analysisData.nMotionFlags |= d.analysisData.isBackward ? MOTION_IS_BACKWARD : 0;
 	d.analysisData.nMotionFlags |= d.chroma ? MOTION_USE_CHROMA_MOTION : 0;
-	if (d.overlap % (1 << d.vi.format->subSamplingW) ||
-		d.overlapv % (1 << d.vi.format->subSamplingH)) {
-		vsapi->setError(out, "Analyze: The requested overlap is incompatible with the super clip's subsampling.");
-		vsapi->freeNode(d.node);
-		return d;
-	}
 	if (d.divideExtra && (d.overlap % (2 << d.vi.format->subSamplingW) ||
 		d.overlapv % (2 << d.vi.format->subSamplingH))) {
 		vsapi->setError(out, "Analyze: overlap and overlapv must be multiples of 2 or 4 when divide=True, depending on the super clip's subsampling.");
@@ -459,76 +609,92 @@ auto CreateVector(auto in, auto out, auto core, auto vsapi) {
 		d.analysisDataDivided.nOverlapY = d.analysisData.nOverlapY / 2;
 		d.analysisDataDivided.nLvCount = d.analysisData.nLvCount + 1;
 	}
+	if (d.wavefront > 1)
+		d.wavefrontPool = new ThreadPool{ d.wavefront - 1 };
+	if (d.temporal)
+		d.temporalVectors = new TemporalVectorCache{ static_cast<std::size_t>(vsapi->getCoreInfo(core)->numThreads) };
+	d.contexts = new AnalysisContextPool{ [d] {
+		auto context = new AnalysisContext{};
+		context->vectorFields = std::make_unique<GroupOfPlanes>(d.analysisData.nBlkSizeX, d.analysisData.nBlkSizeY, d.analysisData.nLvCount, d.analysisData.nPel, d.analysisData.nMotionFlags, d.analysisData.nOverlapX, d.analysisData.nOverlapY, d.analysisData.nBlkX, d.analysisData.nBlkY, d.analysisData.xRatioUV, d.analysisData.yRatioUV, d.divideExtra);
+		context->pSrcGOF = std::make_unique<MVGroupOfFrames>(d.nSuperLevels, d.analysisData.nWidth, d.analysisData.nHeight, d.nSuperPel, d.nSuperHPad, d.nSuperVPad, d.nSuperModeYUV, d.analysisData.xRatioUV, d.analysisData.yRatioUV);
+		context->pRefGOF = std::make_unique<MVGroupOfFrames>(d.nSuperLevels, d.analysisData.nWidth, d.analysisData.nHeight, d.nSuperPel, d.nSuperHPad, d.nSuperVPad, d.nSuperModeYUV, d.analysisData.xRatioUV, d.analysisData.yRatioUV);
+		if (d.dctmode != 0)
+			context->DCTc = CreateDCT(d.blksize, d.blksizev, d.dctmode);
+		context->vectorFields->EnableStats(d.stats);
+		return context;
+	} };
 	d.vi.width = d.vi.height = 0;
 	d.vi.format = vsapi->getFormatPreset(pfGray8, core);
 	return d;
 }
 
-static void mvanalyzeCreate(const VSMap* in, VSMap* out, void* userData, VSCore* core, const VSAPI* vsapi) {
-	auto args = ArgumentList{ in };
-	auto Core = VaporCore{ core };
-	auto Eval = [&](auto isb, auto delta) {
-		auto CreateArgumentMap = [&]() {
-			auto Map = vsapi->createMap();
-			for (auto x : Range{ vsapi->propNumKeys(in) }) {
-				auto ItemSrc = ReadonlyItem{ in, vsapi->propGetKey(in, x) };
-				auto ItemDst = WritableItem{ Map, vsapi->propGetKey(in, x) };
-				if (ItemSrc.Type() == VSPropTypes::ptNode)
-					ItemDst = static_cast<Clip>(ItemSrc);
-				else if (ItemSrc.Type() == VSPropTypes::ptInt)
-					ItemDst = static_cast<std::int64_t>(ItemSrc);
-				else if (ItemSrc.Type() == VSPropTypes::ptFloat)
-					ItemDst = static_cast<double>(ItemSrc);
-			}
-			WritableItem{ Map, "isb" } = isb;
-			WritableItem{ Map, "delta" } = delta;
-			return Map;
-		};
-		auto argMap = CreateArgumentMap();
-		auto evalMap = vsapi->createMap();
-
-		auto data = new MVAnalyzeData{ CreateVector(argMap, out, core, vsapi) };
-		if (vsapi->getError(out) != nullptr) {
-			delete data;
-			vsapi->freeMap(argMap);
-			vsapi->freeMap(evalMap);
-			return Clip{};
-		}
-		vsapi->createFilter(argMap, evalMap, "Analyze", mvanalyzeInit, mvanalyzeGetFrame, mvanalyzeFree, fmParallel, 0, data, core);
-		auto vec = vsapi->propGetNode(evalMap, "clip", 0, nullptr);
+// hands out the rows of the radius mode frames one at a time, in mvmulti order.
+struct MVAnalyzeSplitData {
+	VSNodeRef *node;
+	VSVideoInfo vi;
+	int32_t rows;
+};
 
-		vsapi->freeMap(argMap);
-		vsapi->freeMap(evalMap);
-		return Clip{ vec };
-	};
+static void VS_CC mvanalyzeSplitInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
+	MVAnalyzeSplitData *d = reinterpret_cast<MVAnalyzeSplitData *>(*instanceData);
+	vsapi->setVideoInfo(&d->vi, 1, node);
+}
 
-	if (args["radius"].Exists() == false) {
-		auto data = new MVAnalyzeData{ CreateVector(in, out, core, vsapi) };
-		if (vsapi->getError(out) != nullptr) {
-			delete data;
-			return;
+static const VSFrameRef *VS_CC mvanalyzeSplitGetFrame(int32_t n, int32_t activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+	MVAnalyzeSplitData *d = reinterpret_cast<MVAnalyzeSplitData *>(*instanceData);
+	if (activationReason == arInitial)
+		vsapi->requestFrameFilter(n / d->rows, d->node, frameCtx);
+	else if (activationReason == arAllFramesReady) {
+		const VSFrameRef *src = vsapi->getFrameFilter(n / d->rows, d->node, frameCtx);
+		auto row = n % d->rows;
+		auto width = vsapi->getFrameWidth(src, 0);
+		VSFrameRef *dst = vsapi->newVideoFrame(d->vi.format, width, 1, src, core);
+		memcpy(vsapi->getWritePtr(dst, 0), vsapi->getReadPtr(src, 0) + row * vsapi->getStride(src, 0), width);
+		const VSMap *srcprops = vsapi->getFramePropsRO(src);
+		auto dstprops = vsapi->getFramePropsRW(dst);
+		// every row holds the same number of entries of each of these, the copies of all rows that came with the frame
+		// props are dropped.
+		for (auto key : { "Analyze_staticskip", "Analyze_sad", "Analyze_satd", "Analyze_dct", "Analyze_refine", "Analyze_earlyexit", "Analyze_badsad", "Analyze_predictor" }) {
+			auto count = std::max(vsapi->propNumElements(srcprops, key), 0) / d->rows;
+			auto isInt = vsapi->propGetType(srcprops, key) == ptInt;
+			vsapi->propDeleteKey(dstprops, key);
+			for (auto i : Range{ row * count, row * count + count }) {
+				int err;
+				if (isInt)
+					vsapi->propSetInt(dstprops, key, vsapi->propGetInt(srcprops, key, i, &err), paAppend);
+				else
+					vsapi->propSetFloat(dstprops, key, vsapi->propGetFloat(srcprops, key, i, &err), paAppend);
+			}
 		}
-		vsapi->createFilter(in, out, "Analyze", mvanalyzeInit, mvanalyzeGetFrame, mvanalyzeFree, fmParallel, 0, data, core);
+		vsapi->freeFrame(src);
+		return dst;
 	}
-	else {
-		auto radius = static_cast<int>(args["radius"]);
-		if (radius <= 0) {
-			vsapi->setError(out, "Analyze: radius must be positive.");
-			return;
-		}
-		auto mvmulti = std::vector<Clip>{};
-		mvmulti.reserve(2 * radius);
-		for (auto x : Range{ radius, 0, -1 }) {
-			auto v = Eval(true, x);
-			if (v.ContainsVideoReference() == false)
-				return;
-			mvmulti.push_back(std::move(v));
-		}
-		for (auto x : Range{ 1, radius + 1 })
-			mvmulti.push_back(Eval(false, x));
+	return nullptr;
+}
 
-		auto vecs = Core["std"]["Interleave"]("clips", mvmulti);
-		VaporGlobals::API->propSetNode(out, "clip", vecs.VideoNode, VSPropAppendMode::paAppend);
+static void VS_CC mvanalyzeSplitFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
+	MVAnalyzeSplitData *d = reinterpret_cast<MVAnalyzeSplitData *>(instanceData);
+	vsapi->freeNode(d->node);
+	delete d;
+}
+
+static void mvanalyzeCreate(const VSMap* in, VSMap* out, void* userData, VSCore* core, const VSAPI* vsapi) {
+	auto data = new MVAnalyzeData{ CreateVector(in, out, core, vsapi) };
+	if (vsapi->getError(out) != nullptr) {
+		delete data;
+		return;
+	}
+	data->timing = TimingRegistry::Instance().Create("Analyze");
+	auto radius = data->radius;
+	vsapi->createFilter(in, out, "Analyze", mvanalyzeInit, mvanalyzeGetFrame, mvanalyzeFree, fmParallel, 0, data, core);
+	if (radius > 0) {
+		// a single instance searches all 2*radius references of a frame, the split only takes its rows apart.
+		auto split = new MVAnalyzeSplitData{ vsapi->propGetNode(out, "clip", 0, nullptr) };
+		vsapi->propDeleteKey(out, "clip");
+		split->vi = *vsapi->getVideoInfo(split->node);
+		split->rows = 2 * radius;
+		split->vi.numFrames *= split->rows;
+		vsapi->createFilter(in, out, "Analyze", mvanalyzeSplitInit, mvanalyzeSplitGetFrame, mvanalyzeSplitFree, fmParallel, 0, split, core);
 	}
 }
 
@@ -559,7 +725,12 @@ void mvanalyzeRegister(VSRegisterFunction registerFunc, VSPlugin *plugin) {
 		"badsad:float:opt;"
 		"badrange:int:opt;"
 		"meander:int:opt;"
+		"wavefront:int:opt;"
 		"trymany:int:opt;"
+		"temporal:int:opt;"
+		"staticth:float:opt;"
+		"prepass:float:opt;"
+		"stats:int:opt;"
 		"fields:int:opt;"
 		"tff:int:opt;"
 		"search_coarse:int:opt;"
@@ -3,6 +3,7 @@
 #include <cstdlib>
 #include <cstring>
 #include "Overlap.h"
+#include "KernelRegistry.hpp"
 #include "VapourSynth.h"
 #include "VSHelper.h"
 #include "CopyCode.hpp"
@@ -10,6 +11,7 @@
 #include "MaskFun.hpp"
 #include "MVFilter.hpp"
 #include "SimpleResize.hpp"
+#include "FilterTiming.hpp"
 
 struct MVBlockFPSData {
 	VSNodeRef *node;
@@ -53,6 +55,7 @@ struct MVBlockFPSData {
 	OverlapsFunction OVERSLUMA;
 	OverlapsFunction OVERSCHROMA;
 	ToPixelsFunction ToPixels;
+	FilterTiming *timing;
 };
 
 static void VS_CC mvblockfpsInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
@@ -223,6 +226,7 @@ static const VSFrameRef *VS_CC mvblockfpsGetFrame(int32_t n, int32_t activationR
 
 	}
 	else if (activationReason == arAllFramesReady) {
+		auto timer = FrameTimer{ d->timing };
 		int32_t nleft = static_cast<int32_t>(n * d->fa / d->fb);
 		int32_t time256 = static_cast<int32_t>((n * d->fa / static_cast<double>(d->fb) - nleft) * 256 + 0.5);
 		int32_t off = d->mvClipB->GetDeltaFrame();
@@ -294,6 +298,7 @@ static const VSFrameRef *VS_CC mvblockfpsGetFrame(int32_t n, int32_t activationR
 				nRefPitches[i] = vsapi->getStride(ref, i);
 				nSrcPitches[i] = vsapi->getStride(src, i);
 			}
+			timer.Kernel();
 			MVGroupOfFrames *pRefBGOF = new MVGroupOfFrames(nSuperLevels, nWidth, nHeight, nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV, xRatioUV, yRatioUV);
 			MVGroupOfFrames *pRefFGOF = new MVGroupOfFrames(nSuperLevels, nWidth, nHeight, nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV, xRatioUV, yRatioUV);
 			pRefBGOF->Update(nSuperModeYUV, (uint8_t*)pRef[0], nRefPitches[0], (uint8_t*)pRef[1], nRefPitches[1], (uint8_t*)pRef[2], nRefPitches[2]);
@@ -625,6 +630,7 @@ static const VSFrameRef *VS_CC mvblockfpsGetFrame(int32_t n, int32_t activationR
 					delete[] DstTempV;
 				}
 			}
+			timer.Teardown();
 			delete[] MaskFullYB;
 			delete[] MaskFullYF;
 			delete[] MaskOccY;
@@ -642,6 +648,7 @@ static const VSFrameRef *VS_CC mvblockfpsGetFrame(int32_t n, int32_t activationR
 			delete pRefFGOF;
 			vsapi->freeFrame(src);
 			vsapi->freeFrame(ref);
+			timer.Finish(dst, vsapi);
 			return dst;
 		}
 		else {
@@ -660,13 +667,16 @@ static const VSFrameRef *VS_CC mvblockfpsGetFrame(int32_t n, int32_t activationR
 					nRefPitches[i] = vsapi->getStride(ref, i);
 					nSrcPitches[i] = vsapi->getStride(src, i);
 				}
+				timer.Kernel();
 				Blend(pDst[0], pSrc[0], pRef[0], nHeight, nWidth, nDstPitches[0], nSrcPitches[0], nRefPitches[0], time256);
 				if (nSuperModeYUV & UVPLANES) {
 					Blend(pDst[1], pSrc[1], pRef[1], nHeightUV, nWidthUV, nDstPitches[1], nSrcPitches[1], nRefPitches[1], time256);
 					Blend(pDst[2], pSrc[2], pRef[2], nHeightUV, nWidthUV, nDstPitches[2], nSrcPitches[2], nRefPitches[2], time256);
 				}
+				timer.Teardown();
 				vsapi->freeFrame(src);
 				vsapi->freeFrame(ref);
+				timer.Finish(dst, vsapi);
 				return dst;
 			}
 			else
@@ -701,41 +711,9 @@ static void selectFunctions(MVBlockFPSData *d) {
 	const int32_t yRatioUV = d->bleh->yRatioUV;
 	const int32_t nBlkSizeX = d->bleh->nBlkSizeX;
 	const int32_t nBlkSizeY = d->bleh->nBlkSizeY;
-	static OverlapsFunction overs[257][257];
-	overs[2][2] = Overlaps_C<2, 2, double, float>;
-	overs[2][4] = Overlaps_C<2, 4, double, float>;
-	overs[4][2] = Overlaps_C<4, 2, double, float>;
-	overs[4][4] = Overlaps_C<4, 4, double, float>;
-	overs[4][8] = Overlaps_C<4, 8, double, float>;
-	overs[8][1] = Overlaps_C<8, 1, double, float>;
-	overs[8][2] = Overlaps_C<8, 2, double, float>;
-	overs[8][4] = Overlaps_C<8, 4, double, float>;
-	overs[8][8] = Overlaps_C<8, 8, double, float>;
-	overs[8][16] = Overlaps_C<8, 16, double, float>;
-	overs[16][1] = Overlaps_C<16, 1, double, float>;
-	overs[16][2] = Overlaps_C<16, 2, double, float>;
-	overs[16][4] = Overlaps_C<16, 4, double, float>;
-	overs[16][8] = Overlaps_C<16, 8, double, float>;
-	overs[16][16] = Overlaps_C<16, 16, double, float>;
-	overs[16][32] = Overlaps_C<16, 32, double, float>;
-	overs[32][8] = Overlaps_C<32, 8, double, float>;
-	overs[32][16] = Overlaps_C<32, 16, double, float>;
-	overs[32][32] = Overlaps_C<32, 32, double, float>;
-	overs[32][64] = Overlaps_C<32, 64, double, float>;
-	overs[64][16] = Overlaps_C<64, 16, double, float>;
-	overs[64][32] = Overlaps_C<64, 32, double, float>;
-	overs[64][64] = Overlaps_C<64, 64, double, float>;
-	overs[64][128] = Overlaps_C<64, 128, double, float>;
-	overs[128][32] = Overlaps_C<128, 32, double, float>;
-	overs[128][64] = Overlaps_C<128, 64, double, float>;
-	overs[128][128] = Overlaps_C<128, 128, double, float>;
-	overs[128][256] = Overlaps_C<128, 256, double, float>;
-	overs[256][64] = Overlaps_C<256, 64, double, float>;
-	overs[256][128] = Overlaps_C<256, 128, double, float>;
-	overs[256][256] = Overlaps_C<256, 256, double, float>;
 	d->ToPixels = ToPixels<double, float>;
-	d->OVERSLUMA = overs[nBlkSizeX][nBlkSizeY];
-	d->OVERSCHROMA = overs[nBlkSizeX / xRatioUV][nBlkSizeY / yRatioUV];
+	d->OVERSLUMA = GetKernel<KernelKind::Overlaps>(nBlkSizeX, nBlkSizeY);
+	d->OVERSCHROMA = GetKernel<KernelKind::Overlaps>(nBlkSizeX / xRatioUV, nBlkSizeY / yRatioUV);
 }
 
 static void VS_CC mvblockfpsCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
@@ -942,6 +920,7 @@ static void VS_CC mvblockfpsCreate(const VSMap *in, VSMap *out, void *userData,
 	d.dstTempPitchUV = (((d.bleh->nWidth / d.bleh->xRatioUV) + 15) / 16) * 16 * d.vi.format->bytesPerSample * 2;
 	d.nBlkPitch = ((d.bleh->nBlkSizeX + 15) & (~15)) * d.vi.format->bytesPerSample;
 	selectFunctions(&d);
+	d.timing = TimingRegistry::Instance().Create("BlockFPS");
 	data = new MVBlockFPSData;
 	*data = d;
 	vsapi->createFilter(in, out, "BlockFPS", mvblockfpsInit, mvblockfpsGetFrame, mvblockfpsFree, fmParallel, 0, data, core);
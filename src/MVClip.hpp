@@ -10,11 +10,18 @@ class MVClipDicks final :public MVAnalysisData {
 	self(nSCD2, 0.);
 public:
 	MVClipDicks() = default;
+	MVClipDicks(const MVAnalysisData &header, double _nSCD1, double _nSCD2) :MVAnalysisData{ header } {
+		constexpr auto referenceBlockSize = 8 * 8;
+		nBlkCount = nBlkX * nBlkY;
+		nSCD1 = _nSCD1 * (nBlkSizeX * nBlkSizeY) / referenceBlockSize;
+		if (IsChromaMotion())
+			nSCD1 += nSCD1 / (xRatioUV * yRatioUV) * 2;
+		nSCD2 = _nSCD2 * nBlkCount / 256.;
+	}
 	MVClipDicks(VSNodeRef *vectors, double _nSCD1, double _nSCD2, const VSAPI *vsapi) {
 		using namespace std::literals;
 		constexpr auto MaxErrorLength = 1024;
 		constexpr auto maxSAD = 8. * 8. * 255.;
-		constexpr auto referenceBlockSize = 8 * 8;
 		constexpr auto HeaderOffset = sizeof(std::int32_t);
 		auto errorMsg = ""s;
 		errorMsg.reserve(MaxErrorLength);
@@ -28,29 +35,7 @@ public:
 		}
 		if (_nSCD1 > maxSAD)
 			throw MVException{ "thscd1 can be at most " + std::to_string(maxSAD) + "." };
-		nBlkSizeX = pAnalyzeFilter->GetBlkSizeX();
-		nBlkSizeY = pAnalyzeFilter->GetBlkSizeY();
-		nPel = pAnalyzeFilter->GetPel();
-		isBackward = pAnalyzeFilter->IsBackward();
-		nLvCount = pAnalyzeFilter->GetLevelCount();
-		nDeltaFrame = pAnalyzeFilter->GetDeltaFrame();
-		nWidth = pAnalyzeFilter->GetWidth();
-		nHeight = pAnalyzeFilter->GetHeight();
-		nMagicKey = pAnalyzeFilter->GetMagicKey();
-		nOverlapX = pAnalyzeFilter->GetOverlapX();
-		nOverlapY = pAnalyzeFilter->GetOverlapY();
-		xRatioUV = pAnalyzeFilter->GetXRatioUV();
-		yRatioUV = pAnalyzeFilter->GetYRatioUV();
-		nVPadding = pAnalyzeFilter->GetVPadding();
-		nHPadding = pAnalyzeFilter->GetHPadding();
-		nMotionFlags = pAnalyzeFilter->GetMotionFlags();
-		nBlkX = pAnalyzeFilter->GetBlkX();
-		nBlkY = pAnalyzeFilter->GetBlkY();
-		nBlkCount = nBlkX * nBlkY;
-		nSCD1 = _nSCD1 * (nBlkSizeX * nBlkSizeY) / referenceBlockSize;
-		if (pAnalyzeFilter->IsChromaMotion())
-			nSCD1 += nSCD1 / (xRatioUV * yRatioUV) * 2;
-		nSCD2 = _nSCD2 * nBlkCount / 256.;
+		*this = MVClipDicks{ *pAnalyzeFilter, _nSCD1, _nSCD2 };
 		vsapi->freeFrame(evil);
 	}
 	MVClipDicks(MVClipDicks &&) = default;
@@ -93,7 +78,10 @@ public:
 	MVClipBalls(const MVClipBalls &) = delete;
 	~MVClipBalls() = default;
 	auto Update(const VSFrameRef *fn) {
-		auto pMv = reinterpret_cast<const std::int32_t *>(vsapi->getReadPtr(fn, 0));
+		Update(reinterpret_cast<const std::int32_t *>(vsapi->getReadPtr(fn, 0)));
+	}
+	// a vector frame as Analyze writes it, header first.
+	auto Update(const std::int32_t *pMv) -> void {
 		auto _headerSize = pMv[0] / sizeof(std::int32_t);
 		auto nMagicKey = pMv[1];
 		auto nVersion = pMv[2];
@@ -5,8 +5,11 @@
 #include "CopyCode.hpp"
 #include "Overlap.h"
 #include "MVClip.hpp"
+#include "CompensateBlocks.hpp"
 #include "MVFrame.h"
 #include "SADFunctions.hpp"
+#include "KernelRegistry.hpp"
+#include "FilterTiming.hpp"
 
 struct MVCompensateData {
 	VSNodeRef *node;
@@ -38,6 +41,7 @@ struct MVCompensateData {
 	COPYFunction BLITLUMA;
 	COPYFunction BLITCHROMA;
 	ToPixelsFunction ToPixels;
+	FilterTiming *timing;
 };
 
 static void VS_CC mvcompensateInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
@@ -64,17 +68,14 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int32_t n, int32_t activatio
 			vsapi->requestFrameFilter(nref, d->super, frameCtx);
 	}
 	else if (activationReason == arAllFramesReady) {
+		auto timer = FrameTimer{ d->timing };
 		const VSFrameRef *src = vsapi->getFrameFilter(n, d->super, frameCtx);
 		VSFrameRef *dst = vsapi->newVideoFrame(d->vi->format, d->vi->width, d->vi->height, src, core);
-		uint8_t *pDst[3], *pDstCur[3];
+		uint8_t *pDst[3];
 		const uint8_t *pRef[3];
 		int32_t nDstPitches[3], nRefPitches[3];
-		const uint8_t *pSrc[3], *pSrcCur[3];
+		const uint8_t *pSrc[3];
 		int32_t nSrcPitches[3];
-		uint8_t *pDstTemp;
-		uint8_t *pDstTempU;
-		uint8_t *pDstTempV;
-		int32_t blx, bly;
 		const VSFrameRef *mvn = vsapi->getFrameFilter(n, d->vectors, frameCtx);
 		MVClipBalls balls(d->mvClip, vsapi);
 		balls.Update(mvn);
@@ -93,10 +94,6 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int32_t n, int32_t activatio
 		const int32_t yRatioUV = d->bleh->yRatioUV;
 		const int32_t nOverlapX = d->bleh->nOverlapX;
 		const int32_t nOverlapY = d->bleh->nOverlapY;
-		const int32_t nBlkSizeX = d->bleh->nBlkSizeX;
-		const int32_t nBlkSizeY = d->bleh->nBlkSizeY;
-		const int32_t nBlkX = d->bleh->nBlkX;
-		const int32_t nBlkY = d->bleh->nBlkY;
 		const double thSAD = d->thSAD;
 		const int32_t dstTempPitch = d->dstTempPitch;
 		const int32_t dstTempPitchUV = d->dstTempPitchUV;
@@ -107,10 +104,7 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int32_t n, int32_t activatio
 		const int32_t scBehavior = d->scBehavior;
 		const int32_t fields = d->fields;
 		const int32_t time256 = d->time256;
-		int32_t nWidth_B = nBlkX*(nBlkSizeX - nOverlapX) + nOverlapX;
-		int32_t nHeight_B = nBlkY*(nBlkSizeY - nOverlapY) + nOverlapY;
-		int32_t ySubUV = (yRatioUV == 2) ? 1 : 0;
-		int32_t xSubUV = (xRatioUV == 2) ? 1 : 0;
+		timer.Kernel();
 		if (balls.IsUsable()) {
 			const VSFrameRef *ref = vsapi->getFrameFilter(nref, d->super, frameCtx);
 			for (int32_t i = 0; i < d->supervi->format->numPlanes; i++) {
@@ -131,8 +125,6 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int32_t n, int32_t activatio
 			for (int32_t plane = 0; plane < d->supervi->format->numPlanes; ++plane) {
 				pPlanes[plane] = pRefGOF->GetFrame(0)->GetPlane(planes[plane]);
 				pSrcPlanes[plane] = pSrcGOF->GetFrame(0)->GetPlane(planes[plane]);
-				pDstCur[plane] = pDst[plane];
-				pSrcCur[plane] = pSrc[plane];
 			}
 			int32_t fieldShift = 0;
 			if (fields && nPel > 1 && ((nref - n) % 2 != 0)) {
@@ -165,106 +157,6 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int32_t n, int32_t activatio
 					parityRef = !!(static_cast<int>(d->tff) ^ (nref % 2));
 				fieldShift = (paritySrc && !parityRef) ? nPel / 2 : ((parityRef && !paritySrc) ? -(nPel / 2) : 0);
 			}
-			if (nOverlapX == 0 && nOverlapY == 0) {
-				for (int32_t by = 0; by<nBlkY; ++by) {
-					int32_t xx = 0;
-					for (int32_t bx = 0; bx<nBlkX; ++bx) {
-						int32_t i = by*nBlkX + bx;
-						auto &block = balls[0][i];
-						blx = static_cast<int32_t>(block.GetX() * nPel + static_cast<int64_t>(block.GetMV().x) * time256 / 256);
-						bly = static_cast<int32_t>(block.GetY() * nPel + static_cast<int64_t>(block.GetMV().y) * time256 / 256 + fieldShift);
-						if (block.GetSAD() < thSAD) {
-							d->BLITLUMA(pDstCur[0] + xx, nDstPitches[0], pPlanes[0]->GetPointer(blx, bly), pPlanes[0]->GetPitch());
-							if (pPlanes[1]) d->BLITCHROMA(pDstCur[1] + (xx >> xSubUV), nDstPitches[1], pPlanes[1]->GetPointer(blx >> xSubUV, bly >> ySubUV), pPlanes[1]->GetPitch());
-							if (pPlanes[2]) d->BLITCHROMA(pDstCur[2] + (xx >> xSubUV), nDstPitches[2], pPlanes[2]->GetPointer(blx >> xSubUV, bly >> ySubUV), pPlanes[2]->GetPitch());
-						}
-						else {
-							int32_t blxsrc = bx * (nBlkSizeX)* nPel;
-							int32_t blysrc = by * (nBlkSizeY)* nPel + fieldShift;
-							d->BLITLUMA(pDstCur[0] + xx, nDstPitches[0], pSrcPlanes[0]->GetPointer(blxsrc, blysrc), pSrcPlanes[0]->GetPitch());
-							if (pSrcPlanes[1]) d->BLITCHROMA(pDstCur[1] + (xx >> xSubUV), nDstPitches[1], pSrcPlanes[1]->GetPointer(blxsrc >> xSubUV, blysrc >> ySubUV), pSrcPlanes[1]->GetPitch());
-							if (pSrcPlanes[2]) d->BLITCHROMA(pDstCur[2] + (xx >> xSubUV), nDstPitches[2], pSrcPlanes[2]->GetPointer(blxsrc >> xSubUV, blysrc >> ySubUV), pSrcPlanes[2]->GetPitch());
-						}
-						xx += (nBlkSizeX * 4);
-					}
-					pDstCur[0] += (nBlkSizeY)* (nDstPitches[0]);
-					pSrcCur[0] += (nBlkSizeY)* (nSrcPitches[0]);
-					if (nSuperModeYUV & UVPLANES) {
-						pDstCur[1] += (nBlkSizeY >> ySubUV) * (nDstPitches[1]);
-						pDstCur[2] += (nBlkSizeY >> ySubUV) * (nDstPitches[2]);
-						pSrcCur[1] += (nBlkSizeY >> ySubUV) * (nSrcPitches[1]);
-						pSrcCur[2] += (nBlkSizeY >> ySubUV) * (nSrcPitches[2]);
-					}
-				}
-			}
-			else {
-				OverlapWindows *OverWins = d->OverWins;
-				OverlapWindows *OverWinsUV = d->OverWinsUV;
-				uint8_t *DstTemp = new uint8_t[dstTempPitch * nHeight];
-				uint8_t *DstTempU = nullptr;
-				uint8_t *DstTempV = nullptr;
-				if (nSuperModeYUV & UVPLANES) {
-					DstTempU = new uint8_t[dstTempPitchUV * nHeight];
-					DstTempV = new uint8_t[dstTempPitchUV * nHeight];
-				}
-				pDstTemp = DstTemp;
-				pDstTempU = DstTempU;
-				pDstTempV = DstTempV;
-				memset(DstTemp, 0, nHeight_B * dstTempPitch);
-				if (pPlanes[1])
-					memset(DstTempU, 0, (nHeight_B >> ySubUV) * dstTempPitchUV);
-				if (pPlanes[2])
-					memset(DstTempV, 0, (nHeight_B >> ySubUV) * dstTempPitchUV);
-				for (int32_t by = 0; by<nBlkY; by++) {
-					int32_t wby = ((by + nBlkY - 3) / (nBlkY - 2)) * 3;
-					int32_t xx = 0;
-					for (int32_t bx = 0; bx<nBlkX; bx++) {
-						int32_t wbx = (bx + nBlkX - 3) / (nBlkX - 2);
-						auto winOver = OverWins->GetWindow(wby + wbx);
-						auto winOverUV = static_cast<double*>(nullptr);
-						if (nSuperModeYUV & UVPLANES)
-							winOverUV = OverWinsUV->GetWindow(wby + wbx);
-						int32_t i = by*nBlkX + bx;
-						auto &block = balls[0][i];
-						blx = static_cast<int32_t>(block.GetX() * nPel + static_cast<int64_t>(block.GetMV().x) * time256 / 256);
-						bly = static_cast<int32_t>(block.GetY() * nPel + static_cast<int64_t>(block.GetMV().y) * time256 / 256 + fieldShift);
-						if (block.GetSAD() < thSAD) {
-							d->OVERSLUMA(pDstTemp + xx * 2, dstTempPitch, pPlanes[0]->GetPointer(blx, bly), pPlanes[0]->GetPitch(), winOver, nBlkSizeX);
-							if (pPlanes[1]) d->OVERSCHROMA(pDstTempU + (xx >> xSubUV) * 2, dstTempPitchUV, pPlanes[1]->GetPointer(blx >> xSubUV, bly >> ySubUV), pPlanes[1]->GetPitch(), winOverUV, nBlkSizeX >> xSubUV);
-							if (pPlanes[2]) d->OVERSCHROMA(pDstTempV + (xx >> xSubUV) * 2, dstTempPitchUV, pPlanes[2]->GetPointer(blx >> xSubUV, bly >> ySubUV), pPlanes[2]->GetPitch(), winOverUV, nBlkSizeX >> xSubUV);
-						}
-						else {
-							int32_t blxsrc = bx * (nBlkSizeX - nOverlapX) * nPel;
-							int32_t blysrc = by * (nBlkSizeY - nOverlapY) * nPel + fieldShift;
-							d->OVERSLUMA(pDstTemp + xx * 2, dstTempPitch, pSrcPlanes[0]->GetPointer(blxsrc, blysrc), pSrcPlanes[0]->GetPitch(), winOver, nBlkSizeX);
-							if (pSrcPlanes[1]) d->OVERSCHROMA(pDstTempU + (xx >> xSubUV) * 2, dstTempPitchUV, pSrcPlanes[1]->GetPointer(blxsrc >> xSubUV, blysrc >> ySubUV), pSrcPlanes[1]->GetPitch(), winOverUV, nBlkSizeX >> xSubUV);
-							if (pSrcPlanes[2]) d->OVERSCHROMA(pDstTempV + (xx >> xSubUV) * 2, dstTempPitchUV, pSrcPlanes[2]->GetPointer(blxsrc >> xSubUV, blysrc >> ySubUV), pSrcPlanes[2]->GetPitch(), winOverUV, nBlkSizeX >> xSubUV);
-						}
-						xx += (nBlkSizeX - nOverlapX) * 4;
-					}
-					pDstTemp += dstTempPitch*(nBlkSizeY - nOverlapY);
-					pDstCur[0] += (nBlkSizeY - nOverlapY) * (nDstPitches[0]);
-					pSrcCur[0] += (nBlkSizeY - nOverlapY) * (nSrcPitches[0]);
-					if (nSuperModeYUV & UVPLANES) {
-						pDstTempU += dstTempPitchUV*((nBlkSizeY - nOverlapY) >> ySubUV);
-						pDstTempV += dstTempPitchUV*((nBlkSizeY - nOverlapY) >> ySubUV);
-						pDstCur[1] += ((nBlkSizeY - nOverlapY) >> ySubUV) * (nDstPitches[1]);
-						pDstCur[2] += ((nBlkSizeY - nOverlapY) >> ySubUV) * (nDstPitches[2]);
-						pSrcCur[1] += ((nBlkSizeY - nOverlapY) >> ySubUV) * (nSrcPitches[1]);
-						pSrcCur[2] += ((nBlkSizeY - nOverlapY) >> ySubUV) * (nSrcPitches[2]);
-					}
-				}
-				d->ToPixels(pDst[0], nDstPitches[0], DstTemp, dstTempPitch, nWidth_B, nHeight_B);
-				if (pPlanes[1])
-					d->ToPixels(pDst[1], nDstPitches[1], DstTempU, dstTempPitchUV, nWidth_B >> xSubUV, nHeight_B >> ySubUV);
-				if (pPlanes[2])
-					d->ToPixels(pDst[2], nDstPitches[2], DstTempV, dstTempPitchUV, nWidth_B >> xSubUV, nHeight_B >> ySubUV);
-				delete[] DstTemp;
-				if (nSuperModeYUV & UVPLANES) {
-					delete[] DstTempU;
-					delete[] DstTempV;
-				}
-			}
 			const uint8_t *scSrc[3] = { 0 };
 			int32_t scPitches[3] = { 0 };
 			for (int32_t i = 0; i < 3; i++) {
@@ -277,32 +169,18 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int32_t n, int32_t activatio
 					scPitches[i] = nRefPitches[i];
 				}
 			}
-			if (nWidth_B < nWidth) {
-				vs_bitblt(pDst[0] + nWidth_B * 4, nDstPitches[0],
-					scSrc[0] + (nWidth_B + nHPadding) * 4 + nVPadding * scPitches[0], scPitches[0],
-					(nWidth - nWidth_B) * 4, nHeight_B);
-				if (pPlanes[1])
-					vs_bitblt(pDst[1] + (nWidth_B >> xSubUV) * 4, nDstPitches[1],
-						scSrc[1] + ((nWidth_B >> xSubUV) + (nHPadding >> xSubUV)) * 4 + (nVPadding >> ySubUV) * scPitches[1], scPitches[1],
-						((nWidth - nWidth_B) >> xSubUV) * 4, nHeight_B >> ySubUV);
-				if (pPlanes[2])
-					vs_bitblt(pDst[2] + (nWidth_B >> xSubUV) * 4, nDstPitches[2],
-						scSrc[2] + ((nWidth_B >> xSubUV) + (nHPadding >> xSubUV)) * 4 + (nVPadding >> ySubUV) * scPitches[2], scPitches[2],
-						((nWidth - nWidth_B) >> xSubUV) * 4, nHeight_B >> ySubUV);
-			}
-			if (nHeight_B < nHeight) {
-				vs_bitblt(pDst[0] + nHeight_B * nDstPitches[0], nDstPitches[0],
-					scSrc[0] + nHPadding * 4 + (nHeight_B + nVPadding) * scPitches[0], scPitches[0],
-					nWidth * 4, nHeight - nHeight_B);
-				if (pPlanes[1])
-					vs_bitblt(pDst[1] + (nHeight_B >> ySubUV) * nDstPitches[1], nDstPitches[1],
-						scSrc[1] + nHPadding * 4 + ((nHeight_B + nVPadding) >> ySubUV) * scPitches[1], scPitches[1],
-						(nWidth >> xSubUV) * 4, (nHeight - nHeight_B) >> ySubUV);
-				if (pPlanes[2])
-					vs_bitblt(pDst[2] + (nHeight_B >> ySubUV) * nDstPitches[2], nDstPitches[2],
-						scSrc[2] + nHPadding * 4 + ((nHeight_B + nVPadding) >> ySubUV) * scPitches[2], scPitches[2],
-						(nWidth >> xSubUV) * 4, (nHeight - nHeight_B) >> ySubUV);
+			uint8_t *DstTemp[3] = { nullptr };
+			if (nOverlapX || nOverlapY) {
+				DstTemp[0] = new uint8_t[dstTempPitch * nHeight];
+				if (nSuperModeYUV & UVPLANES) {
+					DstTemp[1] = new uint8_t[dstTempPitchUV * nHeight];
+					DstTemp[2] = new uint8_t[dstTempPitchUV * nHeight];
+				}
 			}
+			CompensateBlocks(*d->mvClip, balls, nSuperModeYUV, time256, fieldShift, thSAD, pDst, nDstPitches, pPlanes, pSrcPlanes, scSrc, scPitches,
+				d->BLITLUMA, d->BLITCHROMA, d->OVERSLUMA, d->OVERSCHROMA, d->ToPixels, d->OverWins, d->OverWinsUV, DstTemp, dstTempPitch, dstTempPitchUV);
+			for (int32_t i = 0; i < 3; i++)
+				delete[] DstTemp[i];
 			delete pSrcGOF;
 			delete pRefGOF;
 			vsapi->freeFrame(ref);
@@ -328,7 +206,9 @@ static const VSFrameRef *VS_CC mvcompensateGetFrame(int32_t n, int32_t activatio
 				vs_bitblt(pDst[2], nDstPitches[2], pSrc[2] + nOffset[2], nSrcPitches[2], nWidth * 4 / xRatioUV, nHeight / yRatioUV);
 			}
 		}
+		timer.Teardown();
 		vsapi->freeFrame(src);
+		timer.Finish(dst, vsapi);
 		return dst;
 	}
 	return nullptr;
@@ -354,75 +234,11 @@ static void selectFunctions(MVCompensateData *d) {
 	const int32_t yRatioUV = d->bleh->yRatioUV;
 	const int32_t nBlkSizeX = d->bleh->nBlkSizeX;
 	const int32_t nBlkSizeY = d->bleh->nBlkSizeY;
-	static OverlapsFunction overs[257][257];
-	static COPYFunction copys[257][257];
-	overs[2][2] = Overlaps_C<2, 2, double, float>;
-	copys[2][2] = Copy_C<2, 2>;
-	overs[2][4] = Overlaps_C<2, 4, double, float>;
-	copys[2][4] = Copy_C<2, 4>;
-	overs[4][2] = Overlaps_C<4, 2, double, float>;
-	copys[4][2] = Copy_C<4, 2>;
-	overs[4][4] = Overlaps_C<4, 4, double, float>;
-	copys[4][4] = Copy_C<4, 4>;
-	overs[4][8] = Overlaps_C<4, 8, double, float>;
-	copys[4][8] = Copy_C<4, 8>;
-	overs[8][1] = Overlaps_C<8, 1, double, float>;
-	copys[8][1] = Copy_C<8, 1>;
-	overs[8][2] = Overlaps_C<8, 2, double, float>;
-	copys[8][2] = Copy_C<8, 2>;
-	overs[8][4] = Overlaps_C<8, 4, double, float>;
-	copys[8][4] = Copy_C<8, 4>;
-	overs[8][8] = Overlaps_C<8, 8, double, float>;
-	copys[8][8] = Copy_C<8, 8>;
-	overs[8][16] = Overlaps_C<8, 16, double, float>;
-	copys[8][16] = Copy_C<8, 16>;
-	overs[16][1] = Overlaps_C<16, 1, double, float>;
-	copys[16][1] = Copy_C<16, 1>;
-	overs[16][2] = Overlaps_C<16, 2, double, float>;
-	copys[16][2] = Copy_C<16, 2>;
-	overs[16][4] = Overlaps_C<16, 4, double, float>;
-	copys[16][4] = Copy_C<16, 4>;
-	overs[16][8] = Overlaps_C<16, 8, double, float>;
-	copys[16][8] = Copy_C<16, 8>;
-	overs[16][16] = Overlaps_C<16, 16, double, float>;
-	copys[16][16] = Copy_C<16, 16>;
-	overs[16][32] = Overlaps_C<16, 32, double, float>;
-	copys[16][32] = Copy_C<16, 32>;
-	overs[32][8] = Overlaps_C<32, 8, double, float>;
-	copys[32][8] = Copy_C<32, 8>;
-	overs[32][16] = Overlaps_C<32, 16, double, float>;
-	copys[32][16] = Copy_C<32, 16>;
-	overs[32][32] = Overlaps_C<32, 32, double, float>;
-	copys[32][32] = Copy_C<32, 32>;
-	overs[32][64] = Overlaps_C<32, 64, double, float>;
-	copys[32][64] = Copy_C<32, 64>;
-	overs[64][16] = Overlaps_C<64, 16, double, float>;
-	copys[64][16] = Copy_C<64, 16>;
-	overs[64][32] = Overlaps_C<64, 32, double, float>;
-	copys[64][32] = Copy_C<64, 32>;
-	overs[64][64] = Overlaps_C<64, 64, double, float>;
-	copys[64][64] = Copy_C<64, 64>;
-	overs[64][128] = Overlaps_C<64, 128, double, float>;
-	copys[64][128] = Copy_C<64, 128>;
-	overs[128][32] = Overlaps_C<128, 32, double, float>;
-	copys[128][32] = Copy_C<128, 32>;
-	overs[128][64] = Overlaps_C<128, 64, double, float>;
-	copys[128][64] = Copy_C<128, 64>;
-	overs[128][128] = Overlaps_C<128, 128, double, float>;
-	copys[128][128] = Copy_C<128, 128>;
-	overs[128][256] = Overlaps_C<128, 256, double, float>;
-	copys[128][256] = Copy_C<128, 256>;
-	overs[256][64] = Overlaps_C<256, 64, double, float>;
-	copys[256][64] = Copy_C<256, 64>;
-	overs[256][128] = Overlaps_C<256, 128, double, float>;
-	copys[256][128] = Copy_C<256, 128>;
-	overs[256][256] = Overlaps_C<256, 256, double, float>;
-	copys[256][256] = Copy_C<256, 256>;
 	d->ToPixels = ToPixels<double, float>;
-	d->OVERSLUMA = overs[nBlkSizeX][nBlkSizeY];
-	d->BLITLUMA = copys[nBlkSizeX][nBlkSizeY];
-	d->OVERSCHROMA = overs[nBlkSizeX / xRatioUV][nBlkSizeY / yRatioUV];
-	d->BLITCHROMA = copys[nBlkSizeX / xRatioUV][nBlkSizeY / yRatioUV];
+	d->OVERSLUMA = GetKernel<KernelKind::Overlaps>(nBlkSizeX, nBlkSizeY);
+	d->BLITLUMA = GetKernel<KernelKind::Copy>(nBlkSizeX, nBlkSizeY);
+	d->OVERSCHROMA = GetKernel<KernelKind::Overlaps>(nBlkSizeX / xRatioUV, nBlkSizeY / yRatioUV);
+	d->BLITCHROMA = GetKernel<KernelKind::Copy>(nBlkSizeX / xRatioUV, nBlkSizeY / yRatioUV);
 }
 
 auto CreateCompensate(auto in, auto out, auto vsapi) {
@@ -533,6 +349,7 @@ auto CreateCompensate(auto in, auto out, auto vsapi) {
 	}
 	d.time256 = static_cast<int32_t>(time * 256. / 100.);
 	selectFunctions(&d);
+	d.timing = TimingRegistry::Instance().Create("Compensate");
 	return d;
 }
 
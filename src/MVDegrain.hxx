@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <cstdint>
 #include <cstring>
 #include <vector>
@@ -11,79 +12,12 @@
 #include "MVFilter.hpp"
 #include "MVInterface.h"
 #include "Overlap.h"
+#include "KernelRegistry.hpp"
+#include "FilterTiming.hpp"
+#include "DegrainBlocks.hpp"
+#include "FilterParameters.hpp"
 #include "Interface.vxx"
 
-using DenoiseFunction = auto(*)(int, uint8_t*, int32_t, const uint8_t*, int32_t, const uint8_t**, const int32_t*, double, const double*)->void;
-
-template<int32_t blockWidth, int32_t blockHeight, typename PixelType>
-void Degrain_C(auto radius, uint8_t* pDst8, int32_t nDstPitch, const uint8_t* pSrc8, int32_t nSrcPitch, const uint8_t** pRefs8, const int32_t* nRefPitches, double WSrc, const double* WRefs) {
-	for (int32_t y = 0; y < blockHeight; y++) {
-		for (int32_t x = 0; x < blockWidth; x++) {
-			const PixelType* pSrc = (const PixelType*)pSrc8;
-			PixelType* pDst = (PixelType*)pDst8;
-			double sum = pSrc[x] * WSrc;
-			for (int32_t r = 0; r < radius * 2; r++) {
-				const PixelType* pRef = (const PixelType*)pRefs8[r];
-				sum += pRef[x] * WRefs[r];
-			}
-			pDst[x] = static_cast<PixelType>(sum / 256);
-		}
-		pDst8 += nDstPitch;
-		pSrc8 += nSrcPitch;
-		for (int32_t r = 0; r < radius * 2; r++)
-			pRefs8[r] += nRefPitches[r];
-	}
-}
-
-using LimitFunction = auto(*)(uint8_t*, intptr_t, const uint8_t*, intptr_t, intptr_t, intptr_t, double)->void;
-
-template <typename PixelType>
-static void LimitChanges_C(uint8_t* pDst8, intptr_t nDstPitch, const uint8_t* pSrc8, intptr_t nSrcPitch, intptr_t nWidth, intptr_t nHeight, double nLimit) {
-	for (int32_t h = 0; h < nHeight; h++) {
-		for (int32_t i = 0; i < nWidth; i++) {
-			const PixelType* pSrc = (const PixelType*)pSrc8;
-			PixelType* pDst = (PixelType*)pDst8;
-			pDst[i] = (PixelType)VSMIN(VSMAX(pDst[i], (pSrc[i] - nLimit)), (pSrc[i] + nLimit));
-		}
-		pDst8 += nDstPitch;
-		pSrc8 += nSrcPitch;
-	}
-}
-
-inline double DegrainWeight(double thSAD, double blockSAD) {
-	if (blockSAD >= thSAD)
-		return 0.;
-	return (thSAD - blockSAD) * (thSAD + blockSAD) * 256 / (thSAD * thSAD + blockSAD * blockSAD);
-}
-
-inline void useBlock(const uint8_t*& p, int32_t& np, double& WRef, bool isUsable, const MVClipBalls& mvclip, int32_t i, const MVPlane* pPlane, const uint8_t** pSrcCur, int32_t xx, const int32_t* nSrcPitch, int32_t nLogPel, int32_t plane, int32_t xSubUV, int32_t ySubUV, const double* thSAD) {
-	if (isUsable) {
-		auto& block = mvclip[0][i];
-		int32_t blx = (block.GetX() << nLogPel) + block.GetMV().x;
-		int32_t bly = (block.GetY() << nLogPel) + block.GetMV().y;
-		p = pPlane->GetPointer(plane ? blx >> xSubUV : blx, plane ? bly >> ySubUV : bly);
-		np = pPlane->GetPitch();
-		double blockSAD = block.GetSAD();
-		WRef = DegrainWeight(thSAD[plane], blockSAD);
-	}
-	else {
-		p = pSrcCur[plane] + xx;
-		np = nSrcPitch[plane];
-		WRef = 0.;
-	}
-}
-
-static inline void normalizeWeights(auto radius, double& WSrc, double* WRefs) {
-	WSrc = 256.;
-	double WSum = WSrc + 1.;
-	for (int32_t r = 0; r < radius * 2; r++)
-		WSum += WRefs[r];
-	for (int32_t r = 0; r < radius * 2; r++) {
-		WRefs[r] = WRefs[r] * 256 / WSum;
-		WSrc -= WRefs[r];
-	}
-}
-
 struct MVDegrainData {
 	self(node, Clip{});
 	self(super, Clip{});
@@ -101,23 +35,14 @@ struct MVDegrainData {
 	int32_t nSuperPel;
 	int32_t nSuperModeYUV;
 	int32_t nSuperLevels;
-	int32_t dstTempPitch;
+	DegrainGeometry geometry;
 	OverlapsFunction OVERS[3];
 	DenoiseFunction DEGRAIN[3];
 	LimitFunction LimitChanges;
 	ToPixelsFunction ToPixels;
 	bool process[3];
-	int32_t xSubUV;
-	int32_t ySubUV;
-	int32_t nWidth[3];
-	int32_t nHeight[3];
-	int32_t nOverlapX[3];
-	int32_t nOverlapY[3];
-	int32_t nBlkSizeX[3];
-	int32_t nBlkSizeY[3];
-	int32_t nWidth_B[3];
-	int32_t nHeight_B[3];
 	OverlapWindows* OverWins[3];
+	FilterTiming* timing;
 	template<typename T>
 	auto CreateArray() {
 		auto vec = std::vector<T>{};
@@ -152,16 +77,10 @@ static const VSFrameRef* VS_CC mvdegrainGetFrame(int32_t n, int32_t activationRe
 		d->node.RequestFrame(n, frameCtx);
 	}
 	else if (activationReason == arAllFramesReady) {
+		auto timer = FrameTimer{ d->timing };
 		const VSFrameRef* src = vsapi->getFrameFilter(n, d->node.VideoNode, frameCtx);
 		VSFrameRef* dst = vsapi->newVideoFrame(d->node.format, d->node.width, d->node.height, src, core);
-		uint8_t* pDst[3], * pDstCur[3];
-		const uint8_t* pSrcCur[3];
-		const uint8_t* pSrc[3];
-		auto pRefs = d->CreateFrameArray<const uint8_t*>();
-		int32_t nDstPitches[3], nSrcPitches[3];
-		auto nRefPitches = d->CreateFrameArray<int32_t>();
 		auto isUsable = d->CreateArray<bool>();
-		int32_t nLogPel = (d->bleh->nPel == 4) ? 2 : (d->bleh->nPel == 2) ? 1 : 0;
 		auto balls = d->CreateArray<MVClipBalls*>();
 		auto refFrames = d->CreateArray<const VSFrameRef*>();
 		for (auto& x : refFrames)
@@ -177,135 +96,47 @@ static const VSFrameRef* VS_CC mvdegrainGetFrame(int32_t n, int32_t activationRe
 				refFrames[r] = vsapi->getFrameFilter(n + offset, d->super.VideoNode, frameCtx);
 			}
 		}
-		for (int32_t i = 0; i < d->node.numPlanes; i++) {
-			pDst[i] = vsapi->getWritePtr(dst, i);
-			nDstPitches[i] = vsapi->getStride(dst, i);
-			pSrc[i] = vsapi->getReadPtr(src, i);
-			nSrcPitches[i] = vsapi->getStride(src, i);
-			for (int32_t r = 0; r < d->radius * 2; r++)
-				if (isUsable[r]) {
-					pRefs[i][r] = vsapi->getReadPtr(refFrames[r], i);
-					nRefPitches[i][r] = vsapi->getStride(refFrames[r], i);
-				}
-		}
-		const int32_t xSubUV = d->xSubUV;
-		const int32_t ySubUV = d->ySubUV;
-		const int32_t xRatioUV = d->bleh->xRatioUV;
-		const int32_t yRatioUV = d->bleh->yRatioUV;
-		const int32_t nBlkX = d->bleh->nBlkX;
-		const int32_t nBlkY = d->bleh->nBlkY;
-		const int32_t YUVplanes = d->YUVplanes;
-		const int32_t dstTempPitch = d->dstTempPitch;
-		const int32_t* nWidth = d->nWidth;
-		const int32_t* nHeight = d->nHeight;
-		const int32_t* nOverlapX = d->nOverlapX;
-		const int32_t* nOverlapY = d->nOverlapY;
-		const int32_t* nBlkSizeX = d->nBlkSizeX;
-		const int32_t* nBlkSizeY = d->nBlkSizeY;
-		const int32_t* nWidth_B = d->nWidth_B;
-		const int32_t* nHeight_B = d->nHeight_B;
-		const double* nLimit = d->nLimit;
+		const auto& g = d->geometry;
 		auto pRefGOF = d->CreateArray<MVGroupOfFrames*>();
 		for (int32_t r = 0; r < d->radius * 2; r++)
-			pRefGOF[r] = new MVGroupOfFrames(d->nSuperLevels, nWidth[0], nHeight[0], d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, xRatioUV, yRatioUV);
-		OverlapWindows* OverWins[3] = { d->OverWins[0], d->OverWins[1], d->OverWins[2] };
+			pRefGOF[r] = new MVGroupOfFrames(d->nSuperLevels, g.nWidth[0], g.nHeight[0], d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, d->bleh->xRatioUV, d->bleh->yRatioUV);
 		uint8_t* DstTemp = nullptr;
-		int32_t tmpBlockPitch = nBlkSizeX[0] * 4;
 		uint8_t* tmpBlock = nullptr;
-		if (nOverlapX[0] > 0 || nOverlapY[0] > 0) {
-			DstTemp = new uint8_t[dstTempPitch * nHeight[0]];
-			tmpBlock = new uint8_t[tmpBlockPitch * nBlkSizeY[0]];
+		if (g.nOverlapX[0] > 0 || g.nOverlapY[0] > 0) {
+			DstTemp = new uint8_t[g.dstTempPitch * g.nHeight[0]];
+			tmpBlock = new uint8_t[g.nBlkSizeX[0] * 4 * g.nBlkSizeY[0]];
 		}
 		auto pPlanes = d->CreateFrameArray<MVPlane*>();
 		MVPlaneSet planes[3] = { YPLANE, UPLANE, VPLANE };
 		for (int32_t r = 0; r < d->radius * 2; r++)
 			if (isUsable[r]) {
-				pRefGOF[r]->Update(YUVplanes, (uint8_t*)pRefs[0][r], nRefPitches[0][r], (uint8_t*)pRefs[1][r], nRefPitches[1][r], (uint8_t*)pRefs[2][r], nRefPitches[2][r]);
+				const uint8_t* pRefs[3] = {};
+				int32_t nRefPitches[3] = {};
+				for (int32_t i = 0; i < d->node.numPlanes; i++) {
+					pRefs[i] = vsapi->getReadPtr(refFrames[r], i);
+					nRefPitches[i] = vsapi->getStride(refFrames[r], i);
+				}
+				pRefGOF[r]->Update(d->YUVplanes, (uint8_t*)pRefs[0], nRefPitches[0], (uint8_t*)pRefs[1], nRefPitches[1], (uint8_t*)pRefs[2], nRefPitches[2]);
 				for (int32_t plane = 0; plane < d->node.numPlanes; plane++)
-					if (YUVplanes & planes[plane])
+					if (d->YUVplanes & planes[plane])
 						pPlanes[plane][r] = pRefGOF[r]->GetFrame(0)->GetPlane(planes[plane]);
 			}
-		pDstCur[0] = pDst[0];
-		pDstCur[1] = pDst[1];
-		pDstCur[2] = pDst[2];
-		pSrcCur[0] = pSrc[0];
-		pSrcCur[1] = pSrc[1];
-		pSrcCur[2] = pSrc[2];
+		timer.Kernel();
 		for (int32_t plane = 0; plane < d->node.numPlanes; plane++) {
+			uint8_t* pDst = vsapi->getWritePtr(dst, plane);
+			const uint8_t* pSrc = vsapi->getReadPtr(src, plane);
+			int32_t nDstPitch = vsapi->getStride(dst, plane);
+			int32_t nSrcPitch = vsapi->getStride(src, plane);
 			if (!d->process[plane]) {
-				memcpy(pDstCur[plane], pSrcCur[plane], nSrcPitches[plane] * nHeight[plane]);
+				memcpy(pDst, pSrc, nSrcPitch * g.nHeight[plane]);
 				continue;
 			}
-			if (nOverlapX[0] == 0 && nOverlapY[0] == 0) {
-				for (int32_t by = 0; by < nBlkY; by++) {
-					int32_t xx = 0;
-					for (int32_t bx = 0; bx < nBlkX; bx++) {
-						int32_t i = by * nBlkX + bx;
-						auto pointers = d->CreateArray<const uint8_t*>();
-						auto strides = d->CreateArray<int32_t>();
-						double WSrc;
-						auto WRefs = d->CreateArray<double>();
-						for (int32_t r = 0; r < d->radius * 2; r++)
-							useBlock(pointers[r], strides[r], WRefs[r], isUsable[r], balls[r][0], i, pPlanes[plane][r], pSrcCur, xx, nSrcPitches, nLogPel, plane, xSubUV, ySubUV, d->thSAD[r].data());
-						normalizeWeights(d->radius, WSrc, WRefs.data());
-						d->DEGRAIN[plane](d->radius, pDstCur[plane] + xx, nDstPitches[plane], pSrcCur[plane] + xx, nSrcPitches[plane],
-							pointers.data(), strides.data(),
-							WSrc, WRefs.data());
-						xx += nBlkSizeX[plane] * 4;
-						if (bx == nBlkX - 1 && nWidth_B[0] < nWidth[0])
-							vs_bitblt(pDstCur[plane] + nWidth_B[plane] * 4, nDstPitches[plane],
-								pSrcCur[plane] + nWidth_B[plane] * 4, nSrcPitches[plane],
-								(nWidth[plane] - nWidth_B[plane]) * 4, nBlkSizeY[plane]);
-					}
-					pDstCur[plane] += nBlkSizeY[plane] * (nDstPitches[plane]);
-					pSrcCur[plane] += nBlkSizeY[plane] * (nSrcPitches[plane]);
-					if (by == nBlkY - 1 && nHeight_B[0] < nHeight[0])
-						vs_bitblt(pDstCur[plane], nDstPitches[plane],
-							pSrcCur[plane], nSrcPitches[plane],
-							nWidth[plane] * 4, nHeight[plane] - nHeight_B[plane]);
-				}
-			}
-			else {
-				uint8_t* pDstTemp = DstTemp;
-				memset(pDstTemp, 0, dstTempPitch * nHeight_B[0]);
-				for (int32_t by = 0; by < nBlkY; by++) {
-					int32_t wby = ((by + nBlkY - 3) / (nBlkY - 2)) * 3;
-					int32_t xx = 0;
-					for (int32_t bx = 0; bx < nBlkX; bx++) {
-						int32_t wbx = (bx + nBlkX - 3) / (nBlkX - 2);
-						auto winOver = OverWins[plane]->GetWindow(wby + wbx);
-						int32_t i = by * nBlkX + bx;
-						auto pointers = d->CreateArray<const uint8_t*>();
-						auto strides = d->CreateArray<int32_t>();
-						double WSrc;
-						auto WRefs = d->CreateArray<double>();
-						for (int32_t r = 0; r < d->radius * 2; r++)
-							useBlock(pointers[r], strides[r], WRefs[r], isUsable[r], balls[r][0], i, pPlanes[plane][r], pSrcCur, xx, nSrcPitches, nLogPel, plane, xSubUV, ySubUV, d->thSAD[r].data());
-						normalizeWeights(d->radius, WSrc, WRefs.data());
-						d->DEGRAIN[plane](d->radius, tmpBlock, tmpBlockPitch, pSrcCur[plane] + xx, nSrcPitches[plane],
-							pointers.data(), strides.data(),
-							WSrc, WRefs.data());
-						d->OVERS[plane](pDstTemp + xx * 2, dstTempPitch, tmpBlock, tmpBlockPitch, winOver, nBlkSizeX[plane]);
-						xx += (nBlkSizeX[plane] - nOverlapX[plane]) * 4;
-					}
-					pSrcCur[plane] += (nBlkSizeY[plane] - nOverlapY[plane]) * nSrcPitches[plane];
-					pDstTemp += (nBlkSizeY[plane] - nOverlapY[plane]) * dstTempPitch;
-				}
-				d->ToPixels(pDst[plane], nDstPitches[plane], DstTemp, dstTempPitch, nWidth_B[plane], nHeight_B[plane]);
-				if (nWidth_B[0] < nWidth[0])
-					vs_bitblt(pDst[plane] + nWidth_B[plane] * 4, nDstPitches[plane],
-						pSrc[plane] + nWidth_B[plane] * 4, nSrcPitches[plane],
-						(nWidth[plane] - nWidth_B[plane]) * 4, nHeight_B[plane]);
-				if (nHeight_B[0] < nHeight[0])
-					vs_bitblt(pDst[plane] + nDstPitches[plane] * nHeight_B[plane], nDstPitches[plane],
-						pSrc[plane] + nSrcPitches[plane] * nHeight_B[plane], nSrcPitches[plane],
-						nWidth[plane] * 4, nHeight[plane] - nHeight_B[plane]);
-			}
-			if (nLimit[plane] < std::numeric_limits<double>::infinity())
-				d->LimitChanges(pDst[plane], nDstPitches[plane],
-					pSrc[plane], nSrcPitches[plane],
-					nWidth[plane], nHeight[plane], nLimit[plane]);
+			DegrainPlane(g, plane, d->radius, pDst, nDstPitch, pSrc, nSrcPitch,
+				balls.data(), isUsable, pPlanes[plane].data(), d->thSAD,
+				d->DEGRAIN[plane], d->OVERS[plane], d->OverWins[plane], d->ToPixels, d->LimitChanges, d->nLimit[plane],
+				DstTemp, tmpBlock);
 		}
+		timer.Teardown();
 		if (tmpBlock)
 			delete[] tmpBlock;
 		if (DstTemp)
@@ -317,6 +148,7 @@ static const VSFrameRef* VS_CC mvdegrainGetFrame(int32_t n, int32_t activationRe
 			delete balls[r];
 		}
 		vsapi->freeFrame(src);
+		timer.Finish(dst, vsapi);
 		return dst;
 	}
 	return nullptr;
@@ -324,7 +156,7 @@ static const VSFrameRef* VS_CC mvdegrainGetFrame(int32_t n, int32_t activationRe
 
 static void VS_CC mvdegrainFree(void* instanceData, VSCore* core, const VSAPI* vsapi) {
 	MVDegrainData* d = reinterpret_cast<MVDegrainData*>(instanceData);
-	if (d->nOverlapX[0] || d->nOverlapY[0]) {
+	if (d->geometry.nOverlapX[0] || d->geometry.nOverlapY[0]) {
 		delete d->OverWins[0];
 		if (d->node.colorFamily != cmGray)
 			delete d->OverWins[1];
@@ -338,76 +170,12 @@ static void selectFunctions(MVDegrainData* d) {
 	const int32_t yRatioUV = d->bleh->yRatioUV;
 	const int32_t nBlkSizeX = d->bleh->nBlkSizeX;
 	const int32_t nBlkSizeY = d->bleh->nBlkSizeY;
-	static OverlapsFunction overs[257][257];
-	static DenoiseFunction degs[257][257];
-	overs[2][2] = Overlaps_C<2, 2, double, float>;
-	degs[2][2] = Degrain_C<2, 2, float>;
-	overs[2][4] = Overlaps_C<2, 4, double, float>;
-	degs[2][4] = Degrain_C<2, 4, float>;
-	overs[4][2] = Overlaps_C<4, 2, double, float>;
-	degs[4][2] = Degrain_C<4, 2, float>;
-	overs[4][4] = Overlaps_C<4, 4, double, float>;
-	degs[4][4] = Degrain_C<4, 4, float>;
-	overs[4][8] = Overlaps_C<4, 8, double, float>;
-	degs[4][8] = Degrain_C<4, 8, float>;
-	overs[8][1] = Overlaps_C<8, 1, double, float>;
-	degs[8][1] = Degrain_C<8, 1, float>;
-	overs[8][2] = Overlaps_C<8, 2, double, float>;
-	degs[8][2] = Degrain_C<8, 2, float>;
-	overs[8][4] = Overlaps_C<8, 4, double, float>;
-	degs[8][4] = Degrain_C<8, 4, float>;
-	overs[8][8] = Overlaps_C<8, 8, double, float>;
-	degs[8][8] = Degrain_C<8, 8, float>;
-	overs[8][16] = Overlaps_C<8, 16, double, float>;
-	degs[8][16] = Degrain_C<8, 16, float>;
-	overs[16][1] = Overlaps_C<16, 1, double, float>;
-	degs[16][1] = Degrain_C<16, 1, float>;
-	overs[16][2] = Overlaps_C<16, 2, double, float>;
-	degs[16][2] = Degrain_C<16, 2, float>;
-	overs[16][4] = Overlaps_C<16, 4, double, float>;
-	degs[16][4] = Degrain_C<16, 4, float>;
-	overs[16][8] = Overlaps_C<16, 8, double, float>;
-	degs[16][8] = Degrain_C<16, 8, float>;
-	overs[16][16] = Overlaps_C<16, 16, double, float>;
-	degs[16][16] = Degrain_C<16, 16, float>;
-	overs[16][32] = Overlaps_C<16, 32, double, float>;
-	degs[16][32] = Degrain_C<16, 32, float>;
-	overs[32][8] = Overlaps_C<32, 8, double, float>;
-	degs[32][8] = Degrain_C<32, 8, float>;
-	overs[32][16] = Overlaps_C<32, 16, double, float>;
-	degs[32][16] = Degrain_C<32, 16, float>;
-	overs[32][32] = Overlaps_C<32, 32, double, float>;
-	degs[32][32] = Degrain_C<32, 32, float>;
-	overs[32][64] = Overlaps_C<32, 64, double, float>;
-	degs[32][64] = Degrain_C<32, 64, float>;
-	overs[64][16] = Overlaps_C<64, 16, double, float>;
-	degs[64][16] = Degrain_C<64, 16, float>;
-	overs[64][32] = Overlaps_C<64, 32, double, float>;
-	degs[64][32] = Degrain_C<64, 32, float>;
-	overs[64][64] = Overlaps_C<64, 64, double, float>;
-	degs[64][64] = Degrain_C<64, 64, float>;
-	overs[64][128] = Overlaps_C<64, 128, double, float>;
-	degs[64][128] = Degrain_C<64, 128, float>;
-	overs[128][32] = Overlaps_C<128, 32, double, float>;
-	degs[128][32] = Degrain_C<128, 32, float>;
-	overs[128][64] = Overlaps_C<128, 64, double, float>;
-	degs[128][64] = Degrain_C<128, 64, float>;
-	overs[128][128] = Overlaps_C<128, 128, double, float>;
-	degs[128][128] = Degrain_C<128, 128, float>;
-	overs[128][256] = Overlaps_C<128, 256, double, float>;
-	degs[128][256] = Degrain_C<128, 256, float>;
-	overs[256][64] = Overlaps_C<256, 64, double, float>;
-	degs[256][64] = Degrain_C<256, 64, float>;
-	overs[256][128] = Overlaps_C<256, 128, double, float>;
-	degs[256][128] = Degrain_C<256, 128, float>;
-	overs[256][256] = Overlaps_C<256, 256, double, float>;
-	degs[256][256] = Degrain_C<256, 256, float>;
 	d->LimitChanges = LimitChanges_C<float>;
 	d->ToPixels = ToPixels<double, float>;
-	d->OVERS[0] = overs[nBlkSizeX][nBlkSizeY];
-	d->DEGRAIN[0] = degs[nBlkSizeX][nBlkSizeY];
-	d->OVERS[1] = d->OVERS[2] = overs[nBlkSizeX / xRatioUV][nBlkSizeY / yRatioUV];
-	d->DEGRAIN[1] = d->DEGRAIN[2] = degs[nBlkSizeX / xRatioUV][nBlkSizeY / yRatioUV];
+	d->OVERS[0] = GetKernel<KernelKind::Overlaps>(nBlkSizeX, nBlkSizeY);
+	d->DEGRAIN[0] = GetKernel<KernelKind::Degrain>(nBlkSizeX, nBlkSizeY);
+	d->OVERS[1] = d->OVERS[2] = GetKernel<KernelKind::Overlaps>(nBlkSizeX / xRatioUV, nBlkSizeY / yRatioUV);
+	d->DEGRAIN[1] = d->DEGRAIN[2] = GetKernel<KernelKind::Degrain>(nBlkSizeX / xRatioUV, nBlkSizeY / yRatioUV);
 }
 
 static void VS_CC mvdegrainCreate(const VSMap* in, VSMap* out, void* userData, VSCore* core, const VSAPI* vsapi) {
@@ -420,66 +188,44 @@ static void VS_CC mvdegrainCreate(const VSMap* in, VSMap* out, void* userData, V
 	auto mvmulti = static_cast<Clip>(args["mvmulti"]);
 	d.node = args["clip"];
 	auto radius = mvmulti.FrameCount / d.node.FrameCount / 2;
-	auto thsad = std::array<double, 3>{};
-	auto thsad2 = thsad;
 
 	d.radius = radius;
 	d.vectors.resize(2 * radius);
 	d.mvClips.resize(2 * radius);
-	d.thSAD.resize(2 * radius);
 
-	int err;
-	const int m = vsapi->propNumElements(in, "thsad");
-	const int n = vsapi->propNumElements(in, "limit");
-	for (int i = 0; i < 3; ++i) {
-		if (m == -1)
-			thsad[0] = thsad[1] = thsad[2] = 400.;
-		else
-			if (i < m)
-				thsad[i] = vsapi->propGetFloat(in, "thsad", i, nullptr);
-			else
-				thsad[i] = thsad[i - 1];
-		if (n == -1)
-			d.nLimit[0] = d.nLimit[1] = d.nLimit[2] = std::numeric_limits<double>::infinity();
-		else
-			if (i < n) {
-				d.nLimit[i] = vsapi->propGetFloat(in, "limit", i, nullptr);
-				if (d.nLimit[i] < 0.) {
-					vsapi->setError(out, (filter + ": limit cannot be negative.").c_str());
-					return;
-				}
-			}
-			else
-				d.nLimit[i] = d.nLimit[i - 1];
-	}
-
-	if (auto sad2Count = vsapi->propNumElements(in, "thsad2"); sad2Count == -1) {
-		thsad2[0] = thsad[0];
-		thsad2[1] = thsad[1];
-		thsad2[2] = thsad[2];
-	}
-	else
+	// a list shorter than three repeats its last value for the remaining planes.
+	auto PerPlane = [&](auto key) {
+		auto values = std::array<double, 3>{};
+		auto count = vsapi->propNumElements(in, key);
 		for (auto c : Range{ 3 })
-			if (c < sad2Count)
-				thsad2[c] = vsapi->propGetFloat(in, "thsad2", c, nullptr);
-			else
-				thsad2[c] = thsad2[c - 1];
+			values[c] = c < count ? vsapi->propGetFloat(in, key, c, nullptr) : values[c - 1];
+		return values;
+	};
 
-	int32_t plane = int64ToIntS(vsapi->propGetInt(in, "plane", 0, &err));
-	if (err)
-		plane = 4;
-	d.nSCD1 = vsapi->propGetFloat(in, "thscd1", 0, &err);
-	if (err)
-		d.nSCD1 = MV_DEFAULT_SCD1;
-	d.nSCD2 = vsapi->propGetFloat(in, "thscd2", 0, &err);
-	if (err)
-		d.nSCD2 = MV_DEFAULT_SCD2;
-	if (plane < 0 || plane > 4) {
-		vsapi->setError(out, (filter + ": plane must be between 0 and 4 (inclusive).").c_str());
+	int err;
+	auto parameters = mvsf::DegrainParameters{};
+	if (vsapi->propNumElements(in, "thsad") > 0)
+		parameters.ThSAD = PerPlane("thsad");
+	if (vsapi->propNumElements(in, "thsad2") > 0)
+		parameters.ThSAD2 = PerPlane("thsad2");
+	if (vsapi->propNumElements(in, "limit") > 0)
+		parameters.Limit = PerPlane("limit");
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "plane", 0, &err)); !err)
+		parameters.Plane = x;
+	if (auto x = vsapi->propGetFloat(in, "thscd1", 0, &err); !err)
+		parameters.ThSCD1 = x;
+	if (auto x = vsapi->propGetFloat(in, "thscd2", 0, &err); !err)
+		parameters.ThSCD2 = x;
+	if (auto error = CheckDegrainParameters(parameters)) {
+		vsapi->setError(out, (filter + ": " + error).c_str());
 		return;
 	}
-	int32_t planes[5] = { YPLANE, UPLANE, VPLANE, UVPLANES, YUVPLANES };
-	d.YUVplanes = planes[plane];
+	for (auto c : Range{ 3 })
+		d.nLimit[c] = parameters.Limit ? (*parameters.Limit)[c] : std::numeric_limits<double>::infinity();
+	d.nSCD1 = parameters.ThSCD1;
+	d.nSCD2 = parameters.ThSCD2;
+	d.YUVplanes = DegrainPlanes(parameters);
+	d.thSAD = DegrainThSAD(parameters, radius);
 	d.super = args["super"];
 	char errorMsg[1024];
 	const VSFrameRef* evil = vsapi->getFrame(0, d.super.VideoNode, errorMsg, 1024);
@@ -514,8 +260,6 @@ static void VS_CC mvdegrainCreate(const VSMap* in, VSMap* out, void* userData, V
 	for (auto r : Range{ radius }) {
 		d.vectors[2 * r] = bvn(r + 1);
 		d.vectors[2 * r + 1] = fvn(r + 1);
-		for (auto c : Range{ 3 })
-			d.thSAD[2 * r + 1][c] = d.thSAD[2 * r][c] = CosineAnnealing(thsad[c], thsad2[c], r + 1, radius);
 	}
 
 	for (int32_t r = 0; r < radius * 2; r++) {
@@ -561,36 +305,20 @@ static void VS_CC mvdegrainCreate(const VSMap* in, VSMap* out, void* userData, V
 		delete d.bleh;
 		return;
 	}
-	d.dstTempPitch = ((d.bleh->nWidth + 15) / 16) * 16 * 4 * 2;
 	d.process[0] = d.node.colorFamily == cmRGB ? true : !!(d.YUVplanes & YPLANE);
 	d.process[1] = d.node.colorFamily == cmRGB ? true : !!(d.YUVplanes & UPLANE & d.nSuperModeYUV);
 	d.process[2] = d.node.colorFamily == cmRGB ? true : !!(d.YUVplanes & VPLANE & d.nSuperModeYUV);
-	d.xSubUV = d.node.subSamplingW;
-	d.ySubUV = d.node.subSamplingH;
-	d.nWidth[0] = d.bleh->nWidth;
-	d.nWidth[1] = d.nWidth[2] = d.nWidth[0] >> d.xSubUV;
-	d.nHeight[0] = d.bleh->nHeight;
-	d.nHeight[1] = d.nHeight[2] = d.nHeight[0] >> d.ySubUV;
-	d.nOverlapX[0] = d.bleh->nOverlapX;
-	d.nOverlapX[1] = d.nOverlapX[2] = d.nOverlapX[0] >> d.xSubUV;
-	d.nOverlapY[0] = d.bleh->nOverlapY;
-	d.nOverlapY[1] = d.nOverlapY[2] = d.nOverlapY[0] >> d.ySubUV;
-	d.nBlkSizeX[0] = d.bleh->nBlkSizeX;
-	d.nBlkSizeX[1] = d.nBlkSizeX[2] = d.nBlkSizeX[0] >> d.xSubUV;
-	d.nBlkSizeY[0] = d.bleh->nBlkSizeY;
-	d.nBlkSizeY[1] = d.nBlkSizeY[2] = d.nBlkSizeY[0] >> d.ySubUV;
-	d.nWidth_B[0] = d.bleh->nBlkX * (d.nBlkSizeX[0] - d.nOverlapX[0]) + d.nOverlapX[0];
-	d.nWidth_B[1] = d.nWidth_B[2] = d.nWidth_B[0] >> d.xSubUV;
-	d.nHeight_B[0] = d.bleh->nBlkY * (d.nBlkSizeY[0] - d.nOverlapY[0]) + d.nOverlapY[0];
-	d.nHeight_B[1] = d.nHeight_B[2] = d.nHeight_B[0] >> d.ySubUV;
-	if (d.nOverlapX[0] || d.nOverlapY[0]) {
-		d.OverWins[0] = new OverlapWindows(d.nBlkSizeX[0], d.nBlkSizeY[0], d.nOverlapX[0], d.nOverlapY[0]);
+	d.geometry = MakeDegrainGeometry(d.mvClips[0], d.node.subSamplingW, d.node.subSamplingH);
+	auto& g = d.geometry;
+	if (g.nOverlapX[0] || g.nOverlapY[0]) {
+		d.OverWins[0] = new OverlapWindows(g.nBlkSizeX[0], g.nBlkSizeY[0], g.nOverlapX[0], g.nOverlapY[0]);
 		if (d.node.colorFamily != cmGray) {
-			d.OverWins[1] = new OverlapWindows(d.nBlkSizeX[1], d.nBlkSizeY[1], d.nOverlapX[1], d.nOverlapY[1]);
+			d.OverWins[1] = new OverlapWindows(g.nBlkSizeX[1], g.nBlkSizeY[1], g.nOverlapX[1], g.nOverlapY[1]);
 			d.OverWins[2] = d.OverWins[1];
 		}
 	}
 	selectFunctions(&d);
+	d.timing = TimingRegistry::Instance().Create(filter.c_str());
 	data = new MVDegrainData;
 	*data = d;
 	vsapi->createFilter(in, out, filter.c_str(), mvdegrainInit, mvdegrainGetFrame, mvdegrainFree, fmParallel, 0, data, core);
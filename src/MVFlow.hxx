@@ -5,6 +5,7 @@
 #include "MaskFun.hpp"
 #include "MVFilter.hpp"
 #include "SimpleResize.hpp"
+#include "FilterTiming.hpp"
 
 using FlowFunction = auto (*)(uint8_t *, int32_t, const uint8_t *, int32_t, int32_t *, int32_t, int32_t *, int32_t, int32_t, int32_t, int32_t, int32_t)->void;
 
@@ -44,6 +45,7 @@ struct MVFlowData final {
 	SimpleResize<int32_t> *upsizer;
 	SimpleResize<int32_t> *upsizerUV;
 	FlowFunction flow_function;
+	FilterTiming *timing;
 };
 
 static auto VS_CC mvflowInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
@@ -127,6 +129,7 @@ if (activationReason == arInitial) {
 	vsapi->requestFrameFilter(n, d->clip, frameCtx);
 }
 else if (activationReason == arAllFramesReady) {
+	auto timer = FrameTimer{ d->timing };
 	auto offset = d->mvClip->GetDeltaFrame();
 	decltype(offset) nref;
 	if (offset > 0)
@@ -175,6 +178,7 @@ else if (activationReason == arAllFramesReady) {
 		auto VYFullY = new int32_t[nHeightP * VPitchY];
 		auto VXSmallY = new int32_t[nBlkYP * nBlkXP];
 		auto VYSmallY = new int32_t[nBlkYP * nBlkXP];
+		timer.Kernel();
 		MakeVectorSmallMasks(balls, nBlkX, nBlkY, VXSmallY, nBlkXP, VYSmallY, nBlkXP);
 		CheckAndPadSmallY(VXSmallY, VYSmallY, nBlkXP, nBlkYP, nBlkX, nBlkY);
 		auto fieldShift = 0;
@@ -246,11 +250,13 @@ else if (activationReason == arAllFramesReady) {
 			delete[] VXSmallUV;
 			delete[] VYSmallUV;
 		}
+		timer.Teardown();
 		delete[] VXFullY;
 		delete[] VYFullY;
 		delete[] VXSmallY;
 		delete[] VYSmallY;
 		vsapi->freeFrame(ref);
+		timer.Finish(dst, vsapi);
 		return dst;
 	}
 	else
@@ -422,6 +428,7 @@ auto CreateFlow(auto in, auto out, auto core, auto vsapi) {
 		d.flow_function = flowFetch;
 	else if (static_cast<FlowModes>(d.mode) == FlowModes::Shift)
 		d.flow_function = flowShift;
+	d.timing = TimingRegistry::Instance().Create("Flow");
 	return d;
 }
 
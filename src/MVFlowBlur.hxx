@@ -8,6 +8,7 @@
 #include "MaskFun.hpp"
 #include "MVFilter.hpp"
 #include "SimpleResize.hpp"
+#include "FilterTiming.hpp"
 
 struct MVFlowBlurData {
 	VSNodeRef *node;
@@ -33,6 +34,7 @@ struct MVFlowBlurData {
 	int32_t blur256;
 	SimpleResize<int32_t> *upsizer;
 	SimpleResize<int32_t> *upsizerUV;
+	FilterTiming *timing;
 };
 
 static void VS_CC mvflowblurInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
@@ -219,6 +221,7 @@ static const VSFrameRef *VS_CC mvflowblurGetFrame(int32_t n, int32_t activationR
 		vsapi->requestFrameFilter(n, d->node, frameCtx);
 	}
 	else if (activationReason == arAllFramesReady) {
+		auto timer = FrameTimer{ d->timing };
 		uint8_t *pDst[3];
 		const uint8_t *pRef[3];
 		int32_t nDstPitches[3];
@@ -289,6 +292,7 @@ static const VSFrameRef *VS_CC mvflowblurGetFrame(int32_t n, int32_t activationR
 			auto *VYSmallYB = new int32_t[nBlkX * nBlkY];
 			auto *VXSmallYF = new int32_t[nBlkX * nBlkY];
 			auto *VYSmallYF = new int32_t[nBlkX * nBlkY];
+			timer.Kernel();
 
 			MakeVectorSmallMasks(ballsB, nBlkX, nBlkY, VXSmallYB, nBlkX, VYSmallYB, nBlkX);
 			MakeVectorSmallMasks(ballsF, nBlkX, nBlkY, VXSmallYF, nBlkX, VYSmallYF, nBlkX);
@@ -345,6 +349,7 @@ static const VSFrameRef *VS_CC mvflowblurGetFrame(int32_t n, int32_t activationR
 				delete[] VXSmallUVF;
 				delete[] VYSmallUVF;
 			}
+			timer.Teardown();
 
 			delete[] VXFullYB;
 			delete[] VYFullYB;
@@ -356,6 +361,7 @@ static const VSFrameRef *VS_CC mvflowblurGetFrame(int32_t n, int32_t activationR
 			delete[] VYSmallYF;
 
 			vsapi->freeFrame(ref);
+			timer.Finish(dst, vsapi);
 
 			return dst;
 		}
@@ -617,6 +623,7 @@ static void VS_CC mvflowblurCreate(const VSMap *in, VSMap *out, void *userData,
 	d.upsizer = new SimpleResize<int32_t>(d.bleh->nWidth, d.bleh->nHeight, d.bleh->nBlkX, d.bleh->nBlkY, d.mvClipB->nWidth, d.mvClipB->nHeight, d.mvClipB->nPel);
 	if (d.vi->format->colorFamily != cmGray)
 		d.upsizerUV = new SimpleResize<int32_t>(d.nWidthUV, d.nHeightUV, d.bleh->nBlkX, d.bleh->nBlkY, d.nWidthUV, d.nHeightUV, d.mvClipB->nPel);
+	d.timing = TimingRegistry::Instance().Create("FlowBlur");
 	data = new MVFlowBlurData;
 	*data = d;
 	vsapi->createFilter(in, out, "FlowBlur", mvflowblurInit, mvflowblurGetFrame, mvflowblurFree, fmParallel, 0, data, core);
@@ -8,6 +8,7 @@
 #include "MaskFun.hpp"
 #include "MVFilter.hpp"
 #include "SimpleResize.hpp"
+#include "FilterTiming.hpp"
 
 struct MVFlowFPSData {
 	VSNodeRef *node;
@@ -82,6 +83,7 @@ struct MVFlowFPSData {
 	SimpleResize<double> *upsizerUV2;
 	int64_t fa, fb;
 	int32_t nleftLast, nrightLast;
+	FilterTiming *timing;
 };
 
 static void VS_CC mvflowfpsInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
@@ -130,6 +132,7 @@ static const VSFrameRef *VS_CC mvflowfpsGetFrame(int32_t n, int32_t activationRe
 
 	}
 	else if (activationReason == arAllFramesReady) {
+		auto timer = FrameTimer{ d->timing };
 		int32_t nleft = static_cast<int32_t>(n * d->fa / d->fb);
 		// intermediate product may be very large! Now I know how to multiply int64
 		int32_t time256 = static_cast<int32_t>((n * d->fa / static_cast<double>(d->fb) - nleft) * 256 + 0.5);
@@ -259,6 +262,7 @@ static const VSFrameRef *VS_CC mvflowfpsGetFrame(int32_t n, int32_t activationRe
 
 			int32_t nOffsetY = nRefPitches[0] * nVPadding * nPel + nHPadding * bytesPerSample * nPel;
 			int32_t nOffsetUV = nRefPitches[1] * nVPaddingUV * nPel + nHPaddingUV * bytesPerSample * nPel;
+			timer.Kernel();
 
 			if (nright != d->nrightLast) {
 				MakeVectorSmallMasks(ballsB, nBlkX, nBlkY, VXSmallYB, nBlkXP, VYSmallYB, nBlkXP);
@@ -384,9 +388,11 @@ static const VSFrameRef *VS_CC mvflowfpsGetFrame(int32_t n, int32_t activationRe
 						nWidthUV, nHeightUV, time256, nPel);
 				}
 			}
+			timer.Teardown();
 
 			vsapi->freeFrame(src);
 			vsapi->freeFrame(ref);
+			timer.Finish(dst, vsapi);
 
 			return dst;
 		}
@@ -412,14 +418,17 @@ static const VSFrameRef *VS_CC mvflowfpsGetFrame(int32_t n, int32_t activationRe
 				}
 
 				// blend with time weight
+				timer.Kernel();
 				Blend(pDst[0], pSrc[0], pRef[0], nHeight, nWidth, nDstPitches[0], nSrcPitches[0], nRefPitches[0], time256);
 				if (d->vi.format->colorFamily != cmGray) {
 					Blend(pDst[1], pSrc[1], pRef[1], nHeightUV, nWidthUV, nDstPitches[1], nSrcPitches[1], nRefPitches[1], time256);
 					Blend(pDst[2], pSrc[2], pRef[2], nHeightUV, nWidthUV, nDstPitches[2], nSrcPitches[2], nRefPitches[2], time256);
 				}
+				timer.Teardown();
 
 				vsapi->freeFrame(src);
 				vsapi->freeFrame(ref);
+				timer.Finish(dst, vsapi);
 
 				return dst;
 			}
@@ -897,6 +906,7 @@ static void VS_CC mvflowfpsCreate(const VSMap *in, VSMap *out, void *userData, V
 	d.nrightLast = -1000;
 
 
+	d.timing = TimingRegistry::Instance().Create("FlowFPS");
 	data = new MVFlowFPSData;
 	*data = d;
 
@@ -8,6 +8,7 @@
 #include "MVFilter.hpp"
 #include "MVInterface.h"
 #include "SimpleResize.hpp"
+#include "FilterTiming.hpp"
 
 struct MVFlowInterData {
 	VSNodeRef *node;
@@ -42,6 +43,7 @@ struct MVFlowInterData {
 	SimpleResize<double> *upsizer2;
 	SimpleResize<int32_t> *upsizerUV;
 	SimpleResize<double> *upsizerUV2;
+	FilterTiming *timing;
 };
 
 static void VS_CC mvflowinterInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
@@ -70,6 +72,7 @@ static const VSFrameRef *VS_CC mvflowinterGetFrame(int32_t n, int32_t activation
 		vsapi->requestFrameFilter(d->vi->numFrames ? VSMIN(n + off, d->vi->numFrames - 1) : n + off, d->node, frameCtx);
 	}
 	else if (activationReason == arAllFramesReady) {
+		auto timer = FrameTimer{ d->timing };
 		uint8_t *pDst[3];
 		const uint8_t *pRef[3], *pSrc[3];
 		int32_t nDstPitches[3];
@@ -147,6 +150,7 @@ static const VSFrameRef *VS_CC mvflowinterGetFrame(int32_t n, int32_t activation
 
 			int32_t nOffsetY = nRefPitches[0] * nVPadding * nPel + nHPadding * bytesPerSample * nPel;
 			int32_t nOffsetUV = nRefPitches[1] * nVPaddingUV * nPel + nHPaddingUV * bytesPerSample * nPel;
+			timer.Kernel();
 
 
 			auto VXFullYB = new int32_t[nHeightP * VPitchY];
@@ -314,6 +318,7 @@ static const VSFrameRef *VS_CC mvflowinterGetFrame(int32_t n, int32_t activation
 						nWidthUV, nHeightUV, time256, nPel);
 				}
 			}
+			timer.Teardown();
 
 
 			delete[] VXFullYB;
@@ -344,6 +349,7 @@ static const VSFrameRef *VS_CC mvflowinterGetFrame(int32_t n, int32_t activation
 
 			vsapi->freeFrame(src);
 			vsapi->freeFrame(ref);
+			timer.Finish(dst, vsapi);
 
 			return dst;
 		}
@@ -369,14 +375,17 @@ static const VSFrameRef *VS_CC mvflowinterGetFrame(int32_t n, int32_t activation
 				}
 
 				// blend with time weight
+				timer.Kernel();
 				Blend(pDst[0], pSrc[0], pRef[0], nHeight, nWidth, nDstPitches[0], nSrcPitches[0], nRefPitches[0], time256);
 				if (d->vi->format->colorFamily != cmGray) {
 					Blend(pDst[1], pSrc[1], pRef[1], nHeightUV, nWidthUV, nDstPitches[1], nSrcPitches[1], nRefPitches[1], time256);
 					Blend(pDst[2], pSrc[2], pRef[2], nHeightUV, nWidthUV, nDstPitches[2], nSrcPitches[2], nRefPitches[2], time256);
 				}
+				timer.Teardown();
 
 				vsapi->freeFrame(src);
 				vsapi->freeFrame(ref);
+				timer.Finish(dst, vsapi);
 
 				return dst;
 			}
@@ -645,6 +654,7 @@ static void VS_CC mvflowinterCreate(const VSMap *in, VSMap *out, void *userData,
 		d.upsizerUV = new SimpleResize<int32_t>(d.nWidthPUV, d.nHeightPUV, d.nBlkXP, d.nBlkYP, d.nWidthUV, d.nHeightUV, d.mvClipB->nPel);
 		d.upsizerUV2 = new SimpleResize<double>(d.nWidthPUV, d.nHeightPUV, d.nBlkXP, d.nBlkYP, 0, 0, 0);
 	}
+	d.timing = TimingRegistry::Instance().Create("FlowInter");
 	data = new MVFlowInterData;
 	*data = d;
 	vsapi->createFilter(in, out, "FlowInter", mvflowinterInit, mvflowinterGetFrame, mvflowinterFree, fmParallel, 0, data, core);
@@ -1,6 +1,12 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstdint>
 #include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include "VSHelper.h"
 #include "Padding.h"
 #include "Interpolation.h"
@@ -60,6 +66,28 @@ class MVPlane {
 	bool isPadded;
 	bool isRefined;
 	bool isFilled;
+	// one summed-area table per sub-plane, built the first time a block sum of that sub-plane is asked for.
+	std::mutex summedAreaLock;
+	std::unique_ptr<std::atomic<bool>[]> summedAreaReady;
+	std::vector<std::vector<uint32_t>> summedAreas;
+	// the table covers the padded plane and has an extra zero row and column in front. samples are stored in fixed
+	// point with SummedAreaBits fraction bits and summed modulo 2^32, which halves the size of a double table: the
+	// difference of four entries is still the exact sum of the block as long as that fits in an int32_t, which holds
+	// for any block up to 256x256 with the samples clamped to [-2, 2).
+	static constexpr auto SummedAreaBits = 14;
+	void BuildSummedArea(int32_t idx) {
+		auto stride = nExtendedWidth + 1;
+		auto& table = summedAreas[idx];
+		table.assign(stride * (nExtendedHeight + 1), 0);
+		for (int32_t h = 0; h < nExtendedHeight; h++) {
+			auto pRow = reinterpret_cast<const float*>(pPlane[idx] + h * nPitch);
+			auto rowSum = 0u;
+			for (int32_t w = 0; w < nExtendedWidth; w++) {
+				rowSum += static_cast<uint32_t>(std::lrint(std::clamp(pRow[w], -2.f, 2.f - 1.f / (1 << SummedAreaBits)) * (1 << SummedAreaBits)));
+				table[(h + 1) * stride + w + 1] = table[h * stride + w + 1] + rowSum;
+			}
+		}
+	}
 	template <typename PixelType>
 	void RefineExtPel2(const uint8_t* pSrc2x8, int32_t nSrc2xPitch, bool isExtPadded) {
 		const PixelType* pSrc2x = (const PixelType*)pSrc2x8;
@@ -154,6 +182,8 @@ public:
 		nExtendedWidth = nWidth + 2 * nHPadding;
 		nExtendedHeight = nHeight + 2 * nVPadding;
 		pPlane = new uint8_t * [nPel * nPel];
+		summedAreaReady = std::make_unique<std::atomic<bool>[]>(nPel * nPel);
+		summedAreas.resize(nPel * nPel);
 	}
 	~MVPlane() {
 		delete[] pPlane;
@@ -164,6 +194,8 @@ public:
 
 		for (int32_t i = 0; i < nPel * nPel; i++)
 			pPlane[i] = pSrc + i * nPitch * nExtendedHeight;
+		for (int32_t i = 0; i < nPel * nPel; i++)
+			summedAreaReady[i].store(false, std::memory_order_relaxed);
 
 		ResetState();
 		//   LeaveCriticalSection(&cs);
@@ -355,6 +387,32 @@ public:
 	inline const uint8_t *GetAbsolutePelPointer(int32_t nX, int32_t nY) const {
 		return pPlane[0] + nX * 4 + nY * nPitch;
 	}
+	// sum of the nBlkWidth x nBlkHeight block GetAbsolutePointer(nX, nY) starts, four lookups once the table of its
+	// sub-plane exists. any thread may ask, the first one builds the table from the plane as it is at that moment.
+	double GetAbsoluteBlockSum(int32_t nX, int32_t nY, int32_t nBlkWidth, int32_t nBlkHeight) {
+		int32_t idx = 0;
+		if (nPel == 2) {
+			idx = (nX & 1) | ((nY & 1) << 1);
+			nX >>= 1;
+			nY >>= 1;
+		}
+		else if (nPel == 4) {
+			idx = (nX & 3) | ((nY & 3) << 2);
+			nX >>= 2;
+			nY >>= 2;
+		}
+		if (!summedAreaReady[idx].load(std::memory_order_acquire)) {
+			auto guard = std::lock_guard{ summedAreaLock };
+			if (!summedAreaReady[idx].load(std::memory_order_relaxed)) {
+				BuildSummedArea(idx);
+				summedAreaReady[idx].store(true, std::memory_order_release);
+			}
+		}
+		auto stride = nExtendedWidth + 1;
+		auto pTop = &summedAreas[idx][nY * stride + nX];
+		auto pBottom = pTop + nBlkHeight * stride;
+		return static_cast<int32_t>(pBottom[nBlkWidth] - pBottom[0] - pTop[nBlkWidth] + pTop[0]) / static_cast<double>(1 << SummedAreaBits);
+	}
 	inline int32_t GetPitch() const { return nPitch; }
 	inline int32_t GetWidth() const { return nWidth; }
 	inline int32_t GetHeight() const { return nHeight; }
@@ -7,6 +7,7 @@
 #include "MaskFun.hpp"
 #include "MVFilter.hpp"
 #include "SimpleResize.hpp"
+#include "FilterTiming.hpp"
 #include "Interface.vxx"
 
 struct MVMaskData final {
@@ -36,6 +37,7 @@ struct MVMaskData final {
 	self(nHeightB, 0);
 	self(nWidthBUV, 0);
 	self(nHeightBUV, 0);
+	self(timing, static_cast<FilterTiming *>(nullptr));
 	MVMaskData(const VSMap *in, VSMap *out, const VSAPI *api) {
 		vsapi = api;
 		node = vsapi->propGetNode(in, "clip", 0, nullptr);
@@ -139,6 +141,7 @@ static auto VS_CC mvmaskGetFrame(int n, int activationReason, void **instanceDat
 		vsapi->requestFrameFilter(n, d->node, frameCtx);
 	}
 	else if (activationReason == arAllFramesReady) {
+		auto timer = FrameTimer{ d->timing };
 		auto src = vsapi->getFrameFilter(n, d->node, frameCtx);
 		auto dst = vsapi->newVideoFrame(d->vi->format, d->vi->width, d->vi->height, src, core);
 		auto pSrc = reinterpret_cast<const float *>(vsapi->getReadPtr(src, 0));
@@ -272,6 +275,7 @@ static auto VS_CC mvmaskGetFrame(int n, int activationReason, void **instanceDat
 			else
 				return;
 		};
+		timer.Kernel();
 		if (balls.IsUsable()) {
 			VectorToSmallMask();
 			SmallMaskToLuma();
@@ -281,7 +285,9 @@ static auto VS_CC mvmaskGetFrame(int n, int activationReason, void **instanceDat
 			SceneChangeValueToLuma();
 			SceneChangeValueToChroma();
 		}
+		timer.Teardown();
 		vsapi->freeFrame(src);
+		timer.Finish(dst, vsapi);
 		return PointerAddConstant(dst);
 	}
 	return static_cast<const VSFrameRef *>(nullptr);
@@ -294,8 +300,10 @@ static auto VS_CC mvmaskFree(void *instanceData, VSCore *core, const VSAPI *vsap
 
 static auto VS_CC mvmaskCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
 	auto data = new MVMaskData{ in, out, vsapi };
-	if (!data->Illformed)
+	if (!data->Illformed) {
+		data->timing = TimingRegistry::Instance().Create("Mask");
 		vsapi->createFilter(in, out, "Mask", mvmaskInit, mvmaskGetFrame, mvmaskFree, fmParallel, 0, data, core);
+	}
 	else
 		delete data;
 }
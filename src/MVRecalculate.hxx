@@ -4,6 +4,7 @@
 #include <cstring>
 #include "VSHelper.h"
 #include "DCTFFTW.hpp"
+#include "AnalysisContext.hpp"
 #include "GroupOfPlanes.h"
 #include "MVInterface.h"
 
@@ -43,6 +44,7 @@ struct MVRecalculateData {
 	bool fields;
 	bool tff;
 	int32_t tffexists;
+	AnalysisContextPool *contexts;
 };
 
 static void VS_CC mvrecalculateInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
@@ -71,7 +73,8 @@ static const VSFrameRef *VS_CC mvrecalculateGetFrame(int32_t n, int32_t activati
 		}
 	}
 	else if (activationReason == arAllFramesReady) {
-		GroupOfPlanes *vectorFields = new GroupOfPlanes(d->analysisData.nBlkSizeX, d->analysisData.nBlkSizeY, d->analysisData.nLvCount, d->analysisData.nPel, d->analysisData.nMotionFlags, d->analysisData.nOverlapX, d->analysisData.nOverlapY, d->analysisData.nBlkX, d->analysisData.nBlkY, d->analysisData.xRatioUV, d->analysisData.yRatioUV, d->divideExtra);
+		auto context = d->contexts->Acquire();
+		auto vectorFields = context->vectorFields.get();
 		const uint8_t *pSrc[3] = { nullptr };
 		const uint8_t *pRef[3] = { nullptr };
 		uint8_t *pDst = { nullptr };
@@ -85,7 +88,6 @@ static const VSFrameRef *VS_CC mvrecalculateGetFrame(int32_t n, int32_t activati
 		bool srctff = !!vsapi->propGetInt(srcprops, "_Field", 0, &err);
 		if (err && d->fields && !d->tffexists) {
 			vsapi->setFilterError("Recalculate: _Field property not found in input frame. Therefore, you must pass tff argument.", frameCtx);
-			delete vectorFields;
 			vsapi->freeFrame(src);
 			return nullptr;
 		}
@@ -116,7 +118,6 @@ static const VSFrameRef *VS_CC mvrecalculateGetFrame(int32_t n, int32_t activati
 			bool reftff = !!vsapi->propGetInt(refprops, "_Field", 0, &err);
 			if (err && d->fields && !d->tffexists) {
 				vsapi->setFilterError("Recalculate: _Field property not found in input frame. Therefore, you must pass tff argument.", frameCtx);
-				delete vectorFields;
 				vsapi->freeFrame(src);
 				vsapi->freeFrame(ref);
 				vsapi->freeFrame(dst);
@@ -132,29 +133,18 @@ static const VSFrameRef *VS_CC mvrecalculateGetFrame(int32_t n, int32_t activati
 				pRef[plane] = vsapi->getReadPtr(ref, plane);
 				nRefPitch[plane] = vsapi->getStride(ref, plane);
 			}
-			MVGroupOfFrames *pSrcGOF = new MVGroupOfFrames(d->nSuperLevels, d->analysisData.nWidth, d->analysisData.nHeight, d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, d->analysisData.xRatioUV, d->analysisData.yRatioUV);
-			MVGroupOfFrames *pRefGOF = new MVGroupOfFrames(d->nSuperLevels, d->analysisData.nWidth, d->analysisData.nHeight, d->nSuperPel, d->nSuperHPad, d->nSuperVPad, d->nSuperModeYUV, d->analysisData.xRatioUV, d->analysisData.yRatioUV);
+			auto pSrcGOF = context->pSrcGOF.get();
+			auto pRefGOF = context->pRefGOF.get();
 			pSrcGOF->Update(d->nModeYUV, (uint8_t *)pSrc[0], nSrcPitch[0], (uint8_t *)pSrc[1], nSrcPitch[1], (uint8_t *)pSrc[2], nSrcPitch[2]); // v2.0
 			pRefGOF->Update(d->nModeYUV, (uint8_t *)pRef[0], nRefPitch[0], (uint8_t *)pRef[1], nRefPitch[1], (uint8_t *)pRef[2], nRefPitch[2]); // v2.0
-			DCTClass *DCTc = nullptr;
-			if (d->dctmode != 0) {
-				DCTc = new DCTFFTW(d->blksize, d->blksizev, d->dctmode);
-			}
-			vectorFields->RecalculateMVs(balls, pSrcGOF, pRefGOF, d->searchType, d->nSearchParam, d->nLambda, d->pnew, reinterpret_cast<int32_t*>(pDst), nullptr, fieldShift, d->thSAD, DCTc, d->smooth, d->meander);
+			vectorFields->RecalculateMVs(balls, pSrcGOF, pRefGOF, d->searchType, d->nSearchParam, d->nLambda, d->pnew, reinterpret_cast<int32_t*>(pDst), nullptr, fieldShift, d->thSAD, context->DCTc.get(), d->smooth, d->meander);
 			if (d->divideExtra) {
 				vectorFields->ExtraDivide(reinterpret_cast<int32_t*>(pDst));
 			}
-			delete vectorFields;
-			if (DCTc)
-				delete DCTc;
-			delete pSrcGOF;
-			delete pRefGOF;
 			vsapi->freeFrame(ref);
 		}
-		else {
+		else
 			vectorFields->WriteDefaultToArray(reinterpret_cast<int32_t*>(pDst));
-			delete vectorFields;
-		}
 		vsapi->freeFrame(src);
 		return dst;
 	}
@@ -166,6 +156,7 @@ static void VS_CC mvrecalculateFree(void *instanceData, VSCore *core, const VSAP
 	vsapi->freeNode(d->node);
 	vsapi->freeNode(d->vectors);
 	delete d->mvClip;
+	delete d->contexts;
 	delete d;
 }
 
@@ -281,12 +272,7 @@ auto RecalcVector(auto in, auto out, auto core, auto vsapi) {
 	d.analysisData.nVersion = MVAnalysisDataVersion;
 	d.headerSize = VSMAX(4 + sizeof(d.analysisData), 256);
 
-	auto args = ArgumentList{ in };
-	auto Core = VaporCore{ core };
-	auto sup = static_cast<Clip>(args["super"]);
-	sup = Core["std"]["Expr"]("clips", sup, "expr", "x 255 *");
-	d.node = sup.VideoNode;
-	sup.VideoNode = nullptr;
+	d.node = vsapi->propGetNode(in, "super", 0, nullptr);
 
 	d.supervi = vsapi->getVideoInfo(d.node);
 	if (d.overlap % (1 << d.supervi->format->subSamplingW) ||
@@ -391,6 +377,15 @@ auto RecalcVector(auto in, auto out, auto core, auto vsapi) {
 		vsapi->freeNode(d.vectors);
 		return d;
 	}
+	d.contexts = new AnalysisContextPool{ [d] {
+		auto context = new AnalysisContext{};
+		context->vectorFields = std::make_unique<GroupOfPlanes>(d.analysisData.nBlkSizeX, d.analysisData.nBlkSizeY, d.analysisData.nLvCount, d.analysisData.nPel, d.analysisData.nMotionFlags, d.analysisData.nOverlapX, d.analysisData.nOverlapY, d.analysisData.nBlkX, d.analysisData.nBlkY, d.analysisData.xRatioUV, d.analysisData.yRatioUV, d.divideExtra);
+		context->pSrcGOF = std::make_unique<MVGroupOfFrames>(d.nSuperLevels, d.analysisData.nWidth, d.analysisData.nHeight, d.nSuperPel, d.nSuperHPad, d.nSuperVPad, d.nSuperModeYUV, d.analysisData.xRatioUV, d.analysisData.yRatioUV);
+		context->pRefGOF = std::make_unique<MVGroupOfFrames>(d.nSuperLevels, d.analysisData.nWidth, d.analysisData.nHeight, d.nSuperPel, d.nSuperHPad, d.nSuperVPad, d.nSuperModeYUV, d.analysisData.xRatioUV, d.analysisData.yRatioUV);
+		if (d.dctmode != 0)
+			context->DCTc = CreateDCT(d.blksize, d.blksizev, d.dctmode);
+		return context;
+	} };
 	return d;
 }
 
@@ -2,9 +2,13 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <string>
+#include <tuple>
 #include "VapourSynth.h"
 #include "VSHelper.h"
 #include "MVFrame.h"
+#include "FilterParameters.hpp"
+#include "FilterTiming.hpp"
 
 struct MVSuperData {
 	VSNodeRef* node;
@@ -26,6 +30,7 @@ struct MVSuperData {
 	int32_t nSuperHeight;
 	MVPlaneSet nModeYUV;
 	bool isPelClipPadded;
+	FilterTiming* timing;
 };
 
 static void VS_CC mvsuperInit(VSMap* in, VSMap* out, void** instanceData, VSNode* node, VSCore* core, const VSAPI* vsapi) {
@@ -41,6 +46,7 @@ static const VSFrameRef* VS_CC mvsuperGetFrame(int32_t n, int32_t activationReas
 			vsapi->requestFrameFilter(n, d->pelclip, frameCtx);
 	}
 	else if (activationReason == arAllFramesReady) {
+		auto timer = FrameTimer{ d->timing };
 		const VSFrameRef* src = vsapi->getFrameFilter(n, d->node, frameCtx);
 		const uint8_t* pSrc[3] = { nullptr };
 		uint8_t* pDst[3] = { nullptr };
@@ -60,6 +66,7 @@ static const VSFrameRef* VS_CC mvsuperGetFrame(int32_t n, int32_t activationReas
 			memset(pDst[plane], 0, nDstPitch[plane] * vsapi->getFrameHeight(dst, plane));
 		}
 		MVGroupOfFrames* pSrcGOF = new MVGroupOfFrames(d->nLevels, d->nWidth, d->nHeight, d->nPel, d->nHPad, d->nVPad, d->nModeYUV, d->xRatioUV, d->yRatioUV);
+		timer.Kernel();
 		pSrcGOF->Update(d->nModeYUV, pDst[0], nDstPitch[0], pDst[1], nDstPitch[1], pDst[2], nDstPitch[2]);
 		MVPlaneSet planes[3] = { YPLANE, UPLANE, VPLANE };
 		for (int32_t plane = 0; plane < d->vi.format->numPlanes; ++plane)
@@ -78,6 +85,7 @@ static const VSFrameRef* VS_CC mvsuperGetFrame(int32_t n, int32_t activationReas
 		}
 		else
 			pSrcGOF->Refine(d->nModeYUV, d->sharp);
+		timer.Teardown();
 		vsapi->freeFrame(src);
 		if (d->usePelClip)
 			vsapi->freeFrame(srcPel);
@@ -91,6 +99,7 @@ static const VSFrameRef* VS_CC mvsuperGetFrame(int32_t n, int32_t activationReas
 			vsapi->propSetInt(props, "Super_modeyuv", d->nModeYUV, paReplace);
 			vsapi->propSetInt(props, "Super_levels", d->nLevels, paReplace);
 		}
+		timer.Finish(dst, vsapi);
 		return dst;
 	}
 	return nullptr;
@@ -107,35 +116,23 @@ static void VS_CC mvsuperCreate(const VSMap* in, VSMap* out, void* userData, VSC
 	MVSuperData d;
 	MVSuperData* data;
 	int err;
-	d.nHPad = int64ToIntS(vsapi->propGetInt(in, "hpad", 0, &err));
-	if (err)
-		d.nHPad = 8;
-	d.nVPad = int64ToIntS(vsapi->propGetInt(in, "vpad", 0, &err));
-	if (err)
-		d.nVPad = 8;
-	d.nPel = int64ToIntS(vsapi->propGetInt(in, "pel", 0, &err));
-	if (err)
-		d.nPel = 2;
-	d.nLevels = int64ToIntS(vsapi->propGetInt(in, "levels", 0, &err));
-	d.chroma = !!vsapi->propGetInt(in, "chroma", 0, &err);
-	if (err)
-		d.chroma = 1;
-	d.sharp = int64ToIntS(vsapi->propGetInt(in, "sharp", 0, &err));
-	if (err)
-		d.sharp = 2;
-	d.rfilter = int64ToIntS(vsapi->propGetInt(in, "rfilter", 0, &err));
-	if (err)
-		d.rfilter = 2;
-	if ((d.nPel != 1) && (d.nPel != 2) && (d.nPel != 4)) {
-		vsapi->setError(out, "Super: pel must be 1, 2, or 4.");
-		return;
-	}
-	if (d.sharp < 0 || d.sharp > 2) {
-		vsapi->setError(out, "Super: sharp must be between 0 and 2 (inclusive).");
-		return;
-	}
-	if (d.rfilter < 0 || d.rfilter > 4) {
-		vsapi->setError(out, "Super: rfilter must be between 0 and 4 (inclusive).");
+	auto parameters = mvsf::SuperParameters{};
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "hpad", 0, &err)); !err)
+		parameters.HPad = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "vpad", 0, &err)); !err)
+		parameters.VPad = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "pel", 0, &err)); !err)
+		parameters.Pel = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "levels", 0, &err)); !err)
+		parameters.Levels = x;
+	if (auto x = !!vsapi->propGetInt(in, "chroma", 0, &err); !err)
+		parameters.Chroma = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "sharp", 0, &err)); !err)
+		parameters.Sharp = x;
+	if (auto x = int64ToIntS(vsapi->propGetInt(in, "rfilter", 0, &err)); !err)
+		parameters.RFilter = x;
+	if (auto error = CheckSuperParameters(parameters)) {
+		vsapi->setError(out, (std::string{ "Super: " } + error).c_str());
 		return;
 	}
 	d.node = vsapi->propGetNode(in, "clip", 0, 0);
@@ -147,6 +144,7 @@ static void VS_CC mvsuperCreate(const VSMap* in, VSMap* out, void* userData, VSC
 		vsapi->freeNode(d.node);
 		return;
 	}
+	d.chroma = parameters.Chroma;
 	if (d.vi.format->colorFamily == cmGray)
 		d.chroma = 0;
 	if (d.vi.format->colorFamily == cmRGB)
@@ -154,13 +152,13 @@ static void VS_CC mvsuperCreate(const VSMap* in, VSMap* out, void* userData, VSC
 	d.nModeYUV = d.chroma ? YUVPLANES : YPLANE;
 	d.xRatioUV = 1 << d.vi.format->subSamplingW;
 	d.yRatioUV = 1 << d.vi.format->subSamplingH;
-	int32_t nLevelsMax = 0;
-	while (PlaneHeightLuma(d.vi.height, nLevelsMax, d.yRatioUV, d.nVPad) >= d.yRatioUV * 2 &&
-		PlaneWidthLuma(d.vi.width, nLevelsMax, d.xRatioUV, d.nHPad) >= d.xRatioUV * 2) {
-		++nLevelsMax;
-	}
-	if (d.nLevels <= 0 || d.nLevels > nLevelsMax)
-		d.nLevels = nLevelsMax;
+	std::tie(d.nSuperWidth, d.nSuperHeight) = ResolveSuperParameters(parameters, d.nWidth, d.nHeight, d.xRatioUV, d.yRatioUV);
+	d.nHPad = parameters.HPad;
+	d.nVPad = parameters.VPad;
+	d.nPel = parameters.Pel;
+	d.nLevels = parameters.Levels;
+	d.sharp = parameters.Sharp;
+	d.rfilter = parameters.RFilter;
 	d.pelclip = vsapi->propGetNode(in, "pelclip", 0, &err);
 	const VSVideoInfo* pelvi = d.pelclip ? vsapi->getVideoInfo(d.pelclip) : nullptr;
 	if (d.pelclip && (!isConstantFormat(pelvi) || pelvi->format != d.vi.format)) {
@@ -188,14 +186,9 @@ static void VS_CC mvsuperCreate(const VSMap* in, VSMap* out, void* userData, VSC
 			return;
 		}
 	}
-	d.nSuperWidth = d.nWidth + 2 * d.nHPad;
-	d.nSuperHeight = PlaneSuperOffset(false, d.nHeight, d.nLevels, d.nPel, d.nVPad, d.nSuperWidth, d.yRatioUV) / d.nSuperWidth;
-	if (d.yRatioUV == 2 && d.nSuperHeight & 1)
-		++d.nSuperHeight;
-	if (d.xRatioUV == 2 && d.nSuperWidth & 1)
-		++d.nSuperWidth;
 	d.vi.width = d.nSuperWidth;
 	d.vi.height = d.nSuperHeight;
+	d.timing = TimingRegistry::Instance().Create("Super");
 	data = new MVSuperData;
 	*data = d;
 	vsapi->createFilter(in, out, "Super", mvsuperInit, mvsuperGetFrame, mvsuperFree, fmParallel, 0, data, core);
@@ -1,20 +1,53 @@
 #pragma once
 #include <cstdlib>
 #include <cmath>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
 #include "MVClip.hpp"
 #include "MVFrame.h"
 #include "Interpolation.h"
 #include "CopyCode.hpp"
-#include "SADFunctions.hpp"
+#include "KernelRegistry.hpp"
 #include "CommonFunctions.h"
 #include "Variance.hpp"
 #include "DCT.hpp"
 #include "Padding.h"
+#include "ThreadPool.hpp"
 #include "VSHelper.h"
 
+// what the search of one plane did, only counted while enabled with PlaneOfBlocks::EnableStats.
+struct SearchCounters final {
+	enum Winner { Zero, Global, Coarse, Spatial, Temporal, Search, WinnerCount };
+	int64_t sad = 0;       // luma SADs, batched and partial ones included
+	int64_t satd = 0;
+	int64_t dct = 0;       // reference blocks transformed
+	int64_t refine = 0;    // moves of the best vector while refining
+	int64_t earlyExit = 0; // candidates dropped before a full luma SAD
+	int64_t badSAD = 0;    // blocks searched again for a bad SAD
+	std::array<int64_t, WinnerCount> wins = {};
+	auto& operator+=(const SearchCounters& other) {
+		sad += other.sad;
+		satd += other.satd;
+		dct += other.dct;
+		refine += other.refine;
+		earlyExit += other.earlyExit;
+		badSAD += other.badSAD;
+		for (auto i = 0; i < WinnerCount; i++)
+			wins[i] += other.wins[i];
+		return *this;
+	}
+};
+
 class PlaneOfBlocks {
 	static constexpr auto MAX_PREDICTOR = 20;
+	static constexpr auto MAX_BATCH = 16;
+	// super clips hold samples in [0, 1], the costs and every threshold on them are on the 8 bit scale.
+	static constexpr auto PixelScale = 255.;
 	int32_t nBlkX;
 	int32_t nBlkY;
 	int32_t nBlkSizeX;
@@ -32,9 +65,9 @@ class PlaneOfBlocks {
 	int32_t nLogxRatioUV;
 	int32_t nLogyRatioUV;
 	SADFunction SAD;
-	LUMAFunction LUMA;
-	COPYFunction BLITLUMA;
-	COPYFunction BLITCHROMA;
+	SADLimitFunction SADLIMIT;
+	SADx4Function SADX4;
+	SADYUVFunction SADYUV;
 	SADFunction SADCHROMA;
 	SADFunction SATD;
 	VectorStructure* vectors;
@@ -65,31 +98,102 @@ class PlaneOfBlocks {
 	double nLambda;
 	double LSAD;
 	int32_t penaltyNew;
+	double nLambdaLevel;
+	double LSADLevel;
+	int32_t penaltyNewLevel;
+	int32_t* vecPrev;
 	int32_t penaltyZero;
 	int32_t pglobal;
 	double badSAD;
 	int32_t badrange;
 	double planeSAD;
 	int32_t badcount;
+	double staticRatio;
+	int32_t staticSkips;
 	bool temporal;
 	bool tryMany;
-	int32_t iter;
+	int32_t iter; // moves of the best vector in the current block
+	SearchCounters counters;
+	SearchCounters* stats = nullptr;
 	VectorStructure globalMVPredictor;
 	VectorStructure zeroMVfieldShifted;
 	DCTClass* DCT;
-	uint8_t* dctSrc;
+	const uint8_t* dctSrc;
 	uint8_t* dctRef;
 	int32_t dctpitch;
 	int32_t dctmode;
 	double srcLuma;
 	double refLuma;
+	// the DCT and luma of every source block of the level, computed before the blocks are searched and kept while
+	// one source is searched against several references.
+	struct SourceBlockCache {
+		std::vector<uint8_t> dct;
+		std::vector<double> luma;
+		bool ready = false;
+	};
+	SourceBlockCache sourceBlocks;
+	SourceBlockCache* sourceCache = nullptr;
+	bool keepSourceBlocks = false;
 	double sumLumaChange;
 	double dctweight16;
 	int32_t* freqArray;
 	int32_t freqSize;
 	double verybigSAD;
-	int32_t nSrcPitch_temp[3];
-	uint8_t* pSrc_temp[3];
+	std::vector<double> refBlockSums;
+	std::vector<double> columnSums;
+	int32_t nSumsX;
+	int32_t nSumsY;
+	int32_t nSumsWidth;
+	int32_t nSumsHeight;
+	double srcBlockSum;
+	// progress of the rows of one wavefront search, see SearchMVsWavefront.
+	struct WavefrontRows final {
+		int32_t nBlkX;
+		std::atomic<int32_t> nextRow = 0;
+		std::unique_ptr<std::atomic<int32_t>[]> progress;
+		std::vector<int32_t> badPrefix;
+		WavefrontRows(int32_t _nBlkX, int32_t _nBlkY) :nBlkX{ _nBlkX }, progress{ new std::atomic<int32_t>[_nBlkY] }, badPrefix(_nBlkX * _nBlkY) {}
+		auto WaitFor(int32_t row, int32_t count) {
+			for (auto done = progress[row].load(std::memory_order_acquire); done < count; done = progress[row].load(std::memory_order_acquire))
+				progress[row].wait(done, std::memory_order_acquire);
+		}
+		auto Publish(int32_t row, int32_t count) {
+			progress[row].store(count, std::memory_order_release);
+			progress[row].notify_all();
+		}
+		// bad blocks before the block at scan position pos of row in the serial scan. waits for the row above to
+		// finish, its last block waited for the whole row above it in turn, so every row above is done by then.
+		auto BadCountBefore(int32_t row, int32_t pos) {
+			auto count = pos > 0 ? badPrefix[row * nBlkX + pos - 1] : 0;
+			if (row > 0) {
+				WaitFor(row - 1, nBlkX);
+				for (auto above = 0; above < row; ++above)
+					count += badPrefix[above * nBlkX + nBlkX - 1];
+			}
+			return count;
+		}
+	};
+	// vectors already scored for the current block, direct-mapped on the low bits of the vector. an entry is valid when
+	// its stamp is the current one and keeps the smallest penalty the vector was scored with.
+	struct CandidateMemoEntry final {
+		uint32_t stamp;
+		int32_t vx;
+		int32_t vy;
+		int32_t penalty;
+	};
+	static constexpr auto CANDIDATE_MEMO_BITS = 5;
+	std::array<CandidateMemoEntry, 1 << (2 * CANDIDATE_MEMO_BITS)> candidateMemo = {};
+	uint32_t candidateMemoStamp = 0;
+	bool memoCandidates = false;
+	// blocks the frame difference pre-pass found static, set on the smallest plane and inherited by the finer ones
+	// through InterpolatePrediction. nullptr when the pre-pass is off.
+	std::vector<uint8_t> staticBlocks;
+	const uint8_t* staticMask = nullptr;
+	WavefrontRows* wavefront = nullptr;
+	int32_t wavefrontPos = 0;
+	std::vector<std::unique_ptr<PlaneOfBlocks>> wavefrontContexts;
+	std::vector<std::unique_ptr<DCTClass>> wavefrontDCTs;
+	bool sharedVectors = false;
 	inline const uint8_t* GetRefBlock(int32_t nVx, int32_t nVy) {
 		if (nPel == 2)
 			return pRefFrame->GetPlane(YPLANE)->GetAbsolutePointerPel2(
@@ -104,33 +208,38 @@ class PlaneOfBlocks {
 				x[0] * 4 + nVx,
 				y[0] * 4 + nVy);
 	}
-	inline const uint8_t* GetRefBlockU(int32_t nVx, int32_t nVy) {
-		if (nPel == 2)
-			return pRefFrame->GetPlane(UPLANE)->GetAbsolutePointerPel2(
-				x[1] * 2 + nVx / xRatioUV,
-				y[1] * 2 + nVy / yRatioUV);
-		else if (nPel == 1)
-			return pRefFrame->GetPlane(UPLANE)->GetAbsolutePointerPel1(
-				x[1] + nVx / xRatioUV,
-				y[1] + nVy / yRatioUV);
-		else
-			return pRefFrame->GetPlane(UPLANE)->GetAbsolutePointerPel4(
-				x[1] * 4 + nVx / xRatioUV,
-				y[1] * 4 + nVy / yRatioUV);
+	// luma, U and V blocks of one candidate, the pel branch and the chroma vector are worked out once for all planes.
+	inline void GetRefBlocks(int32_t nVx, int32_t nVy, const uint8_t** pRef) {
+		auto pYPlane = pRefFrame->GetPlane(YPLANE);
+		auto pUPlane = pRefFrame->GetPlane(UPLANE);
+		auto pVPlane = pRefFrame->GetPlane(VPLANE);
+		auto nVxUV = nVx / xRatioUV;
+		auto nVyUV = nVy / yRatioUV;
+		if (nPel == 2) {
+			pRef[0] = pYPlane->GetAbsolutePointerPel2(x[0] * 2 + nVx, y[0] * 2 + nVy);
+			pRef[1] = pUPlane->GetAbsolutePointerPel2(x[1] * 2 + nVxUV, y[1] * 2 + nVyUV);
+			pRef[2] = pVPlane->GetAbsolutePointerPel2(x[2] * 2 + nVxUV, y[2] * 2 + nVyUV);
+		}
+		else if (nPel == 1) {
+			pRef[0] = pYPlane->GetAbsolutePointerPel1(x[0] + nVx, y[0] + nVy);
+			pRef[1] = pUPlane->GetAbsolutePointerPel1(x[1] + nVxUV, y[1] + nVyUV);
+			pRef[2] = pVPlane->GetAbsolutePointerPel1(x[2] + nVxUV, y[2] + nVyUV);
+		}
+		else {
+			pRef[0] = pYPlane->GetAbsolutePointerPel4(x[0] * 4 + nVx, y[0] * 4 + nVy);
+			pRef[1] = pUPlane->GetAbsolutePointerPel4(x[1] * 4 + nVxUV, y[1] * 4 + nVyUV);
+			pRef[2] = pVPlane->GetAbsolutePointerPel4(x[2] * 4 + nVxUV, y[2] * 4 + nVyUV);
+		}
 	}
-	inline const uint8_t* GetRefBlockV(int32_t nVx, int32_t nVy) {
-		if (nPel == 2)
-			return pRefFrame->GetPlane(VPLANE)->GetAbsolutePointerPel2(
-				x[2] * 2 + nVx / xRatioUV,
-				y[2] * 2 + nVy / yRatioUV);
-		else if (nPel == 1)
-			return pRefFrame->GetPlane(VPLANE)->GetAbsolutePointerPel1(
-				x[2] + nVx / xRatioUV,
-				y[2] + nVy / yRatioUV);
-		else
-			return pRefFrame->GetPlane(VPLANE)->GetAbsolutePointerPel4(
-				x[2] * 4 + nVx / xRatioUV,
-				y[2] * 4 + nVy / yRatioUV);
+	inline double ChromaSAD(const uint8_t* const* pRef) {
+		return (SADCHROMA(pSrc[1], nSrcPitch[1], pRef[1], nRefPitch[1]) + SADCHROMA(pSrc[2], nSrcPitch[2], pRef[2], nRefPitch[2])) * PixelScale;
+	}
+	inline double ChromaSAD(int32_t nVx, int32_t nVy) {
+		if (!chroma)
+			return 0;
+		const uint8_t* pRef[3];
+		GetRefBlocks(nVx, nVy, pRef);
+		return ChromaSAD(pRef);
 	}
 	inline const uint8_t* GetSrcBlock(int32_t nX, int32_t nY) {
 		return pSrcFrame->GetPlane(YPLANE)->GetAbsolutePelPointer(nX, nY);
@@ -139,13 +248,33 @@ class PlaneOfBlocks {
 		int32_t dist = SquareDifferenceNorm(predictor, vx, vy);
 		return (nLambda * dist) / 256.;
 	}
-	double LumaSADx(const uint8_t* pRef0) {
+	// luma sum of the reference block of a candidate, the counterpart of GetRefBlock.
+	inline double GetRefBlockLuma(int32_t nVx, int32_t nVy) {
+		return pRefFrame->GetPlane(YPLANE)->GetAbsoluteBlockSum(x[0] * nPel + nVx, y[0] * nPel + nVy, nBlkSizeX, nBlkSizeY);
+	}
+	inline double GetSrcBlockLuma() {
+		return pSrcFrame->GetPlane(YPLANE)->GetAbsoluteBlockSum(x[0] * nPel, y[0] * nPel, nBlkSizeX, nBlkSizeY);
+	}
+	inline void TransformRefBlock(const uint8_t* pRef0) {
+		if (stats)
+			stats->dct++;
+		DCT->DCTBytes2D(pRef0, nRefPitch[0], dctRef, dctpitch);
+	}
+	inline double LumaSATD(const uint8_t* pRef0) {
+		if (stats)
+			stats->satd++;
+		return SATD(pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]);
+	}
+	double LumaSADx(int32_t nVx, int32_t nVy) {
+		auto pRef0 = GetRefBlock(nVx, nVy);
 		double sad;
+		if (stats)
+			stats->sad += dctmode != 5;
 		switch (dctmode) {
 		case 1:
-			DCT->DCTBytes2D(pRef0, nRefPitch[0], dctRef, dctpitch);
+			TransformRefBlock(pRef0);
 			{
-				float* dctSrc16 = (float*)dctSrc;
+				const float* dctSrc16 = (const float*)dctSrc;
 				float* dctRef16 = (float*)dctRef;
 				sad = (SAD(dctSrc, dctpitch, dctRef, dctpitch) + std::abs(dctSrc16[0] - dctRef16[0]) * 3) * nBlkSizeX / 2;
 			}
@@ -153,10 +282,10 @@ class PlaneOfBlocks {
 		case 2:
 			sad = SAD(pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]);
 			if (dctweight16 > 0) {
-				DCT->DCTBytes2D(pRef0, nRefPitch[0], dctRef, dctpitch);
+				TransformRefBlock(pRef0);
 				double dctsad;
 				{
-					float* dctSrc16 = (float*)dctSrc;
+					const float* dctSrc16 = (const float*)dctSrc;
 					float* dctRef16 = (float*)dctRef;
 					dctsad = (SAD(dctSrc, dctpitch, dctRef, dctpitch) + std::abs(dctSrc16[0] - dctRef16[0]) * 3) * nBlkSizeX / 2;
 				}
@@ -164,46 +293,46 @@ class PlaneOfBlocks {
 			}
 			break;
 		case 3:
-			refLuma = LUMA(pRef0, nRefPitch[0]);
+			refLuma = GetRefBlockLuma(nVx, nVy);
 			sad = SAD(pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]);
 			if (std::abs(srcLuma - refLuma) > (srcLuma + refLuma) / 32) {
-				DCT->DCTBytes2D(pRef0, nRefPitch[0], dctRef, dctpitch);
+				TransformRefBlock(pRef0);
 				double dctsad = SAD(dctSrc, dctpitch, dctRef, dctpitch) * nBlkSizeX / 2;
 				sad = sad / 2 + dctsad / 2;
 			}
 			break;
 		case 4:
-			refLuma = LUMA(pRef0, nRefPitch[0]);
+			refLuma = GetRefBlockLuma(nVx, nVy);
 			sad = SAD(pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]);
 			if (std::abs(srcLuma - refLuma) > (srcLuma + refLuma) / 32) {
-				DCT->DCTBytes2D(pRef0, nRefPitch[0], dctRef, dctpitch);
+				TransformRefBlock(pRef0);
 				double dctsad = SAD(dctSrc, dctpitch, dctRef, dctpitch) * nBlkSizeX / 2;
 				sad = sad / 4 + dctsad / 2 + dctsad / 4;
 			}
 			break;
 		case 5:
-			sad = SATD(pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]);
+			sad = LumaSATD(pRef0);
 			break;
 		case 6:
 			sad = SAD(pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]);
 			if (dctweight16 > 0) {
-				double dctsad = SATD(pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]);
+				double dctsad = LumaSATD(pRef0);
 				sad = (sad * (16 - dctweight16) + dctsad * dctweight16) / 16;
 			}
 			break;
 		case 7:
-			refLuma = LUMA(pRef0, nRefPitch[0]);
+			refLuma = GetRefBlockLuma(nVx, nVy);
 			sad = SAD(pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]);
 			if (std::abs(srcLuma - refLuma) > (srcLuma + refLuma) / 32) {
-				double dctsad = SATD(pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]);
+				double dctsad = LumaSATD(pRef0);
 				sad = sad / 2 + dctsad / 2;
 			}
 			break;
 		case 8:
-			refLuma = LUMA(pRef0, nRefPitch[0]);
+			refLuma = GetRefBlockLuma(nVx, nVy);
 			sad = SAD(pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]);
 			if (std::abs(srcLuma - refLuma) > (srcLuma + refLuma) / 32) {
-				double dctsad = SATD(pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]);
+				double dctsad = LumaSATD(pRef0);
 				sad = sad / 4 + dctsad / 2 + dctsad / 4;
 			}
 			break;
@@ -211,91 +340,194 @@ class PlaneOfBlocks {
 			sad = SAD(pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]);
 			if (dctweight16 > 1) {
 				double dctweighthalf = dctweight16 / 2;
-				double dctsad = SATD(pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]);
+				double dctsad = LumaSATD(pRef0);
 				sad = (sad * (16 - dctweighthalf) + dctsad * dctweighthalf) / 16;
 			}
 			break;
 		case 10:
-			refLuma = LUMA(pRef0, nRefPitch[0]);
+			refLuma = GetRefBlockLuma(nVx, nVy);
 			sad = SAD(pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]);
 			if (std::abs(srcLuma - refLuma) > (srcLuma + refLuma) / 16) {
-				double dctsad = SATD(pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]);
+				double dctsad = LumaSATD(pRef0);
 				sad = sad / 2 + dctsad / 4 + sad / 4;
 			}
 			break;
 		default:
 			sad = SAD(pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]);
 		}
-		return sad;
+		return sad * PixelScale;
+	}
+	inline double LumaSAD(int32_t nVx, int32_t nVy) {
+		if (!dctmode) {
+			if (stats)
+				stats->sad++;
+			return SAD(pSrc[0], nSrcPitch[0], GetRefBlock(nVx, nVy), nRefPitch[0]) * PixelScale;
+		}
+		return LumaSADx(nVx, nVy);
+	}
+	// scores the luma of up to MAX_BATCH candidates with the x4 kernel, candidates that the Check functions
+	// would reject before reaching the SAD (out of range, or motion cost alone over the current best) are left out.
+	// returns false when the candidates have to be scored one at a time.
+	bool BatchLumaSAD(const int32_t* vx, const int32_t* vy, int32_t count, double* sads) {
+		if (dctmode != 0 || count < 2)
+			return false;
+		const uint8_t* pRefs[MAX_BATCH + 3];
+		int32_t indices[MAX_BATCH + 3];
+		double batchSAD[MAX_BATCH + 3];
+		int32_t nEligible = 0;
+		for (int32_t i = 0; i < count; i++)
+			if (IsVectorOK(vx[i], vy[i]) && MotionDistorsion(vx[i], vy[i]) < nMinCost) {
+				pRefs[nEligible] = GetRefBlock(vx[i], vy[i]);
+				indices[nEligible++] = i;
+			}
+		if (nEligible < 2)
+			return false;
+		for (int32_t i = nEligible; i % 4 != 0; i++)
+			pRefs[i] = pRefs[nEligible - 1];
+		for (int32_t i = 0; i < nEligible; i += 4)
+			SADX4(pSrc[0], nSrcPitch[0], pRefs + i, nRefPitch[0], batchSAD + i);
+		if (stats)
+			stats->sad += nEligible;
+		for (int32_t i = 0; i < nEligible; i++)
+			sads[indices[i]] = batchSAD[i] * PixelScale;
+		return true;
+	}
+	template<typename CheckFunction>
+	void CheckBatch(const int32_t* vx, const int32_t* vy, int32_t count, CheckFunction&& Check) {
+		double sads[MAX_BATCH];
+		for (int32_t offset = 0; offset < count; offset += MAX_BATCH) {
+			auto n = std::min<int32_t>(MAX_BATCH, count - offset);
+			auto batched = BatchLumaSAD(vx + offset, vy + offset, n, sads);
+			for (int32_t i = 0; i < n; i++)
+				Check(offset + i, batched ? sads + i : nullptr);
+		}
 	}
-	inline double LumaSAD(const uint8_t* pRef0) {
-		return !dctmode ? SAD(pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]) : LumaSADx(pRef0);
+	void CheckMVs(const int32_t* vx, const int32_t* vy, int32_t count) {
+		CheckBatch(vx, vy, count, [&](auto i, auto pBatchedSAD) { CheckMV(vx[i], vy[i], pBatchedSAD); });
 	}
-	inline void CheckMV0(int32_t vx, int32_t vy) {
-		if (IsVectorOK(vx, vy)) {
+	// the candidates of one block start over. the memo is only sound while nMinCost never grows, which tryMany breaks.
+	void ResetCandidateMemo(bool enable) {
+		memoCandidates = enable;
+		if (++candidateMemoStamp == 0) {
+			candidateMemo.fill({});
+			candidateMemoStamp = 1;
+		}
+	}
+	// a vector scored before with no larger penalty cost at least nMinCost back then, and nMinCost has only shrunk
+	// since, so scoring it again cannot change the result.
+	inline bool AlreadyScored(int32_t vx, int32_t vy, int32_t penalty) {
+		if (!memoCandidates)
+			return false;
+		constexpr auto mask = (1 << CANDIDATE_MEMO_BITS) - 1;
+		auto& entry = candidateMemo[(vx & mask) | ((vy & mask) << CANDIDATE_MEMO_BITS)];
+		if (entry.stamp == candidateMemoStamp && entry.vx == vx && entry.vy == vy) {
+			if (entry.penalty <= penalty) {
+				if (stats)
+					stats->earlyExit++;
+				return true;
+			}
+			entry.penalty = penalty;
+			return false;
+		}
+		entry = { candidateMemoStamp, vx, vy, penalty };
+		return false;
+	}
+	// adds the luma cost of a candidate to cost and returns false as soon as the candidate can no longer win,
+	// then adds the chroma cost. the luma kernels stop early at the SAD that already rules the candidate out and
+	// the fused kernel only reads the chroma planes when the luma leaves room for them.
+	inline bool AddCandidateCost(int32_t vx, int32_t vy, int32_t penalty, double& cost, double& sad, double& saduv, const double* pBatchedSAD) {
+		if (cost >= nMinCost) {
+			if (stats)
+				stats->earlyExit++;
+			return false;
+		}
+		auto chromaDone = false;
+		auto partial = false;
+		if (pBatchedSAD || dctmode)
+			sad = pBatchedSAD ? *pBatchedSAD : LumaSAD(vx, vy);
+		else {
+			auto nLumaLimit = penalty >= 0 ? (nMinCost - cost) / (1. + penalty / 256.) : std::numeric_limits<double>::max();
+			// the kernels stop and skip the chroma on the unscaled limit, so decide on exactly the values they saw,
+			// sad * PixelScale may round to the other side of nLumaLimit.
+			auto rawLimit = nLumaLimit / PixelScale;
+			auto raw = 0.;
+			if (SADYUV) {
+				const uint8_t* pRef[3];
+				GetRefBlocks(vx, vy, pRef);
+				raw = SADYUV(pSrc, nSrcPitch, pRef, nRefPitch, rawLimit, &saduv);
+			}
+			else
+				raw = SADLIMIT(pSrc[0], nSrcPitch[0], GetRefBlock(vx, vy), nRefPitch[0], rawLimit);
+			partial = raw >= rawLimit;
+			chromaDone = SADYUV && !partial;
+			sad = raw * PixelScale;
+			if (chromaDone)
+				saduv *= PixelScale;
+			if (stats)
+				stats->sad++;
+		}
+		// a partial SAD never exceeds the full one, so rejecting on it gives the same answer as the full SAD would.
+		// the limit is only an estimate of the exact test, when that test still passes the full SAD is needed.
+		if (cost + (sad + ((penalty * sad) / 256)) >= nMinCost) {
+			if (stats)
+				stats->earlyExit += partial;
+			return false;
+		}
+		if (partial) {
+			sad = LumaSAD(vx, vy);
+			if (cost + (sad + ((penalty * sad) / 256)) >= nMinCost) return false;
+		}
+		cost += sad + ((penalty * sad) / 256);
+		if (!chromaDone)
+			saduv = ChromaSAD(vx, vy);
+		cost += saduv + ((penalty * saduv) / 256);
+		return cost < nMinCost;
+	}
+	inline void CheckMV0(int32_t vx, int32_t vy, const double* pBatchedSAD = nullptr) {
+		if (IsVectorOK(vx, vy) && !AlreadyScored(vx, vy, 0)) {
 			double cost = MotionDistorsion(vx, vy);
-			if (cost >= nMinCost) return;
-			double sad = LumaSAD(GetRefBlock(vx, vy));
-			cost += sad;
-			if (cost >= nMinCost) return;
-			double saduv = (chroma) ? SADCHROMA(pSrc[1], nSrcPitch[1], GetRefBlockU(vx, vy), nRefPitch[1])
-				+ SADCHROMA(pSrc[2], nSrcPitch[2], GetRefBlockV(vx, vy), nRefPitch[2]) : 0;
-			cost += saduv;
-			if (cost >= nMinCost) return;
+			double sad, saduv;
+			if (!AddCandidateCost(vx, vy, 0, cost, sad, saduv, pBatchedSAD)) return;
 			bestMV.x = vx;
 			bestMV.y = vy;
 			nMinCost = cost;
 			bestMV.sad = sad + saduv;
+			iter++;
 		}
 	}
-	inline void CheckMV(int32_t vx, int32_t vy) {
-		if (IsVectorOK(vx, vy)) {
+	inline void CheckMV(int32_t vx, int32_t vy, const double* pBatchedSAD = nullptr) {
+		if (IsVectorOK(vx, vy) && !AlreadyScored(vx, vy, penaltyNew)) {
 			double cost = MotionDistorsion(vx, vy);
-			if (cost >= nMinCost) return;
-			double sad = LumaSAD(GetRefBlock(vx, vy));
-			cost += sad + ((penaltyNew * sad) / 256);
-			if (cost >= nMinCost) return;
-			double saduv = (chroma) ? SADCHROMA(pSrc[1], nSrcPitch[1], GetRefBlockU(vx, vy), nRefPitch[1])
-				+ SADCHROMA(pSrc[2], nSrcPitch[2], GetRefBlockV(vx, vy), nRefPitch[2]) : 0;
-			cost += saduv + ((penaltyNew * saduv) / 256);
-			if (cost >= nMinCost) return;
+			double sad, saduv;
+			if (!AddCandidateCost(vx, vy, penaltyNew, cost, sad, saduv, pBatchedSAD)) return;
 			bestMV.x = vx;
 			bestMV.y = vy;
 			nMinCost = cost;
 			bestMV.sad = sad + saduv;
+			iter++;
 		}
 	}
-	inline void CheckMV2(int32_t vx, int32_t vy, int32_t* dir, int32_t val) {
-		if (IsVectorOK(vx, vy)) {
+	inline void CheckMV2(int32_t vx, int32_t vy, int32_t* dir, int32_t val, const double* pBatchedSAD = nullptr) {
+		if (IsVectorOK(vx, vy) && !AlreadyScored(vx, vy, penaltyNew)) {
 			double cost = MotionDistorsion(vx, vy);
-			if (cost >= nMinCost) return;
-			double sad = LumaSAD(GetRefBlock(vx, vy));
-			cost += sad + ((penaltyNew * sad) / 256);
-			if (cost >= nMinCost) return;
-			double saduv = (chroma) ? SADCHROMA(pSrc[1], nSrcPitch[1], GetRefBlockU(vx, vy), nRefPitch[1])
-				+ SADCHROMA(pSrc[2], nSrcPitch[2], GetRefBlockV(vx, vy), nRefPitch[2]) : 0;
-			cost += saduv + ((penaltyNew * saduv) / 256);
-			if (cost >= nMinCost) return;
+			double sad, saduv;
+			if (!AddCandidateCost(vx, vy, penaltyNew, cost, sad, saduv, pBatchedSAD)) return;
 			bestMV.x = vx;
 			bestMV.y = vy;
 			nMinCost = cost;
 			bestMV.sad = sad + saduv;
+			iter++;
 			*dir = val;
 		}
 	}
-	inline void CheckMVdir(int32_t vx, int32_t vy, int32_t* dir, int32_t val) {
-		if (IsVectorOK(vx, vy)) {
+	inline void CheckMVdir(int32_t vx, int32_t vy, int32_t* dir, int32_t val, const double* pBatchedSAD = nullptr) {
+		if (IsVectorOK(vx, vy) && !AlreadyScored(vx, vy, penaltyNew)) {
 			double cost = MotionDistorsion(vx, vy);
-			if (cost >= nMinCost) return;
-			double sad = LumaSAD(GetRefBlock(vx, vy));
-			cost += sad + ((penaltyNew * sad) / 256);
-			if (cost >= nMinCost) return;
-			double saduv = (chroma) ? SADCHROMA(pSrc[1], nSrcPitch[1], GetRefBlockU(vx, vy), nRefPitch[1])
-				+ SADCHROMA(pSrc[2], nSrcPitch[2], GetRefBlockV(vx, vy), nRefPitch[2]) : 0;
-			cost += saduv + ((penaltyNew * saduv) / 256);
-			if (cost >= nMinCost) return;
+			double sad, saduv;
+			if (!AddCandidateCost(vx, vy, penaltyNew, cost, sad, saduv, pBatchedSAD)) return;
 			nMinCost = cost;
 			bestMV.sad = sad + saduv;
+			iter++;
 			*dir = val;
 		}
 	}
@@ -344,6 +576,7 @@ class PlaneOfBlocks {
 		return ((i >= 0) && (i < nBlkCount));
 	}
 	void Refine() {
+		auto moves = iter;
 		// then, we refine, according to the search type
 		if (searchType & ONETIME)
 			for (int32_t i = nSearchParam; i > 0; i /= 2)
@@ -357,12 +590,7 @@ class PlaneOfBlocks {
 				DiamondSearch(i);
 
 		if (searchType & EXHAUSTIVE)
-		{
-			int32_t mvx = bestMV.x;
-			int32_t mvy = bestMV.y;
-			for (int32_t i = 1; i <= nSearchParam; i++)// region is same as enhausted, but ordered by radius (from near to far)
-				ExpandingSearch(i, 1, mvx, mvy);
-		}
+			ExhaustiveSearch(nSearchParam, bestMV.x, bestMV.y); // region is same as enhausted, but ordered by radius (from near to far)
 
 		if (searchType & HEX2SEARCH)
 			Hex2Search(nSearchParam);
@@ -391,6 +619,8 @@ class PlaneOfBlocks {
 				CheckMV(mvx, mvy + i);
 			}
 		}
+		if (stats)
+			stats->refine += iter - moves;
 	}
 public:
 	PlaneOfBlocks(int32_t _nBlkX, int32_t _nBlkY, int32_t _nBlkSizeX, int32_t _nBlkSizeY, int32_t _nPel, int32_t _nLevel, int32_t _nMotionFlags, int32_t _nOverlapX, int32_t _nOverlapY, int32_t _xRatioUV, int32_t _yRatioUV) {
@@ -418,134 +648,40 @@ public:
 		globalMVPredictor.sad = zeroMV.sad;
 		vectors = new VectorStructure[nBlkCount];
 		memset(vectors, 0, nBlkCount * sizeof(VectorStructure));
-		static SADFunction sads[257][257];
-		static LUMAFunction lumas[257][257];
-		static COPYFunction blits[257][257];
-		static SADFunction satds[257][257];
-		sads[2][2] = Sad_C<2, 2>;
-		lumas[2][2] = Luma_C<2, 2>;
-		blits[2][2] = Copy_C<2, 2>;
-		sads[2][4] = Sad_C<2, 4>;
-		blits[2][4] = Copy_C<2, 4>;
-		sads[4][2] = Sad_C<4, 2>;
-		blits[4][2] = Copy_C<4, 2>;
-		sads[4][4] = Sad_C<4, 4>;
-		lumas[4][4] = Luma_C<4, 4>;
-		blits[4][4] = Copy_C<4, 4>;
-		satds[4][4] = Satd_C<4, 4>;
-		sads[4][8] = Sad_C<4, 8>;
-		blits[4][8] = Copy_C<4, 8>;
-		sads[8][1] = Sad_C<8, 1>;
-		blits[8][1] = Copy_C<8, 1>;
-		sads[8][2] = Sad_C<8, 2>;
-		blits[8][2] = Copy_C<8, 2>;
-		sads[8][4] = Sad_C<8, 4>;
-		lumas[8][4] = Luma_C<8, 4>;
-		blits[8][4] = Copy_C<8, 4>;
-		sads[8][8] = Sad_C<8, 8>;
-		lumas[8][8] = Luma_C<8, 8>;
-		blits[8][8] = Copy_C<8, 8>;
-		satds[8][8] = Satd_C<8, 8>;
-		sads[8][16] = Sad_C<8, 16>;
-		blits[8][16] = Copy_C<8, 16>;
-		sads[16][1] = Sad_C<16, 1>;
-		blits[16][1] = Copy_C<16, 1>;
-		sads[16][2] = Sad_C<16, 2>;
-		lumas[16][2] = Luma_C<16, 2>;
-		blits[16][2] = Copy_C<16, 2>;
-		sads[16][4] = Sad_C<16, 4>;
-		blits[16][4] = Copy_C<16, 4>;
-		sads[16][8] = Sad_C<16, 8>;
-		lumas[16][8] = Luma_C<16, 8>;
-		blits[16][8] = Copy_C<16, 8>;
-		sads[16][16] = Sad_C<16, 16>;
-		lumas[16][16] = Luma_C<16, 16>;
-		blits[16][16] = Copy_C<16, 16>;
-		satds[16][16] = Satd_C<16, 16>;
-		sads[16][32] = Sad_C<16, 32>;
-		blits[16][32] = Copy_C<16, 32>;
-		sads[32][8] = Sad_C<32, 8>;
-		blits[32][8] = Copy_C<32, 8>;
-		sads[32][16] = Sad_C<32, 16>;
-		lumas[32][16] = Luma_C<32, 16>;
-		blits[32][16] = Copy_C<32, 16>;
-		sads[32][32] = Sad_C<32, 32>;
-		lumas[32][32] = Luma_C<32, 32>;
-		blits[32][32] = Copy_C<32, 32>;
-		satds[32][32] = Satd_C<32, 32>;
-		sads[32][64] = Sad_C<32, 64>;
-		sads[64][16] = Sad_C<64, 16>;
-		sads[64][32] = Sad_C<64, 32>;
-		sads[64][64] = Sad_C<64, 64>;
-		sads[64][128] = Sad_C<64, 128>;
-		sads[128][32] = Sad_C<128, 32>;
-		sads[128][64] = Sad_C<128, 64>;
-		sads[128][128] = Sad_C<128, 128>;
-		sads[128][256] = Sad_C<128, 256>;
-		sads[256][64] = Sad_C<256, 64>;
-		sads[256][128] = Sad_C<256, 128>;
-		sads[256][256] = Sad_C<256, 256>;
-		lumas[32][64] = Luma_C<32, 64>;
-		lumas[64][16] = Luma_C<64, 16>;
-		lumas[64][32] = Luma_C<64, 32>;
-		lumas[64][64] = Luma_C<64, 64>;
-		lumas[64][128] = Luma_C<64, 128>;
-		lumas[128][32] = Luma_C<128, 32>;
-		lumas[128][64] = Luma_C<128, 64>;
-		lumas[128][128] = Luma_C<128, 128>;
-		lumas[128][256] = Luma_C<128, 256>;
-		lumas[256][64] = Luma_C<256, 64>;
-		lumas[256][128] = Luma_C<256, 128>;
-		lumas[256][256] = Luma_C<256, 256>;
-		blits[32][64] = Copy_C<32, 64>;
-		blits[64][16] = Copy_C<64, 16>;
-		blits[64][32] = Copy_C<64, 32>;
-		blits[64][64] = Copy_C<64, 64>;
-		blits[64][128] = Copy_C<64, 128>;
-		blits[128][32] = Copy_C<128, 32>;
-		blits[128][64] = Copy_C<128, 64>;
-		blits[128][128] = Copy_C<128, 128>;
-		blits[128][256] = Copy_C<128, 256>;
-		blits[256][64] = Copy_C<256, 64>;
-		blits[256][128] = Copy_C<256, 128>;
-		blits[256][256] = Copy_C<256, 256>;
-		satds[64][64] = Satd_C<64, 64>;
-		satds[128][128] = Satd_C<128, 128>;
-		satds[256][256] = Satd_C<256, 256>;
-		SAD = sads[nBlkSizeX][nBlkSizeY];
-		LUMA = lumas[nBlkSizeX][nBlkSizeY];
-		BLITLUMA = blits[nBlkSizeX][nBlkSizeY];
-		SADCHROMA = sads[nBlkSizeX / xRatioUV][nBlkSizeY / yRatioUV];
-		BLITCHROMA = blits[nBlkSizeX / xRatioUV][nBlkSizeY / yRatioUV];
-		SATD = satds[nBlkSizeX][nBlkSizeY];
+		auto SelectSadYUV = GetKernel<KernelKind::SADYUV>(nBlkSizeX, nBlkSizeY);
+		SAD = GetKernel<KernelKind::SAD>(nBlkSizeX, nBlkSizeY);
+		SADLIMIT = GetKernel<KernelKind::SADLimit>(nBlkSizeX, nBlkSizeY);
+		SADX4 = GetKernel<KernelKind::SADx4>(nBlkSizeX, nBlkSizeY);
+		SADYUV = chroma && SelectSadYUV ? SelectSadYUV(xRatioUV, yRatioUV) : nullptr;
+		SADCHROMA = GetKernel<KernelKind::SAD>(nBlkSizeX / xRatioUV, nBlkSizeY / yRatioUV);
+		SATD = GetKernel<KernelKind::SATD>(nBlkSizeX, nBlkSizeY);
 		if (!chroma)
 			SADCHROMA = nullptr;
 		dctpitch = nBlkSizeX * sizeof(float);
-		dctSrc = vs_aligned_malloc<uint8_t>(nBlkSizeY * dctpitch, ALIGN_PLANES);
+		dctSrc = nullptr;
 		dctRef = vs_aligned_malloc<uint8_t>(nBlkSizeY * dctpitch, ALIGN_PLANES);
 
-		nSrcPitch_temp[0] = nBlkSizeX * 4;
-		nSrcPitch_temp[1] = nBlkSizeX / xRatioUV * 4;
-		nSrcPitch_temp[2] = nSrcPitch_temp[1];
-
-		pSrc_temp[0] = vs_aligned_malloc<uint8_t>(nBlkSizeY * nSrcPitch_temp[0] + 4, ALIGN_PLANES);
-		pSrc_temp[1] = vs_aligned_malloc<uint8_t>(nBlkSizeY / yRatioUV * nSrcPitch_temp[1] + 4, ALIGN_PLANES);
-		pSrc_temp[2] = vs_aligned_malloc<uint8_t>(nBlkSizeY / yRatioUV * nSrcPitch_temp[2] + 4, ALIGN_PLANES);
-
 		freqSize = 8192 * nPel * 2;
 		freqArray = new int32_t[freqSize];
 		verybigSAD = 1. * nBlkSizeX * nBlkSizeY;
 	}
 	~PlaneOfBlocks() {
-		delete[] vectors;
+		if (!sharedVectors)
+			delete[] vectors;
 		delete[] freqArray;
 
-		vs_aligned_free(dctSrc);
 		vs_aligned_free(dctRef);
-
-		vs_aligned_free(pSrc_temp[0]);
-		vs_aligned_free(pSrc_temp[1]);
-		vs_aligned_free(pSrc_temp[2]);
+	}
+	// while kept, the source blocks prepared for one reference are reused by the searches against the next ones,
+	// every call starts over with a new source.
+	void KeepSourceBlocks(bool keep) {
+		keepSourceBlocks = keep;
+		sourceBlocks.ready = false;
+	}
+	// the smallest plane starts from zero vectors, a reused plane must not see the vectors of the previous frame.
+	// the sads are zeroed like the constructor does, not set to the -1 of VectorStructure{}.
+	void ResetVectors() {
+		std::fill_n(vectors, nBlkCount, VectorStructure{ 0, 0, 0. });
 	}
 	auto GetArraySize(int32_t divideMode) {
 		int32_t size = 0;
@@ -618,6 +754,21 @@ public:
 
 		int32_t lastDirection;
 
+		// candidates of one step are independent of each other, so they are scored as a batch
+		int32_t vx[4];
+		int32_t vy[4];
+		int32_t vals[4];
+		int32_t n = 0;
+		auto Push = [&](int32_t cx, int32_t cy, int32_t val) {
+			vx[n] = cx;
+			vy[n] = cy;
+			vals[n++] = val;
+		};
+		auto Flush = [&]() {
+			CheckBatch(vx, vy, n, [&](auto i, auto pBatchedSAD) { CheckMV2(vx[i], vy[i], &direction, vals[i], pBatchedSAD); });
+			n = 0;
+		};
+
 		while (direction > 0)
 		{
 			dx = bestMV.x;
@@ -628,10 +779,11 @@ public:
 			// First, we look the directions that were hinted by the previous step
 			// of the algorithm. If we find one, we add it to the set of directions
 			// we'll test next
-			if (lastDirection & 1) CheckMV2(dx + length, dy, &direction, 1);
-			if (lastDirection & 2) CheckMV2(dx - length, dy, &direction, 2);
-			if (lastDirection & 4) CheckMV2(dx, dy + length, &direction, 4);
-			if (lastDirection & 8) CheckMV2(dx, dy - length, &direction, 8);
+			if (lastDirection & 1) Push(dx + length, dy, 1);
+			if (lastDirection & 2) Push(dx - length, dy, 2);
+			if (lastDirection & 4) Push(dx, dy + length, 4);
+			if (lastDirection & 8) Push(dx, dy - length, 8);
+			Flush();
 
 			// If one of the directions improves the SAD, we make further tests
 			// on the diagonals
@@ -642,13 +794,14 @@ public:
 
 				if (lastDirection & 3)
 				{
-					CheckMV2(dx, dy + length, &direction, 4);
-					CheckMV2(dx, dy - length, &direction, 8);
+					Push(dx, dy + length, 4);
+					Push(dx, dy - length, 8);
 				}
 				else {
-					CheckMV2(dx + length, dy, &direction, 1);
-					CheckMV2(dx - length, dy, &direction, 2);
+					Push(dx + length, dy, 1);
+					Push(dx - length, dy, 2);
 				}
+				Flush();
 			}
 
 			// If not, we do not stop here. We infer from the last direction the
@@ -656,50 +809,51 @@ public:
 			else {
 				switch (lastDirection) {
 				case 1:
-					CheckMV2(dx + length, dy + length, &direction, 1 + 4);
-					CheckMV2(dx + length, dy - length, &direction, 1 + 8);
+					Push(dx + length, dy + length, 1 + 4);
+					Push(dx + length, dy - length, 1 + 8);
 					break;
 				case 2:
-					CheckMV2(dx - length, dy + length, &direction, 2 + 4);
-					CheckMV2(dx - length, dy - length, &direction, 2 + 8);
+					Push(dx - length, dy + length, 2 + 4);
+					Push(dx - length, dy - length, 2 + 8);
 					break;
 				case 4:
-					CheckMV2(dx + length, dy + length, &direction, 1 + 4);
-					CheckMV2(dx - length, dy + length, &direction, 2 + 4);
+					Push(dx + length, dy + length, 1 + 4);
+					Push(dx - length, dy + length, 2 + 4);
 					break;
 				case 8:
-					CheckMV2(dx + length, dy - length, &direction, 1 + 8);
-					CheckMV2(dx - length, dy - length, &direction, 2 + 8);
+					Push(dx + length, dy - length, 1 + 8);
+					Push(dx - length, dy - length, 2 + 8);
 					break;
 				case 1 + 4:
-					CheckMV2(dx + length, dy + length, &direction, 1 + 4);
-					CheckMV2(dx - length, dy + length, &direction, 2 + 4);
-					CheckMV2(dx + length, dy - length, &direction, 1 + 8);
+					Push(dx + length, dy + length, 1 + 4);
+					Push(dx - length, dy + length, 2 + 4);
+					Push(dx + length, dy - length, 1 + 8);
 					break;
 				case 2 + 4:
-					CheckMV2(dx + length, dy + length, &direction, 1 + 4);
-					CheckMV2(dx - length, dy + length, &direction, 2 + 4);
-					CheckMV2(dx - length, dy - length, &direction, 2 + 8);
+					Push(dx + length, dy + length, 1 + 4);
+					Push(dx - length, dy + length, 2 + 4);
+					Push(dx - length, dy - length, 2 + 8);
 					break;
 				case 1 + 8:
-					CheckMV2(dx + length, dy + length, &direction, 1 + 4);
-					CheckMV2(dx - length, dy - length, &direction, 2 + 8);
-					CheckMV2(dx + length, dy - length, &direction, 1 + 8);
+					Push(dx + length, dy + length, 1 + 4);
+					Push(dx - length, dy - length, 2 + 8);
+					Push(dx + length, dy - length, 1 + 8);
 					break;
 				case 2 + 8:
-					CheckMV2(dx - length, dy - length, &direction, 2 + 8);
-					CheckMV2(dx - length, dy + length, &direction, 2 + 4);
-					CheckMV2(dx + length, dy - length, &direction, 1 + 8);
+					Push(dx - length, dy - length, 2 + 8);
+					Push(dx - length, dy + length, 2 + 4);
+					Push(dx + length, dy - length, 1 + 8);
 					break;
 				default:
 					// Even the default case may happen, in the first step of the
 					// algorithm for example.
-					CheckMV2(dx + length, dy + length, &direction, 1 + 4);
-					CheckMV2(dx - length, dy + length, &direction, 2 + 4);
-					CheckMV2(dx + length, dy - length, &direction, 1 + 8);
-					CheckMV2(dx - length, dy - length, &direction, 2 + 8);
+					Push(dx + length, dy + length, 1 + 4);
+					Push(dx - length, dy + length, 2 + 4);
+					Push(dx + length, dy - length, 1 + 8);
+					Push(dx - length, dy - length, 2 + 8);
 					break;
 				}
+				Flush();
 			}
 		}
 	}
@@ -711,14 +865,9 @@ public:
 			dx = bestMV.x;
 			dy = bestMV.y;
 
-			CheckMV(dx + length, dy + length);
-			CheckMV(dx + length, dy);
-			CheckMV(dx + length, dy - length);
-			CheckMV(dx, dy - length);
-			CheckMV(dx, dy + length);
-			CheckMV(dx - length, dy + length);
-			CheckMV(dx - length, dy);
-			CheckMV(dx - length, dy - length);
+			const int32_t vx[] = { dx + length, dx + length, dx + length, dx, dx, dx - length, dx - length, dx - length };
+			const int32_t vy[] = { dy + length, dy, dy - length, dy - length, dy + length, dy + length, dy, dy - length };
+			CheckMVs(vx, vy, 8);
 
 			length--;
 		}
@@ -772,30 +921,75 @@ public:
 			}
 		}
 	}
+	// transforms the source blocks of the level one block row at a time, see SourceBlockCache.
+	void PrepareSourceBlocks() {
+		auto dctSize = nBlkSizeY * dctpitch;
+		auto pPlane = pSrcFrame->GetPlane(YPLANE);
+		auto step = (nBlkSizeX - nOverlapX) * static_cast<int32_t>(sizeof(float));
+		sourceBlocks.dct.resize(dctmode <= 4 ? nBlkCount * dctSize : 0); //don't do the slow dct conversion if SATD used
+		sourceBlocks.luma.resize(dctmode >= 3 ? nBlkCount : 0);
+		for (int32_t by = 0; by < nBlkY; by++) {
+			auto yRow = pPlane->GetVPadding() + (nBlkSizeY - nOverlapY) * by;
+			if (dctmode <= 4)
+				DCT->DCTBlocks2D(pPlane->GetAbsolutePelPointer(pPlane->GetHPadding(), yRow), nSrcPitch[0], nBlkX, step, &sourceBlocks.dct[by * nBlkX * dctSize]);
+			if (dctmode >= 3)
+				for (int32_t bx = 0; bx < nBlkX; bx++) {
+					auto xBlock = pPlane->GetHPadding() + (nBlkSizeX - nOverlapX) * bx;
+					sourceBlocks.luma[by * nBlkX + bx] = pPlane->GetAbsoluteBlockSum(xBlock * nPel, yRow * nPel, nBlkSizeX, nBlkSizeY);
+				}
+		}
+		sourceBlocks.ready = true;
+	}
+	// the DCT method is luma only, chroma still uses the spatial SAD.
+	void PrepareSourceBlock() {
+		if (!sourceCache)
+			return;
+		if (dctmode <= 4)
+			dctSrc = &sourceCache->dct[blkIdx * nBlkSizeY * dctpitch];
+		if (dctmode >= 3)
+			srcLuma = sourceCache->luma[blkIdx];
+	}
+	// blocks of a static region get the zero vector without a search.
+	void TakeZeroMV() {
+		PrepareSourceBlock();
+		bestMV.x = zeroMVfieldShifted.x;
+		bestMV.y = zeroMVfieldShifted.y;
+		bestMV.sad = LumaSAD(0, zeroMVfieldShifted.y) + ChromaSAD(0, 0);
+		StoreBestMV();
+	}
 	void PseudoEPZSearch() {
 
 		FetchPredictors();
+		ResetCandidateMemo(!tryMany);
 
 		double sad;
 		double saduv;
 
-		if (dctmode != 0) // DCT method (luma only - currently use normal spatial SAD chroma)
-		{
-			// make dct of source block
-			if (dctmode <= 4) //don't do the slow dct conversion if SATD used
-				DCT->DCTBytes2D(pSrc[0], nSrcPitch[0], dctSrc, dctpitch);
-		}
-		if (dctmode >= 3) // most use it and it should be fast anyway //if (dctmode == 3 || dctmode == 4) // check it
-			srcLuma = LUMA(pSrc[0], nSrcPitch[0]);
+		PrepareSourceBlock();
 
+		globalMVPredictor = ClipMV(globalMVPredictor);
+
+		// zero, global and predictor are always scored, without tryMany nothing moves in between so they share one batch
+		double fixedSAD[4];
+		bool fixedBatched = !tryMany && dctmode == 0;
+		if (fixedBatched) {
+			const uint8_t* pRefs[] = {
+				GetRefBlock(0, zeroMVfieldShifted.y),
+				GetRefBlock(globalMVPredictor.x, globalMVPredictor.y),
+				GetRefBlock(predictor.x, predictor.y),
+				GetRefBlock(predictor.x, predictor.y)
+			};
+			SADX4(pSrc[0], nSrcPitch[0], pRefs, nRefPitch[0], fixedSAD);
+			for (auto& x : fixedSAD)
+				x *= PixelScale;
+		}
 
 		// We treat zero alone
 		// Do we bias zero with not taking into account distorsion ?
 		bestMV.x = zeroMVfieldShifted.x;
 		bestMV.y = zeroMVfieldShifted.y;
-		saduv = (chroma) ? SADCHROMA(pSrc[1], nSrcPitch[1], GetRefBlockU(0, 0), nRefPitch[1])
-			+ SADCHROMA(pSrc[2], nSrcPitch[2], GetRefBlockV(0, 0), nRefPitch[2]) : 0.f;
-		sad = LumaSAD(GetRefBlock(0, zeroMVfieldShifted.y));
+		saduv = ChromaSAD(0, 0);
+		sad = fixedBatched ? fixedSAD[0] : LumaSAD(0, zeroMVfieldShifted.y);
 		sad += saduv;
 		bestMV.sad = sad;
 		nMinCost = sad + ((penaltyZero * sad) / 256); // v.1.11.0.2
@@ -812,10 +1006,8 @@ public:
 		}
 
 		// Global MV predictor  - added by Fizick
-		globalMVPredictor = ClipMV(globalMVPredictor);
-		saduv = (chroma) ? SADCHROMA(pSrc[1], nSrcPitch[1], GetRefBlockU(globalMVPredictor.x, globalMVPredictor.y), nRefPitch[1])
-			+ SADCHROMA(pSrc[2], nSrcPitch[2], GetRefBlockV(globalMVPredictor.x, globalMVPredictor.y), nRefPitch[2]) : 0.f;
-		sad = LumaSAD(GetRefBlock(globalMVPredictor.x, globalMVPredictor.y));
+		saduv = ChromaSAD(globalMVPredictor.x, globalMVPredictor.y);
+		sad = fixedBatched ? fixedSAD[1] : LumaSAD(globalMVPredictor.x, globalMVPredictor.y);
 		sad += saduv;
 		double cost = sad + ((pglobal * sad) / 256.);
 
@@ -833,9 +1025,8 @@ public:
 			bestMVMany[1] = bestMV;    // save bestMV
 			nMinCostMany[1] = nMinCost;
 		}
-		saduv = (chroma) ? SADCHROMA(pSrc[1], nSrcPitch[1], GetRefBlockU(predictor.x, predictor.y), nRefPitch[1])
-			+ SADCHROMA(pSrc[2], nSrcPitch[2], GetRefBlockV(predictor.x, predictor.y), nRefPitch[2]) : 0.f;
-		sad = LumaSAD(GetRefBlock(predictor.x, predictor.y));
+		saduv = ChromaSAD(predictor.x, predictor.y);
+		sad = fixedBatched ? fixedSAD[2] : LumaSAD(predictor.x, predictor.y);
 		sad += saduv;
 		cost = sad;
 
@@ -854,22 +1045,34 @@ public:
 			nMinCostMany[2] = nMinCost;
 		}
 
+		if (!tryMany && IsStaticBlock()) {
+			staticSkips++;
+			StoreBestMV();
+			return;
+		}
+
 		// then all the other predictors
 		int32_t npred = (temporal) ? 5 : 4;
 		constexpr auto epsilon = 1e-5;
 
-		for (int32_t i = 0; i < npred; i++)
-		{
-			if (tryMany)
-				nMinCost = verybigSAD + epsilon;
-			CheckMV0(predictors[i].x, predictors[i].y);
-			if (tryMany)
+		if (tryMany)
+			for (int32_t i = 0; i < npred; i++)
 			{
+				nMinCost = verybigSAD + epsilon;
+				CheckMV0(predictors[i].x, predictors[i].y);
 				// refine around predictor
 				Refine();    // reset bestMV
 				bestMVMany[i + 3] = bestMV;    // save bestMV
 				nMinCostMany[i + 3] = nMinCost;
 			}
+		else {
+			int32_t vx[MAX_PREDICTOR];
+			int32_t vy[MAX_PREDICTOR];
+			for (int32_t i = 0; i < npred; i++) {
+				vx[i] = predictors[i].x;
+				vy[i] = predictors[i].y;
+			}
+			CheckBatch(vx, vy, npred, [&](auto i, auto pBatchedSAD) { CheckMV0(vx[i], vy[i], pBatchedSAD); });
 		}
 
 
@@ -894,9 +1097,11 @@ public:
 
 		constexpr auto BADCOUNT_LIMIT = 16;
 
-		if (blkIdx > 1 && foundSAD > (badSAD + badSAD * badcount / BADCOUNT_LIMIT)) // bad vector, try wide search
+		if (blkIdx > 1 && foundSAD > badSAD && foundSAD > (badSAD + badSAD * BadCount() / BADCOUNT_LIMIT)) // bad vector, try wide search
 		{// with some soft limit (BADCOUNT_LIMIT) of bad cured vectors (time consumed)
 			badcount++;
+			if (stats)
+				stats->badSAD++;
 
 			if (badrange > 0) // UMH
 			{
@@ -926,36 +1131,153 @@ public:
 			}
 		}
 
-
+		StoreBestMV();
+	}
+	inline void StoreBestMV() {
 		// we store the result
 		vectors[blkIdx].x = bestMV.x;
 		vectors[blkIdx].y = bestMV.y;
 		vectors[blkIdx].sad = bestMV.sad;
 
 		planeSAD += bestMV.sad;
-
+		if (stats)
+			stats->wins[GetWinner()]++;
+	}
+	// the first candidate the stored vector equals, vectors no predictor proposed were found by the search.
+	SearchCounters::Winner GetWinner() {
+		auto Is = [&](const VectorStructure& v) { return bestMV.x == v.x && bestMV.y == v.y; };
+		if (Is(zeroMVfieldShifted))
+			return SearchCounters::Zero;
+		if (Is(globalMVPredictor))
+			return SearchCounters::Global;
+		if (Is(predictor))
+			return SearchCounters::Coarse;
+		for (int32_t i = 0; i < 4; i++)
+			if (Is(predictors[i]))
+				return SearchCounters::Spatial;
+		if (temporal && Is(predictors[4]))
+			return SearchCounters::Temporal;
+		return SearchCounters::Search;
 	}
-	void ExpandingSearch(int32_t r, int32_t s, int32_t mvx, int32_t mvy) {
+	// a block whose zero, global or predictor vector already matches well below what its neighbours ended up with is
+	// taken as static, the neighbour SADs scale the threshold with the local texture and noise.
+	inline bool IsStaticBlock() {
+		auto a = predictors[1].sad;
+		auto b = predictors[2].sad;
+		auto c = predictors[3].sad;
+		auto neighbourSAD = max(min(a, b), min(max(a, b), c));
+		return staticRatio > 0 && bestMV.sad < staticRatio * neighbourSAD;
+	}
+	// luma block sums of every reference block whose vector lies within r of (mvx, mvy). the vectors of one pel phase
+	// address consecutive blocks of the same sub-plane, so their sums come from running column sums over that sub-plane
+	// instead of one pass over each block.
+	void BuildRefBlockSums(int32_t r, int32_t mvx, int32_t mvy) {
+		auto vxHi = std::min(mvx + r, nDxMax - 1);
+		auto vyHi = std::min(mvy + r, nDyMax - 1);
+		nSumsX = std::max(mvx - r, nDxMin);
+		nSumsY = std::max(mvy - r, nDyMin);
+		nSumsWidth = std::max(0, vxHi - nSumsX + 1);
+		nSumsHeight = std::max(0, vyHi - nSumsY + 1);
+		refBlockSums.resize(nSumsWidth * nSumsHeight);
+		srcBlockSum = 0;
+		for (int32_t h = 0; h < nBlkSizeY; h++) {
+			auto pRow = reinterpret_cast<const float*>(pSrc[0] + nSrcPitch[0] * h);
+			for (int32_t w = 0; w < nBlkSizeX; w++)
+				srcBlockSum += pRow[w];
+		}
+		for (int32_t py = 0; py < nPel; py++)
+			for (int32_t px = 0; px < nPel; px++) {
+				auto vx0 = nSumsX + px;
+				auto vy0 = nSumsY + py;
+				if (vx0 > vxHi || vy0 > vyHi)
+					continue;
+				auto nx = (vxHi - vx0) / nPel + 1;
+				auto ny = (vyHi - vy0) / nPel + 1;
+				auto pBase = GetRefBlock(vx0, vy0);
+				auto Row = [&](int32_t h) { return reinterpret_cast<const float*>(pBase + nRefPitch[0] * h); };
+				auto nColumns = nx + nBlkSizeX - 1;
+				columnSums.assign(nColumns, 0.);
+				for (int32_t m = 0; m < ny; m++) {
+					if (m == 0)
+						for (int32_t h = 0; h < nBlkSizeY; h++) {
+							auto pRow = Row(h);
+							for (int32_t c = 0; c < nColumns; c++)
+								columnSums[c] += pRow[c];
+						}
+					else {
+						auto pIn = Row(m + nBlkSizeY - 1);
+						auto pOut = Row(m - 1);
+						for (int32_t c = 0; c < nColumns; c++)
+							columnSums[c] += static_cast<double>(pIn[c]) - pOut[c];
+					}
+					auto sum = 0.;
+					for (int32_t c = 0; c < nBlkSizeX; c++)
+						sum += columnSums[c];
+					auto pSums = &refBlockSums[(vy0 - nSumsY + m * nPel) * nSumsWidth + vx0 - nSumsX];
+					for (int32_t k = 0; k < nx; k++) {
+						if (k > 0)
+							sum += columnSums[k + nBlkSizeX - 1] - columnSums[k - 1];
+						pSums[k * nPel] = sum;
+					}
+				}
+			}
+	}
+	// successive elimination: |sum(src) - sum(ref)| never exceeds the luma SAD, so a candidate whose bound alone
+	// already loses to the best cost would be rejected by CheckMV and is dropped before its block is read.
+	// the margin covers the float rounding of the SAD kernels and of the running sums.
+	bool EliminatedBySums(int32_t vx, int32_t vy) {
+		if (!IsVectorOK(vx, vy))
+			return false;
+		auto refSum = refBlockSums[(vy - nSumsY) * nSumsWidth + vx - nSumsX];
+		auto bound = (std::abs(srcBlockSum - refSum) - 1e-9 * (std::abs(srcBlockSum) + std::abs(refSum))) * (1. - 1e-6) * PixelScale;
+		auto eliminated = MotionDistorsion(vx, vy) + bound * (1. + penaltyNew / 256.) >= nMinCost;
+		if (stats)
+			stats->earlyExit += eliminated;
+		return eliminated;
+	}
+	// same candidates in the same order as ExpandingSearch over radius 1 to r, with successive elimination for plain SAD.
+	void ExhaustiveSearch(int32_t r, int32_t mvx, int32_t mvy) {
+		auto bEliminate = dctmode == 0 && penaltyNew >= 0;
+		if (bEliminate)
+			BuildRefBlockSums(r, mvx, mvy);
+		for (int32_t i = 1; i <= r; i++)
+			ExpandingSearch(i, 1, mvx, mvy, bEliminate);
+	}
+	void ExpandingSearch(int32_t r, int32_t s, int32_t mvx, int32_t mvy, bool bEliminate = false) {
 		int32_t i, j;
+		int32_t vx[MAX_BATCH];
+		int32_t vy[MAX_BATCH];
+		int32_t n = 0;
+		auto Push = [&](int32_t cx, int32_t cy) {
+			if (bEliminate && EliminatedBySums(cx, cy))
+				return;
+			vx[n] = cx;
+			vy[n++] = cy;
+			if (n == MAX_BATCH) {
+				CheckMVs(vx, vy, n);
+				n = 0;
+			}
+		};
 
 		// sides of square without corners
 		for (i = -r + s; i < r; i += s) // without corners! - v2.1
 		{
-			CheckMV(mvx + i, mvy - r);
-			CheckMV(mvx + i, mvy + r);
+			Push(mvx + i, mvy - r);
+			Push(mvx + i, mvy + r);
 		}
 
 		for (j = -r + s; j < r; j += s)
 		{
-			CheckMV(mvx - r, mvy + j);
-			CheckMV(mvx + r, mvy + j);
+			Push(mvx - r, mvy + j);
+			Push(mvx + r, mvy + j);
 		}
 
 		// then corners - they are more far from cenrer
-		CheckMV(mvx - r, mvy - r);
-		CheckMV(mvx - r, mvy + r);
-		CheckMV(mvx + r, mvy - r);
-		CheckMV(mvx + r, mvy + r);
+		Push(mvx - r, mvy - r);
+		Push(mvx - r, mvy + r);
+		Push(mvx + r, mvy - r);
+		Push(mvx + r, mvy + r);
+		CheckMVs(vx, vy, n);
 	}
 	void Hex2Search(int32_t i_me_range) {
 		auto zip = [](auto x, auto y) {
@@ -978,12 +1300,9 @@ public:
 			//        COPY2_IF_LT( bcost, costs[3], dir, 3 );
 			//        COPY2_IF_LT( bcost, costs[4], dir, 4 );
 			//        COPY2_IF_LT( bcost, costs[5], dir, 5 );
-			CheckMVdir(bmx - 2, bmy, &dir, 0);
-			CheckMVdir(bmx - 1, bmy + 2, &dir, 1);
-			CheckMVdir(bmx + 1, bmy + 2, &dir, 2);
-			CheckMVdir(bmx + 2, bmy, &dir, 3);
-			CheckMVdir(bmx + 1, bmy - 2, &dir, 4);
-			CheckMVdir(bmx - 1, bmy - 2, &dir, 5);
+			const int32_t vx[] = { bmx - 2, bmx - 1, bmx + 1, bmx + 2, bmx + 1, bmx - 1 };
+			const int32_t vy[] = { bmy, bmy + 2, bmy + 2, bmy, bmy - 2, bmy - 2 };
+			CheckBatch(vx, vy, 6, [&](auto i, auto pBatchedSAD) { CheckMVdir(vx[i], vy[i], &dir, i, pBatchedSAD); });
 
 
 			if (dir != -2)
@@ -1004,9 +1323,9 @@ public:
 					//                COPY2_IF_LT( bcost, costs[1], dir, odir   );
 					//                COPY2_IF_LT( bcost, costs[2], dir, odir+1 );
 
-					CheckMVdir(bmx + hex2[odir + 0][0], bmy + hex2[odir + 0][1], &dir, odir - 1);
-					CheckMVdir(bmx + hex2[odir + 1][0], bmy + hex2[odir + 1][1], &dir, odir);
-					CheckMVdir(bmx + hex2[odir + 2][0], bmy + hex2[odir + 2][1], &dir, odir + 1);
+					const int32_t hx[] = { bmx + hex2[odir + 0][0], bmx + hex2[odir + 1][0], bmx + hex2[odir + 2][0] };
+					const int32_t hy[] = { bmy + hex2[odir + 0][1], bmy + hex2[odir + 1][1], bmy + hex2[odir + 2][1] };
+					CheckBatch(hx, hy, 3, [&](auto i, auto pBatchedSAD) { CheckMVdir(hx[i], hy[i], &dir, odir - 1 + i, pBatchedSAD); });
 					if (dir == -2)
 						break;
 					bmx += hex2[dir + 1][0];
@@ -1025,18 +1344,30 @@ public:
 
 	}
 	void CrossSearch(int32_t start, int32_t x_max, int32_t y_max, int32_t mvx, int32_t mvy) {
+		int32_t vx[MAX_BATCH];
+		int32_t vy[MAX_BATCH];
+		int32_t n = 0;
+		auto Push = [&](int32_t cx, int32_t cy) {
+			vx[n] = cx;
+			vy[n++] = cy;
+			if (n == MAX_BATCH) {
+				CheckMVs(vx, vy, n);
+				n = 0;
+			}
+		};
 
 		for (int32_t i = start; i < x_max; i += 2)
 		{
-			CheckMV(mvx - i, mvy);
-			CheckMV(mvx + i, mvy);
+			Push(mvx - i, mvy);
+			Push(mvx + i, mvy);
 		}
 
 		for (int32_t j = start; j < y_max; j += 2)
 		{
-			CheckMV(mvx, mvy + j);
-			CheckMV(mvx, mvy + j);
+			Push(mvx, mvy + j);
+			Push(mvx, mvy + j);
 		}
+		CheckMVs(vx, vy, n);
 	}
 	void UMHSearch(int32_t i_me_range, int32_t omx, int32_t omy) {
 		// Uneven-cross Multi-Hexagon-grid Search (see x264)
@@ -1058,12 +1389,14 @@ public:
 				{ -2,-3 },{ 0,-4 },{ 2,-3 },
 			};
 
+			int32_t vx[16];
+			int32_t vy[16];
 			for (int32_t j = 0; j < 16; j++)
 			{
-				int32_t mx = omx + hex4[j][0] * i;
-				int32_t my = omy + hex4[j][1] * i;
-				CheckMV(mx, my);
+				vx[j] = omx + hex4[j][0] * i;
+				vy[j] = omy + hex4[j][1] * i;
 			}
+			CheckMVs(vx, vy, 16);
 		} while (++i <= i_me_range / 4);
 
 		//            if( bmy <= mv_y_max )
@@ -1071,17 +1404,17 @@ public:
 		Hex2Search(i_me_range);
 
 	}
-	void SearchMVs(MVFrame* _pSrcFrame, MVFrame* _pRefFrame,
+	// per-plane search settings, shared by the serial scan and every wavefront context.
+	void PrepareSearch(MVFrame* _pSrcFrame, MVFrame* _pRefFrame,
 		SearchType st, int32_t stp, double lambda, double lsad, int32_t pnew,
-		int32_t plevel, int32_t* out, VectorStructure* globalMVec,
-		int32_t* outfilebuf, int32_t fieldShift, DCTClass* _DCT, double* pmeanLumaChange,
-		int32_t divideExtra, int32_t _pzero, int32_t _pglobal, double _badSAD, int32_t _badrange, bool meander, int32_t* vecPrev, bool _tryMany) {
+		int32_t plevel, const VectorStructure* globalMVec, int32_t fieldShift, DCTClass* _DCT, double meanLumaChange,
+		int32_t _pzero, int32_t _pglobal, double _badSAD, int32_t _badrange, int32_t* _vecPrev, bool _tryMany, double _staticRatio) {
 		DCT = _DCT;
 		if (DCT == 0)
 			dctmode = 0;
 		else
 			dctmode = DCT->dctmode;
-		dctweight16 = min(16, std::abs(*pmeanLumaChange) / (nBlkSizeX * nBlkSizeY)); //equal dct and spatial weights for meanLumaChange=8 (empirical)
+		dctweight16 = min(16, std::abs(meanLumaChange) / (nBlkSizeX * nBlkSizeY)); //equal dct and spatial weights for meanLumaChange=8 (empirical)
 		badSAD = _badSAD;
 		badrange = _badrange;
 		zeroMVfieldShifted.x = 0;
@@ -1091,28 +1424,13 @@ public:
 		globalMVPredictor.y = nPel * globalMVec->y + fieldShift;
 		globalMVPredictor.sad = globalMVec->sad;
 
-		// write the plane's header
-		WriteHeaderToArray(out);
-
-		int32_t* pBlkData = out + 1;
-		temporal = (vecPrev) ? true : false;
-		if (vecPrev) vecPrev += 1; // same as BlkData
+		temporal = (_vecPrev) ? true : false;
+		vecPrev = (_vecPrev) ? _vecPrev + 1 : nullptr; // same as BlkData
 
 		pSrcFrame = _pSrcFrame;
 		pRefFrame = _pRefFrame;
 
-
-		y[0] = pSrcFrame->GetPlane(YPLANE)->GetVPadding();
-
-		if (pSrcFrame->GetMode() & UPLANE)
-		{
-			y[1] = pSrcFrame->GetPlane(UPLANE)->GetVPadding();
-		}
-		if (pSrcFrame->GetMode() & VPLANE)
-		{
-			y[2] = pSrcFrame->GetPlane(VPLANE)->GetVPadding();
-		}
-
+		// every kernel takes a pitch and loads unaligned, so source blocks are read in place from the super clip.
 		nSrcPitch[0] = pSrcFrame->GetPlane(YPLANE)->GetPitch();
 		if (chroma)
 		{
@@ -1130,134 +1448,265 @@ public:
 		searchType = st;//( nLogScale == 0 ) ? st : EXHAUSTIVE;
 		nSearchParam = stp;//*nPel; // v1.8.2 - redesigned in v1.8.5
 
-		double nLambdaLevel = lambda / (nPel * nPel);
+		nLambdaLevel = lambda / (nPel * nPel);
 		if (plevel == 1)
 			nLambdaLevel = nLambdaLevel * nScale;// scale lambda - Fizick
 		else if (plevel == 2)
 			nLambdaLevel = nLambdaLevel * nScale * nScale;
 
+		penaltyNewLevel = pnew;
+		LSADLevel = lsad;
 		penaltyZero = _pzero;
 		pglobal = _pglobal;
 		planeSAD = 0.0;
 		badcount = 0;
 		tryMany = _tryMany;
 		sumLumaChange = 0.;
-		// Functions using double must not be used here
-
-		for (blky = 0; blky < nBlkY; blky++)
+		staticRatio = _staticRatio;
+		staticSkips = 0;
+		if (stats)
+			*stats = {};
+	}
+	// positions the block and computes its search boundaries.
+	void SetBlock(int32_t _blkx, int32_t _blky, int32_t _blkScanDir) {
+		blkx = _blkx;
+		blky = _blky;
+		blkScanDir = _blkScanDir;
+		blkIdx = blky * nBlkX + blkx;
+		x[0] = pSrcFrame->GetPlane(YPLANE)->GetHPadding() + (nBlkSizeX - nOverlapX) * blkx;
+		y[0] = pSrcFrame->GetPlane(YPLANE)->GetVPadding() + (nBlkSizeY - nOverlapY) * blky;
+		if (chroma)
 		{
-			blkScanDir = (blky % 2 == 0 || meander == false) ? 1 : -1;
-			// meander (alternate) scan blocks (even row left to right, odd row right to left)
-			int32_t blkxStart = (blky % 2 == 0 || meander == false) ? 0 : nBlkX - 1;
-			if (blkScanDir == 1) // start with leftmost block
-			{
-				x[0] = pSrcFrame->GetPlane(YPLANE)->GetHPadding();
-				if (chroma)
-				{
-					x[1] = pSrcFrame->GetPlane(UPLANE)->GetHPadding();
-					x[2] = pSrcFrame->GetPlane(VPLANE)->GetHPadding();
-				}
-			}
-			else // start with rightmost block, but it is already set at prev row
-			{
-				x[0] = pSrcFrame->GetPlane(YPLANE)->GetHPadding() + (nBlkSizeX - nOverlapX) * (nBlkX - 1);
-				if (chroma)
-				{
-					x[1] = pSrcFrame->GetPlane(UPLANE)->GetHPadding() + ((nBlkSizeX - nOverlapX) / xRatioUV) * (nBlkX - 1);
-					x[2] = pSrcFrame->GetPlane(VPLANE)->GetHPadding() + ((nBlkSizeX - nOverlapX) / xRatioUV) * (nBlkX - 1);
-				}
+			x[1] = pSrcFrame->GetPlane(UPLANE)->GetHPadding() + ((nBlkSizeX - nOverlapX) >> nLogxRatioUV) * blkx;
+			x[2] = pSrcFrame->GetPlane(VPLANE)->GetHPadding() + ((nBlkSizeX - nOverlapX) >> nLogxRatioUV) * blkx;
+			y[1] = pSrcFrame->GetPlane(UPLANE)->GetVPadding() + ((nBlkSizeY - nOverlapY) >> nLogyRatioUV) * blky;
+			y[2] = pSrcFrame->GetPlane(VPLANE)->GetVPadding() + ((nBlkSizeY - nOverlapY) >> nLogyRatioUV) * blky;
+		}
+
+		// decreased padding of coarse levels
+		int32_t nHPaddingScaled = pSrcFrame->GetPlane(YPLANE)->GetHPadding() >> nLogScale;
+		int32_t nVPaddingScaled = pSrcFrame->GetPlane(YPLANE)->GetVPadding() >> nLogScale;
+		/* computes search boundaries */
+		nDxMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedWidth() - x[0] - nBlkSizeX - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled);
+		nDyMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedHeight() - y[0] - nBlkSizeY - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled);
+		nDxMin = -nPel * (x[0] - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled);
+		nDyMin = -nPel * (y[0] - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled);
+	}
+	// the pre-pass: a block is static when its co-located luma differs from the reference by less than the threshold
+	// per pixel on average.
+	void MarkStaticBlocks(double threshold) {
+		if (threshold <= 0) {
+			staticMask = nullptr;
+			return;
+		}
+		staticBlocks.resize(nBlkCount);
+		staticMask = staticBlocks.data();
+		for (int32_t by = 0; by < nBlkY; by++)
+			for (int32_t bx = 0; bx < nBlkX; bx++) {
+				SetBlock(bx, by, 1);
+				auto pSrcBlock = pSrcFrame->GetPlane(YPLANE)->GetAbsolutePelPointer(x[0], y[0]);
+				staticBlocks[blkIdx] = SAD(pSrcBlock, nSrcPitch[0], GetRefBlock(0, zeroMVfieldShifted.y), nRefPitch[0]) * PixelScale < threshold * nBlkSizeX * nBlkSizeY;
 			}
-			for (int32_t iblkx = 0; iblkx < nBlkX; iblkx++)
-			{
-				blkx = blkxStart + iblkx * blkScanDir;
-				blkIdx = blky * nBlkX + blkx;
-				iter = 0;
+	}
+	// searches the block set by SetBlock and writes its vector to pBlkData.
+	void SearchBlock(int32_t* pBlkData) {
+		iter = 0;
 
-				pSrc[0] = pSrcFrame->GetPlane(YPLANE)->GetAbsolutePelPointer(x[0], y[0]);
-				if (chroma)
-				{
-					pSrc[1] = pSrcFrame->GetPlane(UPLANE)->GetAbsolutePelPointer(x[1], y[1]);
-					pSrc[2] = pSrcFrame->GetPlane(VPLANE)->GetAbsolutePelPointer(x[2], y[2]);
-				}
+		pSrc[0] = pSrcFrame->GetPlane(YPLANE)->GetAbsolutePelPointer(x[0], y[0]);
+		if (chroma)
+		{
+			pSrc[1] = pSrcFrame->GetPlane(UPLANE)->GetAbsolutePelPointer(x[1], y[1]);
+			pSrc[2] = pSrcFrame->GetPlane(VPLANE)->GetAbsolutePelPointer(x[2], y[2]);
+		}
 
-				nSrcPitch[0] = pSrcFrame->GetPlane(YPLANE)->GetPitch();
-				//create aligned copy
-				BLITLUMA(pSrc_temp[0], nSrcPitch_temp[0], pSrc[0], nSrcPitch[0]);
-				//set the to the aligned copy
-				pSrc[0] = pSrc_temp[0];
-				nSrcPitch[0] = nSrcPitch_temp[0];
-				if (chroma)
-				{
-					nSrcPitch[1] = pSrcFrame->GetPlane(UPLANE)->GetPitch();
-					nSrcPitch[2] = pSrcFrame->GetPlane(VPLANE)->GetPitch();
-					BLITCHROMA(pSrc_temp[1], nSrcPitch_temp[1], pSrc[1], nSrcPitch[1]);
-					BLITCHROMA(pSrc_temp[2], nSrcPitch_temp[2], pSrc[2], nSrcPitch[2]);
-					pSrc[1] = pSrc_temp[1];
-					pSrc[2] = pSrc_temp[2];
-					nSrcPitch[1] = nSrcPitch_temp[1];
-					nSrcPitch[2] = nSrcPitch_temp[2];
-				}
+		if (blky == 0)
+			nLambda = 0.;
+		else
+			nLambda = nLambdaLevel;
 
-				if (blky == 0)
-					nLambda = 0.;
-				else
-					nLambda = nLambdaLevel;
+		penaltyNew = penaltyNewLevel; // penalty for new vector
+		LSAD = LSADLevel;    // SAD limit for lambda using
+		// may be they must be scaled by nPel ?
 
-				penaltyNew = pnew; // penalty for new vector
-				LSAD = lsad;    // SAD limit for lambda using
-								// may be they must be scaled by nPel ?
-
-								// decreased padding of coarse levels
-				int32_t nHPaddingScaled = pSrcFrame->GetPlane(YPLANE)->GetHPadding() >> nLogScale;
-				int32_t nVPaddingScaled = pSrcFrame->GetPlane(YPLANE)->GetVPadding() >> nLogScale;
-				/* computes search boundaries */
-				nDxMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedWidth() - x[0] - nBlkSizeX - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled);
-				nDyMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedHeight() - y[0] - nBlkSizeY - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled);
-				nDxMin = -nPel * (x[0] - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled);
-				nDyMin = -nPel * (y[0] - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled);
-
-				/* search the mv */
-				predictor = ClipMV(vectors[blkIdx]);
-				if (temporal)
-					predictors[4] = ClipMV(reinterpret_cast<VectorStructure&>(vecPrev[blkIdx * N_PER_BLOCK])); // temporal predictor
-				else
-					predictors[4] = ClipMV(zeroMV);
+		/* search the mv */
+		predictor = ClipMV(vectors[blkIdx]);
+		if (temporal)
+			predictors[4] = ClipMV(reinterpret_cast<VectorStructure&>(vecPrev[blkIdx * N_PER_BLOCK])); // temporal predictor
+		else
+			predictors[4] = ClipMV(zeroMV);
 
-				PseudoEPZSearch();
+		if (staticMask && staticMask[blkIdx])
+			TakeZeroMV();
+		else
+			PseudoEPZSearch();
 
+		/* write the results */
+		auto& BlockData = reinterpret_cast<VectorStructure&>(pBlkData[blkIdx * N_PER_BLOCK]);
+		BlockData = bestMV;
+	}
+	inline double BlockLumaChange() {
+		return (GetRefBlockLuma(0, 0) - GetSrcBlockLuma()) * PixelScale;
+	}
+	// bad vectors found before the current block, the wide search gets less eager as they pile up. only asked for
+	// blocks whose vector is bad, so the wavefront only stalls on those.
+	int32_t BadCount() {
+		return wavefront ? wavefront->BadCountBefore(blky, wavefrontPos) : badcount;
+	}
+	// rows are handed out top to bottom and every block waits until the row above has finished the blocks its up and
+	// up-right predictors come from, the bottom-right coarse predictor is read before the row below may overwrite it.
+	// with meander every row starts where the row above ends, so the rows run one after another. a bad block waits for
+	// the rows above to finish before it decides on the wide search, see BadCountBefore.
+	void SearchMVsWavefront(ThreadPool* pool, int32_t* pBlkData, bool meander, const std::function<void(PlaneOfBlocks&, DCTClass*)>& Prepare) {
+		auto nContexts = pool->GetParticipantCount() - 1;
+		auto sourceDCT = DCT;
+		if (sourceDCT && (wavefrontDCTs.size() != static_cast<size_t>(nContexts) || wavefrontDCTs[0]->sizex != sourceDCT->sizex || wavefrontDCTs[0]->sizey != sourceDCT->sizey || wavefrontDCTs[0]->dctmode != sourceDCT->dctmode)) {
+			wavefrontDCTs.clear();
+			for (auto i = 0; i < nContexts; ++i)
+				wavefrontDCTs.emplace_back(sourceDCT->Clone());
+		}
+		while (wavefrontContexts.size() < static_cast<size_t>(nContexts)) {
+			auto context = std::make_unique<PlaneOfBlocks>(nBlkX, nBlkY, nBlkSizeX, nBlkSizeY, nPel, nLogScale, nMotionFlags, nOverlapX, nOverlapY, xRatioUV, yRatioUV);
+			delete[] context->vectors;
+			context->vectors = vectors;
+			context->sharedVectors = true;
+			wavefrontContexts.push_back(std::move(context));
+		}
 
-				/* write the results */
+		auto rows = WavefrontRows{ nBlkX, nBlkY };
+		// the global predictor is clipped in place by every searched block, so replay the clipping in scan order up
+		// front. static blocks take the zero vector without touching it.
+		auto globalPredictors = std::vector<VectorStructure>(nBlkCount);
+		for (int32_t by = 0; by < nBlkY; by++) {
+			auto scanDir = (by % 2 == 0 || meander == false) ? 1 : -1;
+			auto bxStart = (scanDir == 1) ? 0 : nBlkX - 1;
+			for (int32_t i = 0; i < nBlkX; i++) {
+				SetBlock(bxStart + i * scanDir, by, scanDir);
+				if (!staticMask || !staticMask[blkIdx])
+					globalMVPredictor = ClipMV(globalMVPredictor);
+				globalPredictors[blkIdx] = globalMVPredictor;
+			}
+		}
+		auto lastGlobalPredictor = globalMVPredictor;
+
+		for (auto& context : wavefrontContexts) {
+			context->counters = {};
+			context->stats = stats ? &context->counters : nullptr;
+			context->staticSkips = 0;
+			context->staticMask = staticMask;
+			context->sourceCache = sourceCache;
+		}
+		auto lumaChange = std::vector<double>(smallestPlane ? nBlkCount : 0);
+		auto blockSAD = std::vector<double>(nBlkCount);
+		pool->Run([&](int32_t participant) {
+			auto& context = participant == 0 ? *this : *wavefrontContexts[participant - 1];
+			auto prepared = false;
+			for (auto by = rows.nextRow++; by < nBlkY; by = rows.nextRow++) {
+				if (!prepared) {
+					if (participant > 0)
+						Prepare(context, sourceDCT ? wavefrontDCTs[participant - 1].get() : nullptr);
+					context.wavefront = &rows;
+					prepared = true;
+				}
+				auto scanDir = (by % 2 == 0 || meander == false) ? 1 : -1;
+				auto bxStart = (scanDir == 1) ? 0 : nBlkX - 1;
+				auto aboveScanDir = ((by - 1) % 2 == 0 || meander == false) ? 1 : -1;
+				auto reach = 0;
+				auto nBad = 0;
+				for (int32_t i = 0; i < nBlkX; i++) {
+					auto bx = bxStart + i * scanDir;
+					if (by > 0) {
+						auto bxNext = std::clamp(bx + scanDir, 0, nBlkX - 1);
+						auto ScanPosition = [&](auto column) { return aboveScanDir == 1 ? column : nBlkX - 1 - column; };
+						reach = std::max(reach, std::max(ScanPosition(bx), ScanPosition(bxNext)) + 1);
+						rows.WaitFor(by - 1, reach);
+					}
+					context.wavefrontPos = i;
+					context.SetBlock(bx, by, scanDir);
+					context.globalMVPredictor = globalPredictors[context.blkIdx];
+					auto badcountBefore = context.badcount;
+					context.SearchBlock(pBlkData);
+					nBad += context.badcount != badcountBefore;
+					rows.badPrefix[by * nBlkX + i] = nBad;
+					blockSAD[context.blkIdx] = context.bestMV.sad;
+					if (smallestPlane)
+						lumaChange[context.blkIdx] = context.BlockLumaChange();
+					rows.Publish(by, i + 1);
+				}
+			}
+			if (prepared)
+				context.wavefront = nullptr;
+		});
+		globalMVPredictor = lastGlobalPredictor;
+		for (auto& context : wavefrontContexts) {
+			staticSkips += context->staticSkips;
+			if (stats)
+				*stats += context->counters;
+		}
 
-				auto& BlockData = reinterpret_cast<VectorStructure&>(pBlkData[blkx * N_PER_BLOCK]);
-				BlockData = bestMV;
+		// the sums are formed in the order of the serial scan.
+		planeSAD = 0.;
+		sumLumaChange = 0.;
+		for (int32_t by = 0; by < nBlkY; by++) {
+			auto scanDir = (by % 2 == 0 || meander == false) ? 1 : -1;
+			auto bxStart = (scanDir == 1) ? 0 : nBlkX - 1;
+			for (int32_t i = 0; i < nBlkX; i++) {
+				auto idx = by * nBlkX + bxStart + i * scanDir;
+				planeSAD += blockSAD[idx];
+				if (smallestPlane)
+					sumLumaChange += lumaChange[idx];
+			}
+		}
+	}
+	void SearchMVs(MVFrame* _pSrcFrame, MVFrame* _pRefFrame,
+		SearchType st, int32_t stp, double lambda, double lsad, int32_t pnew,
+		int32_t plevel, int32_t* out, VectorStructure* globalMVec,
+		int32_t* outfilebuf, int32_t fieldShift, DCTClass* _DCT, double* pmeanLumaChange,
+		int32_t divideExtra, int32_t _pzero, int32_t _pglobal, double _badSAD, int32_t _badrange, bool meander, int32_t* _vecPrev, bool _tryMany,
+		double _staticRatio, double prepassThreshold, ThreadPool* wavefrontPool) {
+		auto meanLumaChange = *pmeanLumaChange;
+		auto Prepare = [&](PlaneOfBlocks& plane, DCTClass* planeDCT) {
+			plane.PrepareSearch(_pSrcFrame, _pRefFrame, st, stp, lambda, lsad, pnew, plevel, globalMVec, fieldShift, planeDCT, meanLumaChange, _pzero, _pglobal, _badSAD, _badrange, _vecPrev, _tryMany, _staticRatio);
+		};
+		Prepare(*this, _DCT);
+		if (smallestPlane)
+			MarkStaticBlocks(prepassThreshold);
+		// only DCT modes look at anything but the pixels of the source block.
+		sourceCache = nullptr;
+		if (dctmode != 0) {
+			if (!keepSourceBlocks || !sourceBlocks.ready)
+				PrepareSourceBlocks();
+			sourceCache = &sourceBlocks;
+		}
 
+		// write the plane's header
+		WriteHeaderToArray(out);
 
-				if (smallestPlane)
-					sumLumaChange += LUMA(GetRefBlock(0, 0), nRefPitch[0]) - LUMA(pSrc[0], nSrcPitch[0]);
+		int32_t* pBlkData = out + 1;
+		// Functions using double must not be used here
 
-				/* increment indexes & pointers */
-				if (iblkx < nBlkX - 1)
+		if (wavefrontPool && wavefrontPool->GetParticipantCount() > 1 && nBlkY > 1)
+			SearchMVsWavefront(wavefrontPool, pBlkData, meander, Prepare);
+		else
+			for (int32_t by = 0; by < nBlkY; by++)
+			{
+				// meander (alternate) scan blocks (even row left to right, odd row right to left)
+				int32_t scanDir = (by % 2 == 0 || meander == false) ? 1 : -1;
+				int32_t bxStart = (scanDir == 1) ? 0 : nBlkX - 1;
+				for (int32_t iblkx = 0; iblkx < nBlkX; iblkx++)
 				{
-					x[0] += (nBlkSizeX - nOverlapX) * blkScanDir;
-					if (pSrcFrame->GetMode() & UPLANE)
-						x[1] += ((nBlkSizeX - nOverlapX) >> nLogxRatioUV) * blkScanDir;
-					if (pSrcFrame->GetMode() & VPLANE)
-						x[2] += ((nBlkSizeX - nOverlapX) >> nLogxRatioUV) * blkScanDir;
+					SetBlock(bxStart + iblkx * scanDir, by, scanDir);
+					SearchBlock(pBlkData);
+					if (smallestPlane)
+						sumLumaChange += BlockLumaChange();
 				}
 			}
-			pBlkData += nBlkX * N_PER_BLOCK;
-
-			y[0] += (nBlkSizeY - nOverlapY);
-			if (pSrcFrame->GetMode() & UPLANE)
-				y[1] += ((nBlkSizeY - nOverlapY) >> nLogyRatioUV);
-			if (pSrcFrame->GetMode() & VPLANE)
-				y[2] += ((nBlkSizeY - nOverlapY) >> nLogyRatioUV);
-		}
 		if (smallestPlane)
 			*pmeanLumaChange = sumLumaChange / nBlkCount; // for all finer planes
 
 	}
 	void InterpolatePrediction(const PlaneOfBlocks& pob) {
+		staticBlocks.resize(pob.staticMask ? nBlkCount : 0);
+		staticMask = pob.staticMask ? staticBlocks.data() : nullptr;
 		int32_t normFactor = 3 - nLogPel + pob.nLogPel;
 		int32_t mulFactor = (normFactor < 0) ? -normFactor : 0;
 		normFactor = (normFactor < 0) ? 0 : normFactor;
@@ -1271,7 +1720,7 @@ public:
 		{
 			for (int32_t k = 0; k < nBlkX; k++, index++)
 			{
-				VectorStructure v1, v2, v3, v4;
+				int32_t i1, i2, i3, i4;
 				int32_t i = k;
 				int32_t j = l;
 				if (i >= 2 * pob.nBlkX) i = 2 * pob.nBlkX - 1;
@@ -1283,26 +1732,30 @@ public:
 				{
 					if ((j == 0) || (j >= 2 * pob.nBlkY - 1))
 					{
-						v1 = v2 = v3 = v4 = pob.vectors[i / 2 + (j / 2) * pob.nBlkX];
+						i1 = i2 = i3 = i4 = i / 2 + (j / 2) * pob.nBlkX;
 					}
 					else
 					{
-						v1 = v2 = pob.vectors[i / 2 + (j / 2) * pob.nBlkX];
-						v3 = v4 = pob.vectors[i / 2 + (j / 2 + offy) * pob.nBlkX];
+						i1 = i2 = i / 2 + (j / 2) * pob.nBlkX;
+						i3 = i4 = i / 2 + (j / 2 + offy) * pob.nBlkX;
 					}
 				}
 				else if ((j == 0) || (j >= 2 * pob.nBlkY - 1))
 				{
-					v1 = v2 = pob.vectors[i / 2 + (j / 2) * pob.nBlkX];
-					v3 = v4 = pob.vectors[i / 2 + offx + (j / 2) * pob.nBlkX];
+					i1 = i2 = i / 2 + (j / 2) * pob.nBlkX;
+					i3 = i4 = i / 2 + offx + (j / 2) * pob.nBlkX;
 				}
 				else
 				{
-					v1 = pob.vectors[i / 2 + (j / 2) * pob.nBlkX];
-					v2 = pob.vectors[i / 2 + offx + (j / 2) * pob.nBlkX];
-					v3 = pob.vectors[i / 2 + (j / 2 + offy) * pob.nBlkX];
-					v4 = pob.vectors[i / 2 + offx + (j / 2 + offy) * pob.nBlkX];
+					i1 = i / 2 + (j / 2) * pob.nBlkX;
+					i2 = i / 2 + offx + (j / 2) * pob.nBlkX;
+					i3 = i / 2 + (j / 2 + offy) * pob.nBlkX;
+					i4 = i / 2 + offx + (j / 2 + offy) * pob.nBlkX;
 				}
+				VectorStructure v1 = pob.vectors[i1], v2 = pob.vectors[i2], v3 = pob.vectors[i3], v4 = pob.vectors[i4];
+				// a block stays static only if everything it is interpolated from was static.
+				if (staticMask)
+					staticBlocks[index] = pob.staticMask[i1] && pob.staticMask[i2] && pob.staticMask[i3] && pob.staticMask[i4];
 
 				double temp_sad;
 
@@ -1451,6 +1904,13 @@ public:
 	}
 	inline int32_t GetnBlkX() { return nBlkX; }
 	inline int32_t GetnBlkY() { return nBlkY; }
+	inline int32_t GetnBlkCount() { return nBlkCount; }
+	inline int32_t GetStaticSkips() { return staticSkips; }
+	// counting costs a branch per candidate, so it stays off unless asked for.
+	void EnableStats(bool enable) {
+		stats = enable ? &counters : nullptr;
+	}
+	inline const SearchCounters& GetStats() { return counters; }
 	void RecalculateMVs(MVClipBalls& mvClip, MVFrame* _pSrcFrame, MVFrame* _pRefFrame,
 		SearchType st, int32_t stp, double lambda, int32_t pnew, int32_t* out,
 		int32_t* outfilebuf, int32_t fieldShift, double thSAD, DCTClass* _DCT, int32_t divideExtra, int32_t smooth, bool meander) {
@@ -1501,6 +1961,12 @@ public:
 		searchType = st;
 		nSearchParam = stp;//*nPel; // v1.8.2 - redesigned in v1.8.5
 
+		sourceCache = nullptr;
+		if (dctmode != 0) {
+			PrepareSourceBlocks();
+			sourceCache = &sourceBlocks;
+		}
+
 		double nLambdaLevel = lambda / (nPel * nPel);
 
 		// get old vectors plane
@@ -1552,25 +2018,6 @@ public:
 					pSrc[2] = pSrcFrame->GetPlane(VPLANE)->GetAbsolutePelPointer(x[2], y[2]);
 				}
 
-				nSrcPitch[0] = pSrcFrame->GetPlane(YPLANE)->GetPitch();
-				//create aligned copy
-				BLITLUMA(pSrc_temp[0], nSrcPitch_temp[0], pSrc[0], nSrcPitch[0]);
-				//set the to the aligned copy
-				pSrc[0] = pSrc_temp[0];
-				nSrcPitch[0] = nSrcPitch_temp[0];
-				if (chroma)
-				{
-					nSrcPitch[1] = pSrcFrame->GetPlane(UPLANE)->GetPitch();
-					nSrcPitch[2] = pSrcFrame->GetPlane(VPLANE)->GetPitch();
-					BLITCHROMA(pSrc_temp[1], nSrcPitch_temp[1], pSrc[1], nSrcPitch[1]);
-					BLITCHROMA(pSrc_temp[2], nSrcPitch_temp[2], pSrc[2], nSrcPitch[2]);
-					pSrc[1] = pSrc_temp[1];
-					pSrc[2] = pSrc_temp[2];
-					nSrcPitch[1] = nSrcPitch_temp[1];
-					nSrcPitch[2] = nSrcPitch_temp[2];
-				}
-
-
 				if (blky == 0)
 					nLambda = 0.;
 				else
@@ -1647,21 +2094,14 @@ public:
 				bestMV.sad = predictor.sad;
 
 				// update SAD
-				if (dctmode != 0) // DCT method (luma only - currently use normal spatial SAD chroma)
-				{
-					// make dct of source block
-					if (dctmode <= 4) //don't do the slow dct conversion if SATD used
-						DCT->DCTBytes2D(pSrc[0], nSrcPitch[0], dctSrc, dctpitch);
-				}
-				if (dctmode >= 3) // most use it and it should be fast anyway //if (dctmode == 3 || dctmode == 4) // check it
-					srcLuma = LUMA(pSrc[0], nSrcPitch[0]);
+				PrepareSourceBlock();
 
-				double saduv = (chroma) ? SADCHROMA(pSrc[1], nSrcPitch[1], GetRefBlockU(predictor.x, predictor.y), nRefPitch[1])
-					+ SADCHROMA(pSrc[2], nSrcPitch[2], GetRefBlockV(predictor.x, predictor.y), nRefPitch[2]) : 0.f;
-				double sad = LumaSAD(GetRefBlock(predictor.x, predictor.y));
+				double saduv = ChromaSAD(predictor.x, predictor.y);
+				double sad = LumaSAD(predictor.x, predictor.y);
 				sad += saduv;
 				bestMV.sad = sad;
 				nMinCost = sad;
+				ResetCandidateMemo(true);
 
 
 				if (bestMV.sad > thSAD)// if old interpolated vector is bad
@@ -1679,12 +2119,7 @@ public:
 							DiamondSearch(i);
 
 					if (searchType & EXHAUSTIVE)
-					{
-						int32_t mvx = bestMV.x;
-						int32_t mvy = bestMV.y;
-						for (int32_t i = 1; i <= nSearchParam; i++)// region is same as exhaustive, but ordered by radius (from near to far)
-							ExpandingSearch(i, 1, mvx, mvy);
-					}
+						ExhaustiveSearch(nSearchParam, bestMV.x, bestMV.y); // region is same as exhaustive, but ordered by radius (from near to far)
 
 					if (searchType & HEX2SEARCH)
 						Hex2Search(nSearchParam);
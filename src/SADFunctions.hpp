@@ -3,8 +3,13 @@
 #include <cmath>
 #include <array>
 #include "Interface.vxx"
+#include "SADFunctions_AVX512.hpp"
 
 using SADFunction = auto(*)(const std::uint8_t *, std::intptr_t, const std::uint8_t *, std::intptr_t)->double;
+using SADLimitFunction = auto(*)(const std::uint8_t *, std::intptr_t, const std::uint8_t *, std::intptr_t, double)->double;
+using SADx4Function = auto(*)(const std::uint8_t *, std::intptr_t, const std::uint8_t *const *, std::intptr_t, double *)->void;
+using SADYUVFunction = auto(*)(const std::uint8_t *const *, const std::int32_t *, const std::uint8_t *const *, const std::int32_t *, double, double *)->double;
+using SADYUVSelector = auto(*)(int, int)->SADYUVFunction;
 
 struct dual_double final {
 	self(msb, 0.);
@@ -72,6 +77,115 @@ auto Sad_C(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_
 	return sum;
 }
 
+// stops once the SAD of the rows done so far reaches nLimit and returns that partial sum,
+// otherwise the result is the same as Sad_C.
+template<int nBlkWidth, int nBlkHeight>
+auto SadLimit_C(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *pRef8, std::intptr_t nRefPitch, double nLimit) {
+	auto sum = 0.;
+	for (auto y = 0; y < nBlkHeight; ++y) {
+		auto pSrc = reinterpret_cast<const float *>(pSrc8);
+		auto pRef = reinterpret_cast<const float *>(pRef8);
+		for (auto x = 0; x < nBlkWidth; ++x)
+			sum += std::abs(static_cast<decltype(sum)>(pSrc[x]) - pRef[x]);
+		if ((y + 1) % SADRowsPerCheck == 0 && y + 1 < nBlkHeight && sum >= nLimit)
+			return sum;
+		pSrc8 += nSrcPitch;
+		pRef8 += nRefPitch;
+	}
+	return sum;
+}
+
+template<int nBlkWidth, int nBlkHeight>
+auto Sadx4_C(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *const *pRef8, std::intptr_t nRefPitch, double *pSAD) {
+	auto sum = std::array{ 0., 0., 0., 0. };
+	for (auto y = 0; y < nBlkHeight; ++y) {
+		auto pSrc = reinterpret_cast<const float *>(pSrc8 + nSrcPitch * y);
+		for (auto k = 0; k < 4; ++k) {
+			auto pRef = reinterpret_cast<const float *>(pRef8[k] + nRefPitch * y);
+			for (auto x = 0; x < nBlkWidth; ++x)
+				sum[k] += std::abs(static_cast<double>(pSrc[x]) - pRef[x]);
+		}
+	}
+	for (auto k = 0; k < 4; ++k)
+		pSAD[k] = sum[k];
+}
+
+template<int nBlkWidth, int nBlkHeight, InstructionSet isa>
+constexpr auto SadKernel() -> SADFunction {
+#if defined(MVSF_X86)
+	if constexpr (isa >= InstructionSet::AVX512 && nBlkWidth % 16 == 0)
+		return Sad_AVX512<nBlkWidth, nBlkHeight>;
+	else if constexpr (isa >= InstructionSet::AVX2 && nBlkWidth % 8 == 0)
+		return Sad_AVX2<nBlkWidth, nBlkHeight>;
+	else if constexpr (isa >= InstructionSet::SSE2 && (nBlkWidth % 4 == 0 || (nBlkWidth == 2 && nBlkHeight % 2 == 0)))
+		return Sad_SSE2<nBlkWidth, nBlkHeight>;
+	else
+#endif
+		return Sad_C<nBlkWidth, nBlkHeight>;
+}
+
+// same choice of instruction set as SadKernel, a SadLimit kernel that runs to the end matches the Sad kernel exactly.
+template<int nBlkWidth, int nBlkHeight, InstructionSet isa>
+constexpr auto SadLimitKernel() -> SADLimitFunction {
+#if defined(MVSF_X86)
+	if constexpr (isa >= InstructionSet::AVX512 && nBlkWidth % 16 == 0)
+		return SadLimit_AVX512<nBlkWidth, nBlkHeight>;
+	else if constexpr (isa >= InstructionSet::AVX2 && nBlkWidth % 8 == 0)
+		return SadLimit_AVX2<nBlkWidth, nBlkHeight>;
+	else if constexpr (isa >= InstructionSet::SSE2 && (nBlkWidth % 4 == 0 || (nBlkWidth == 2 && nBlkHeight % 2 == 0)))
+		return SadLimit_SSE2<nBlkWidth, nBlkHeight>;
+	else
+#endif
+		return SadLimit_C<nBlkWidth, nBlkHeight>;
+}
+
+// must agree with SadKernel on the instruction set, so batched and single scores are identical.
+template<int nBlkWidth, int nBlkHeight, InstructionSet isa>
+constexpr auto Sadx4Kernel() -> SADx4Function {
+#if defined(MVSF_X86)
+	if constexpr (isa >= InstructionSet::AVX512 && nBlkWidth % 16 == 0)
+		return Sadx4_AVX512<nBlkWidth, nBlkHeight>;
+	else if constexpr (isa >= InstructionSet::AVX2 && nBlkWidth % 8 == 0)
+		return Sadx4_AVX2<nBlkWidth, nBlkHeight>;
+	else if constexpr (isa >= InstructionSet::SSE2 && (nBlkWidth % 4 == 0 || (nBlkWidth == 2 && nBlkHeight % 2 == 0)))
+		return Sadx4_SSE2<nBlkWidth, nBlkHeight>;
+	else
+#endif
+		return Sadx4_C<nBlkWidth, nBlkHeight>;
+}
+
+// luma, U and V of one candidate in a single call, the luma stops early and the chroma planes are skipped once
+// the luma SAD reaches nLumaLimit, the returned luma SAD may then be partial.
+// *pSADUV is only written when the returned luma SAD is below nLumaLimit.
+template<SADLimitFunction LumaSad, SADFunction ChromaSad>
+auto SadYUV(const std::uint8_t *const *pSrc, const std::int32_t *nSrcPitch, const std::uint8_t *const *pRef, const std::int32_t *nRefPitch, double nLumaLimit, double *pSADUV) {
+	auto sad = LumaSad(pSrc[0], nSrcPitch[0], pRef[0], nRefPitch[0], nLumaLimit);
+	if (sad >= nLumaLimit)
+		return sad;
+	*pSADUV = ChromaSad(pSrc[1], nSrcPitch[1], pRef[1], nRefPitch[1]) + ChromaSad(pSrc[2], nSrcPitch[2], pRef[2], nRefPitch[2]);
+	return sad;
+}
+
+// the planes go through SadLimitKernel and SadKernel so the fused scores are identical to the separate kernels,
+// returns nullptr for subsamplings without a fused kernel, the caller then scores the planes separately.
+template<int nBlkWidth, int nBlkHeight, InstructionSet isa>
+auto SadYUVKernel(int xRatioUV, int yRatioUV) -> SADYUVFunction {
+	constexpr auto Luma = SadLimitKernel<nBlkWidth, nBlkHeight, isa>();
+	if (xRatioUV == 1 && yRatioUV == 1)
+		return SadYUV<Luma, SadKernel<nBlkWidth, nBlkHeight, isa>()>;
+	if constexpr (nBlkWidth % 2 == 0)
+		if (xRatioUV == 2 && yRatioUV == 1)
+			return SadYUV<Luma, SadKernel<nBlkWidth / 2, nBlkHeight, isa>()>;
+	if constexpr (nBlkHeight % 2 == 0)
+		if (xRatioUV == 1 && yRatioUV == 2)
+			return SadYUV<Luma, SadKernel<nBlkWidth, nBlkHeight / 2, isa>()>;
+	if constexpr (nBlkWidth % 2 == 0 && nBlkHeight % 2 == 0)
+		if (xRatioUV == 2 && yRatioUV == 2)
+			return SadYUV<Luma, SadKernel<nBlkWidth / 2, nBlkHeight / 2, isa>()>;
+	return nullptr;
+}
+
+
 template<int nBlkWidth, int nBlkHeight>
 auto Satd_C(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *pRef8, std::intptr_t nRefPitch) {
 	auto hadamard4 = [](auto &d0, auto &d1, auto &d2, auto &d3, auto &s0, auto &s1, auto &s2, auto &s3) {
@@ -156,3 +270,15 @@ auto Satd_C(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8
 		return sum;
 	}
 }
+
+template<int nBlkWidth, int nBlkHeight, InstructionSet isa>
+constexpr auto SatdKernel() -> SADFunction {
+#if defined(MVSF_X86)
+	if constexpr (isa >= InstructionSet::AVX2 && nBlkWidth % 8 == 0 && nBlkHeight % 4 == 0)
+		return Satd_AVX2<nBlkWidth, nBlkHeight>;
+	else if constexpr (isa >= InstructionSet::SSE2)
+		return Satd_SSE2<nBlkWidth, nBlkHeight>;
+	else
+#endif
+		return Satd_C<nBlkWidth, nBlkHeight>;
+}
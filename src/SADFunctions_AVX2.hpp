@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include "SADFunctions_SSE2.hpp"
+
+#if defined(MVSF_X86)
+
+MVSF_TARGET_AVX2 static inline auto AbsDiff_AVX2(__m256 a, __m256 b) {
+	return _mm256_andnot_ps(_mm256_set1_ps(-0.f), _mm256_sub_ps(a, b));
+}
+
+MVSF_TARGET_AVX2 static inline auto Widen_AVX2(__m256d acc, __m256 v) {
+	acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+	return _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+}
+
+MVSF_TARGET_AVX2 static inline auto HorizontalSum_AVX2(__m256d v) {
+	auto v128 = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+	return _mm_cvtsd_f64(_mm_add_sd(v128, _mm_unpackhi_pd(v128, v128)));
+}
+
+template<int nBlkWidth, int nBlkHeight, bool bEarlyExit>
+MVSF_TARGET_AVX2 auto SadPartial_AVX2(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *pRef8, std::intptr_t nRefPitch, double nLimit) {
+	static_assert(nBlkWidth % 8 == 0);
+	constexpr auto RowsPerFlush = SADRowsPerFlush(nBlkWidth / 8);
+	auto sum = _mm256_setzero_pd();
+	auto partial = _mm256_setzero_ps();
+	for (auto y = 0, row = 0; y < nBlkHeight; ++y) {
+		auto pSrc = reinterpret_cast<const float *>(pSrc8);
+		auto pRef = reinterpret_cast<const float *>(pRef8);
+		for (auto x = 0; x < nBlkWidth; x += 8)
+			partial = _mm256_add_ps(partial, AbsDiff_AVX2(_mm256_loadu_ps(pSrc + x), _mm256_loadu_ps(pRef + x)));
+		if (++row == RowsPerFlush || y + 1 == nBlkHeight) {
+			sum = Widen_AVX2(sum, partial);
+			partial = _mm256_setzero_ps();
+			row = 0;
+		}
+		if constexpr (bEarlyExit)
+			if ((y + 1) % SADRowsPerCheck == 0 && y + 1 < nBlkHeight)
+				if (auto sad = HorizontalSum_AVX2(Widen_AVX2(sum, partial)); sad >= nLimit)
+					return sad;
+		pSrc8 += nSrcPitch;
+		pRef8 += nRefPitch;
+	}
+	return HorizontalSum_AVX2(sum);
+}
+
+template<int nBlkWidth, int nBlkHeight>
+MVSF_TARGET_AVX2 auto Sad_AVX2(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *pRef8, std::intptr_t nRefPitch) {
+	return SadPartial_AVX2<nBlkWidth, nBlkHeight, false>(pSrc8, nSrcPitch, pRef8, nRefPitch, 0.);
+}
+
+template<int nBlkWidth, int nBlkHeight>
+MVSF_TARGET_AVX2 auto SadLimit_AVX2(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *pRef8, std::intptr_t nRefPitch, double nLimit) {
+	return SadPartial_AVX2<nBlkWidth, nBlkHeight, true>(pSrc8, nSrcPitch, pRef8, nRefPitch, nLimit);
+}
+
+template<int nBlkWidth, int nBlkHeight>
+MVSF_TARGET_AVX2 auto Sadx4_AVX2(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *const *pRef8, std::intptr_t nRefPitch, double *pSAD) {
+	static_assert(nBlkWidth % 8 == 0);
+	constexpr auto RowsPerFlush = SADRowsPerFlush(nBlkWidth / 8);
+	__m256d sum[4] = { _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd() };
+	__m256 partial[4] = { _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps() };
+	auto nRefOffset = std::intptr_t{ 0 };
+	for (auto y = 0, row = 0; y < nBlkHeight; ++y) {
+		auto pSrc = reinterpret_cast<const float *>(pSrc8);
+		for (auto x = 0; x < nBlkWidth; x += 8) {
+			auto src = _mm256_loadu_ps(pSrc + x);
+			for (auto k = 0; k < 4; ++k)
+				partial[k] = _mm256_add_ps(partial[k], AbsDiff_AVX2(src, _mm256_loadu_ps(reinterpret_cast<const float *>(pRef8[k] + nRefOffset) + x)));
+		}
+		if (++row == RowsPerFlush || y + 1 == nBlkHeight) {
+			for (auto k = 0; k < 4; ++k) {
+				sum[k] = Widen_AVX2(sum[k], partial[k]);
+				partial[k] = _mm256_setzero_ps();
+			}
+			row = 0;
+		}
+		pSrc8 += nSrcPitch;
+		nRefOffset += nRefPitch;
+	}
+	for (auto k = 0; k < 4; ++k)
+		pSAD[k] = HorizontalSum_AVX2(sum[k]);
+}
+
+MVSF_TARGET_AVX2 static inline auto Hadamard4Lanes_AVX2(__m256 v) {
+	auto swapped = _mm256_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+	auto t = _mm256_shuffle_ps(_mm256_add_ps(v, swapped), _mm256_sub_ps(v, swapped), _MM_SHUFFLE(2, 0, 2, 0));
+	swapped = _mm256_shuffle_ps(t, t, _MM_SHUFFLE(2, 3, 0, 1));
+	return _mm256_shuffle_ps(_mm256_add_ps(t, swapped), _mm256_sub_ps(t, swapped), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+// one 8x4 partition per iteration, the low 128 bits carry [d0+d4 .. d3+d7] and the high 128 bits [d4 .. d7].
+template<int nBlkWidth, int nBlkHeight>
+MVSF_TARGET_AVX2 auto Satd_AVX2(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *pRef8, std::intptr_t nRefPitch) {
+	static_assert(nBlkWidth % 8 == 0 && nBlkHeight % 4 == 0);
+	auto signmask = _mm256_set1_ps(-0.f);
+	auto sum = _mm256_setzero_pd();
+	for (auto y = 0; y < nBlkHeight; y += 4) {
+		for (auto x = 0; x < nBlkWidth; x += 8) {
+			__m256 rows[4];
+			for (auto i = 0; i < 4; ++i) {
+				auto pSrc = reinterpret_cast<const float *>(pSrc8 + nSrcPitch * i) + x;
+				auto pRef = reinterpret_cast<const float *>(pRef8 + nRefPitch * i) + x;
+				auto d = _mm256_sub_ps(_mm256_loadu_ps(pSrc), _mm256_loadu_ps(pRef));
+				rows[i] = Hadamard4Lanes_AVX2(_mm256_add_ps(d, _mm256_permute2f128_ps(d, d, 0x81)));
+			}
+			auto s0 = _mm256_add_ps(rows[0], rows[1]);
+			auto s1 = _mm256_sub_ps(rows[0], rows[1]);
+			auto s2 = _mm256_add_ps(rows[2], rows[3]);
+			auto s3 = _mm256_sub_ps(rows[2], rows[3]);
+			auto partial = _mm256_add_ps(_mm256_andnot_ps(signmask, _mm256_add_ps(s0, s2)), _mm256_andnot_ps(signmask, _mm256_sub_ps(s0, s2)));
+			partial = _mm256_add_ps(partial, _mm256_andnot_ps(signmask, _mm256_add_ps(s1, s3)));
+			partial = _mm256_add_ps(partial, _mm256_andnot_ps(signmask, _mm256_sub_ps(s1, s3)));
+			sum = Widen_AVX2(sum, partial);
+		}
+		pSrc8 += nSrcPitch * 4;
+		pRef8 += nRefPitch * 4;
+	}
+	return HorizontalSum_AVX2(sum) / 2.;
+}
+
+#endif
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include "SADFunctions_AVX2.hpp"
+
+#if defined(MVSF_X86)
+
+MVSF_TARGET_AVX512 static inline auto AbsDiff_AVX512(__m512 a, __m512 b) {
+	return _mm512_abs_ps(_mm512_sub_ps(a, b));
+}
+
+// the halves are taken with the zero masked extraction, the plain one, the 512 to 256 bit casts and
+// _mm512_reduce_add_pd all pass an undefined operand through that gcc warns about in every caller.
+MVSF_TARGET_AVX512 static inline auto Widen_AVX512(__m512d acc, __m512 v) {
+	auto low = _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xf, _mm512_castps_pd(v), 0));
+	auto high = _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xf, _mm512_castps_pd(v), 1));
+	acc = _mm512_add_pd(acc, _mm512_maskz_cvtps_pd(0xff, low));
+	return _mm512_add_pd(acc, _mm512_maskz_cvtps_pd(0xff, high));
+}
+
+// adds in the order _mm512_reduce_add_pd does.
+MVSF_TARGET_AVX512 static inline auto ReduceAdd_AVX512(__m512d v) {
+	auto halves = _mm256_add_pd(_mm512_maskz_extractf64x4_pd(0xf, v, 1), _mm512_maskz_extractf64x4_pd(0xf, v, 0));
+	auto quarters = _mm_add_pd(_mm256_extractf128_pd(halves, 1), _mm256_castpd256_pd128(halves));
+	return _mm_cvtsd_f64(_mm_add_sd(quarters, _mm_unpackhi_pd(quarters, quarters)));
+}
+
+template<int nBlkWidth, int nBlkHeight, bool bEarlyExit>
+MVSF_TARGET_AVX512 auto SadPartial_AVX512(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *pRef8, std::intptr_t nRefPitch, double nLimit) {
+	static_assert(nBlkWidth % 16 == 0);
+	constexpr auto RowsPerFlush = SADRowsPerFlush(nBlkWidth / 16);
+	auto sum = _mm512_setzero_pd();
+	auto partial = _mm512_setzero_ps();
+	for (auto y = 0, row = 0; y < nBlkHeight; ++y) {
+		auto pSrc = reinterpret_cast<const float *>(pSrc8);
+		auto pRef = reinterpret_cast<const float *>(pRef8);
+		for (auto x = 0; x < nBlkWidth; x += 16)
+			partial = _mm512_add_ps(partial, AbsDiff_AVX512(_mm512_loadu_ps(pSrc + x), _mm512_loadu_ps(pRef + x)));
+		if (++row == RowsPerFlush || y + 1 == nBlkHeight) {
+			sum = Widen_AVX512(sum, partial);
+			partial = _mm512_setzero_ps();
+			row = 0;
+		}
+		if constexpr (bEarlyExit)
+			if ((y + 1) % SADRowsPerCheck == 0 && y + 1 < nBlkHeight)
+				if (auto sad = ReduceAdd_AVX512(Widen_AVX512(sum, partial)); sad >= nLimit)
+					return sad;
+		pSrc8 += nSrcPitch;
+		pRef8 += nRefPitch;
+	}
+	return ReduceAdd_AVX512(sum);
+}
+
+template<int nBlkWidth, int nBlkHeight>
+MVSF_TARGET_AVX512 auto Sad_AVX512(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *pRef8, std::intptr_t nRefPitch) {
+	return SadPartial_AVX512<nBlkWidth, nBlkHeight, false>(pSrc8, nSrcPitch, pRef8, nRefPitch, 0.);
+}
+
+template<int nBlkWidth, int nBlkHeight>
+MVSF_TARGET_AVX512 auto SadLimit_AVX512(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *pRef8, std::intptr_t nRefPitch, double nLimit) {
+	return SadPartial_AVX512<nBlkWidth, nBlkHeight, true>(pSrc8, nSrcPitch, pRef8, nRefPitch, nLimit);
+}
+
+template<int nBlkWidth, int nBlkHeight>
+MVSF_TARGET_AVX512 auto Sadx4_AVX512(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *const *pRef8, std::intptr_t nRefPitch, double *pSAD) {
+	static_assert(nBlkWidth % 16 == 0);
+	constexpr auto RowsPerFlush = SADRowsPerFlush(nBlkWidth / 16);
+	__m512d sum[4] = { _mm512_setzero_pd(), _mm512_setzero_pd(), _mm512_setzero_pd(), _mm512_setzero_pd() };
+	__m512 partial[4] = { _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps() };
+	auto nRefOffset = std::intptr_t{ 0 };
+	for (auto y = 0, row = 0; y < nBlkHeight; ++y) {
+		auto pSrc = reinterpret_cast<const float *>(pSrc8);
+		for (auto x = 0; x < nBlkWidth; x += 16) {
+			auto src = _mm512_loadu_ps(pSrc + x);
+			for (auto k = 0; k < 4; ++k)
+				partial[k] = _mm512_add_ps(partial[k], AbsDiff_AVX512(src, _mm512_loadu_ps(reinterpret_cast<const float *>(pRef8[k] + nRefOffset) + x)));
+		}
+		if (++row == RowsPerFlush || y + 1 == nBlkHeight) {
+			for (auto k = 0; k < 4; ++k) {
+				sum[k] = Widen_AVX512(sum[k], partial[k]);
+				partial[k] = _mm512_setzero_ps();
+			}
+			row = 0;
+		}
+		pSrc8 += nSrcPitch;
+		nRefOffset += nRefPitch;
+	}
+	for (auto k = 0; k < 4; ++k)
+		pSAD[k] = ReduceAdd_AVX512(sum[k]);
+}
+
+#endif
@@ -0,0 +1,195 @@
+#pragma once
+#include <cstdint>
+#include <algorithm>
+#include "CPUFeatures.hpp"
+
+// the early exit SAD kernels compare the SAD of the rows done so far with their limit every few rows.
+constexpr auto SADRowsPerCheck = 4;
+
+#if defined(MVSF_X86)
+
+// abs differences are taken and summed in float for a few rows, then folded into a double accumulator,
+// this keeps the result within float rounding of Sad_C without widening every sample.
+constexpr auto SADRowsPerFlush(int nVectorsPerRow) {
+	return std::max(1, 16 / nVectorsPerRow);
+}
+
+static inline auto AbsDiff_SSE2(__m128 a, __m128 b) {
+	return _mm_andnot_ps(_mm_set1_ps(-0.f), _mm_sub_ps(a, b));
+}
+
+static inline auto Widen_SSE2(__m128d acc, __m128 v) {
+	acc = _mm_add_pd(acc, _mm_cvtps_pd(v));
+	return _mm_add_pd(acc, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+}
+
+static inline auto HorizontalSum_SSE2(__m128d v) {
+	return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+static inline auto LoadPair_SSE2(const std::uint8_t *pRow0, const std::uint8_t *pRow1) {
+	auto v = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double *>(pRow0)));
+	return _mm_loadh_pi(v, reinterpret_cast<const __m64 *>(pRow1));
+}
+
+// widths that are not a multiple of 4 (2xN) are handled two rows at a time.
+// the running total for the early exit goes through the same Widen and HorizontalSum as the final result,
+// so a sum returned early never exceeds the full SAD.
+template<int nBlkWidth, int nBlkHeight, bool bEarlyExit>
+auto SadPartial_SSE2(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *pRef8, std::intptr_t nRefPitch, double nLimit) {
+	static_assert(nBlkWidth % 4 == 0 || (nBlkWidth == 2 && nBlkHeight % 2 == 0));
+	constexpr auto RowsPerStep = nBlkWidth % 4 == 0 ? 1 : 2;
+	constexpr auto VectorsPerStep = std::max(1, nBlkWidth / 4);
+	constexpr auto StepsPerFlush = SADRowsPerFlush(VectorsPerStep);
+	auto sum = _mm_setzero_pd();
+	auto partial = _mm_setzero_ps();
+	for (auto y = 0, step = 0; y < nBlkHeight; y += RowsPerStep) {
+		if constexpr (RowsPerStep == 2)
+			partial = _mm_add_ps(partial, AbsDiff_SSE2(LoadPair_SSE2(pSrc8, pSrc8 + nSrcPitch), LoadPair_SSE2(pRef8, pRef8 + nRefPitch)));
+		else {
+			auto pSrc = reinterpret_cast<const float *>(pSrc8);
+			auto pRef = reinterpret_cast<const float *>(pRef8);
+			for (auto x = 0; x < nBlkWidth; x += 4)
+				partial = _mm_add_ps(partial, AbsDiff_SSE2(_mm_loadu_ps(pSrc + x), _mm_loadu_ps(pRef + x)));
+		}
+		if (++step == StepsPerFlush || y + RowsPerStep >= nBlkHeight) {
+			sum = Widen_SSE2(sum, partial);
+			partial = _mm_setzero_ps();
+			step = 0;
+		}
+		if constexpr (bEarlyExit)
+			if ((y + RowsPerStep) % SADRowsPerCheck == 0 && y + RowsPerStep < nBlkHeight)
+				if (auto sad = HorizontalSum_SSE2(Widen_SSE2(sum, partial)); sad >= nLimit)
+					return sad;
+		pSrc8 += nSrcPitch * RowsPerStep;
+		pRef8 += nRefPitch * RowsPerStep;
+	}
+	return HorizontalSum_SSE2(sum);
+}
+
+template<int nBlkWidth, int nBlkHeight>
+auto Sad_SSE2(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *pRef8, std::intptr_t nRefPitch) {
+	return SadPartial_SSE2<nBlkWidth, nBlkHeight, false>(pSrc8, nSrcPitch, pRef8, nRefPitch, 0.);
+}
+
+template<int nBlkWidth, int nBlkHeight>
+auto SadLimit_SSE2(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *pRef8, std::intptr_t nRefPitch, double nLimit) {
+	return SadPartial_SSE2<nBlkWidth, nBlkHeight, true>(pSrc8, nSrcPitch, pRef8, nRefPitch, nLimit);
+}
+
+// scores 4 reference blocks against one source block, every lane follows the exact order of Sad_SSE2.
+template<int nBlkWidth, int nBlkHeight>
+auto Sadx4_SSE2(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *const *pRef8, std::intptr_t nRefPitch, double *pSAD) {
+	static_assert(nBlkWidth % 4 == 0 || (nBlkWidth == 2 && nBlkHeight % 2 == 0));
+	constexpr auto RowsPerStep = nBlkWidth % 4 == 0 ? 1 : 2;
+	constexpr auto VectorsPerStep = std::max(1, nBlkWidth / 4);
+	constexpr auto StepsPerFlush = SADRowsPerFlush(VectorsPerStep);
+	__m128d sum[4] = { _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd() };
+	__m128 partial[4] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+	auto nRefOffset = std::intptr_t{ 0 };
+	for (auto y = 0, step = 0; y < nBlkHeight; y += RowsPerStep) {
+		if constexpr (RowsPerStep == 2) {
+			auto src = LoadPair_SSE2(pSrc8, pSrc8 + nSrcPitch);
+			for (auto k = 0; k < 4; ++k) {
+				auto pRef = pRef8[k] + nRefOffset;
+				partial[k] = _mm_add_ps(partial[k], AbsDiff_SSE2(src, LoadPair_SSE2(pRef, pRef + nRefPitch)));
+			}
+		}
+		else {
+			auto pSrc = reinterpret_cast<const float *>(pSrc8);
+			for (auto x = 0; x < nBlkWidth; x += 4) {
+				auto src = _mm_loadu_ps(pSrc + x);
+				for (auto k = 0; k < 4; ++k)
+					partial[k] = _mm_add_ps(partial[k], AbsDiff_SSE2(src, _mm_loadu_ps(reinterpret_cast<const float *>(pRef8[k] + nRefOffset) + x)));
+			}
+		}
+		if (++step == StepsPerFlush || y + RowsPerStep >= nBlkHeight) {
+			for (auto k = 0; k < 4; ++k) {
+				sum[k] = Widen_SSE2(sum[k], partial[k]);
+				partial[k] = _mm_setzero_ps();
+			}
+			step = 0;
+		}
+		pSrc8 += nSrcPitch * RowsPerStep;
+		nRefOffset += nRefPitch * RowsPerStep;
+	}
+	for (auto k = 0; k < 4; ++k)
+		pSAD[k] = HorizontalSum_SSE2(sum[k]);
+}
+
+// 4 point Hadamard transform within a vector, outputs come out as [t0+t2, t1+t3, t0-t2, t1-t3],
+// the lane order does not matter to SATD as long as every row uses the same one.
+static inline auto Hadamard4Lanes_SSE2(__m128 v) {
+	auto swapped = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+	auto t = _mm_shuffle_ps(_mm_add_ps(v, swapped), _mm_sub_ps(v, swapped), _MM_SHUFFLE(2, 0, 2, 0));
+	swapped = _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 3, 0, 1));
+	return _mm_shuffle_ps(_mm_add_ps(t, swapped), _mm_sub_ps(t, swapped), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+static inline auto HadamardAbsSum_SSE2(__m128 r0, __m128 r1, __m128 r2, __m128 r3) {
+	auto s0 = _mm_add_ps(r0, r1);
+	auto s1 = _mm_sub_ps(r0, r1);
+	auto s2 = _mm_add_ps(r2, r3);
+	auto s3 = _mm_sub_ps(r2, r3);
+	auto signmask = _mm_set1_ps(-0.f);
+	auto sum = _mm_add_ps(_mm_andnot_ps(signmask, _mm_add_ps(s0, s2)), _mm_andnot_ps(signmask, _mm_sub_ps(s0, s2)));
+	sum = _mm_add_ps(sum, _mm_andnot_ps(signmask, _mm_add_ps(s1, s3)));
+	return _mm_add_ps(sum, _mm_andnot_ps(signmask, _mm_sub_ps(s1, s3)));
+}
+
+static inline auto HorizontalSum_SSE2(__m128 v) {
+	v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+	return static_cast<double>(_mm_cvtss_f32(_mm_add_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)))));
+}
+
+// same transform as Satd_C: the 4x4 path packs [2*d0, d0-d1, 2*d2, d2-d3] per row,
+// the 8x4 path packs [d0+d4, d1+d5, d2+d6, d3+d7] and [d4, d5, d6, d7].
+static inline auto Satd_4x4_SSE2(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *pRef8, std::intptr_t nRefPitch) {
+	__m128 rows[4];
+	auto oddsign = _mm_castsi128_ps(_mm_set_epi32(static_cast<int>(0x80000000), 0, static_cast<int>(0x80000000), 0));
+	for (auto i = 0; i < 4; ++i) {
+		auto d = _mm_sub_ps(_mm_loadu_ps(reinterpret_cast<const float *>(pSrc8)), _mm_loadu_ps(reinterpret_cast<const float *>(pRef8)));
+		auto p = _mm_add_ps(_mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 2, 0, 0)), _mm_xor_ps(d, oddsign));
+		auto q = _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 0, 3, 2));
+		rows[i] = _mm_shuffle_ps(_mm_add_ps(p, q), _mm_sub_ps(q, p), _MM_SHUFFLE(3, 2, 1, 0));
+		pSrc8 += nSrcPitch;
+		pRef8 += nRefPitch;
+	}
+	return HorizontalSum_SSE2(HadamardAbsSum_SSE2(rows[0], rows[1], rows[2], rows[3])) / 2.;
+}
+
+static inline auto Satd_8x4_SSE2(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *pRef8, std::intptr_t nRefPitch) {
+	__m128 lows[4], highs[4];
+	for (auto i = 0; i < 4; ++i) {
+		auto pSrc = reinterpret_cast<const float *>(pSrc8);
+		auto pRef = reinterpret_cast<const float *>(pRef8);
+		auto high = _mm_sub_ps(_mm_loadu_ps(pSrc + 4), _mm_loadu_ps(pRef + 4));
+		auto low = _mm_add_ps(_mm_sub_ps(_mm_loadu_ps(pSrc), _mm_loadu_ps(pRef)), high);
+		lows[i] = Hadamard4Lanes_SSE2(low);
+		highs[i] = Hadamard4Lanes_SSE2(high);
+		pSrc8 += nSrcPitch;
+		pRef8 += nRefPitch;
+	}
+	auto sum = _mm_add_ps(HadamardAbsSum_SSE2(lows[0], lows[1], lows[2], lows[3]), HadamardAbsSum_SSE2(highs[0], highs[1], highs[2], highs[3]));
+	return HorizontalSum_SSE2(sum) / 2.;
+}
+
+template<int nBlkWidth, int nBlkHeight>
+auto Satd_SSE2(const std::uint8_t *pSrc8, std::intptr_t nSrcPitch, const std::uint8_t *pRef8, std::intptr_t nRefPitch) {
+	if constexpr (nBlkWidth == 4 && nBlkHeight == 4)
+		return Satd_4x4_SSE2(pSrc8, nSrcPitch, pRef8, nRefPitch);
+	else {
+		static_assert(nBlkWidth % 8 == 0 && nBlkHeight % 4 == 0);
+		constexpr auto bytesPerSample = sizeof(float);
+		auto sum = 0.;
+		for (auto y = 0; y < nBlkHeight; y += 4) {
+			for (auto x = 0; x < nBlkWidth; x += 8)
+				sum += Satd_8x4_SSE2(pSrc8 + x * bytesPerSample, nSrcPitch, pRef8 + x * bytesPerSample, nRefPitch);
+			pSrc8 += nSrcPitch * 4;
+			pRef8 += nRefPitch * 4;
+		}
+		return sum;
+	}
+}
+
+#endif
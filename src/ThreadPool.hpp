@@ -0,0 +1,80 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a fixed set of helper threads that join the calling thread on one job at a time. the job is called once per
+// participant with its index (0 is always the caller) and is expected to claim its own share of the work, so a
+// helper that wakes up late simply finds nothing left. a caller that finds the pool busy with another job runs
+// its job alone instead of waiting.
+class ThreadPool final {
+	std::vector<std::thread> helpers;
+	std::mutex runLock;
+	std::mutex stateLock;
+	std::condition_variable wake;
+	std::condition_variable done;
+	const std::function<void(std::int32_t)> *job = nullptr;
+	std::uint64_t generation = 0;
+	std::int32_t running = 0;
+	bool stopping = false;
+	auto HelperLoop(std::int32_t participant) {
+		auto seen = std::uint64_t{ 0 };
+		auto lock = std::unique_lock{ stateLock };
+		while (true) {
+			wake.wait(lock, [&] { return stopping || generation != seen; });
+			if (stopping)
+				return;
+			seen = generation;
+			auto current = job;
+			lock.unlock();
+			(*current)(participant);
+			lock.lock();
+			if (--running == 0)
+				done.notify_one();
+		}
+	}
+public:
+	explicit ThreadPool(std::int32_t nHelpers) {
+		helpers.reserve(nHelpers);
+		for (auto i = 0; i < nHelpers; ++i)
+			helpers.emplace_back([this, i] { HelperLoop(i + 1); });
+	}
+	ThreadPool(ThreadPool &&) = delete;
+	ThreadPool(const ThreadPool &) = delete;
+	auto &operator=(ThreadPool &&) = delete;
+	auto &operator=(const ThreadPool &) = delete;
+	~ThreadPool() {
+		{
+			auto lock = std::lock_guard{ stateLock };
+			stopping = true;
+		}
+		wake.notify_all();
+		for (auto &x : helpers)
+			x.join();
+	}
+	// number of participants a job may see, including the caller.
+	auto GetParticipantCount() const {
+		return static_cast<std::int32_t>(helpers.size()) + 1;
+	}
+	auto Run(const std::function<void(std::int32_t)> &Job) {
+		auto busy = std::unique_lock{ runLock, std::try_to_lock };
+		if (!busy.owns_lock() || helpers.empty()) {
+			Job(0);
+			return;
+		}
+		{
+			auto lock = std::lock_guard{ stateLock };
+			job = &Job;
+			running = static_cast<std::int32_t>(helpers.size());
+			++generation;
+		}
+		wake.notify_all();
+		Job(0);
+		auto lock = std::unique_lock{ stateLock };
+		done.wait(lock, [&] { return running == 0; });
+		job = nullptr;
+	}
+};
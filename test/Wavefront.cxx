@@ -0,0 +1,118 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <vector>
+#include "Core.hpp"
+
+// the wavefront search must find exactly the vectors of the serial scan. every case searches a pair of synthetic
+// frames once serially and once on four threads and counts the ints of the vector frames that differ.
+
+namespace {
+
+constexpr auto Width = 320;
+constexpr auto Height = 240;
+constexpr auto Pan = 16;
+constexpr auto StaticLeft = 224;
+
+auto Hash(std::uint32_t x, std::uint32_t y, std::uint32_t plane) {
+	auto h = x * 0x8da6b343u ^ y * 0xd8163841u ^ plane * 0xcb1ab31fu;
+	h ^= h >> 15;
+	h *= 0x2c1b3c6du;
+	h ^= h >> 12;
+	return (h & 0xffff) / 65535.f;
+}
+
+// smooth texture on an 8 pixel lattice with a little per pixel detail, defined on the whole plane so any shift of it
+// is exact.
+auto Texture(int x, int y, int plane) {
+	auto cx = static_cast<std::uint32_t>(x + 1024) / 8;
+	auto cy = static_cast<std::uint32_t>(y + 1024) / 8;
+	auto fx = ((x + 1024) % 8) / 8.f;
+	auto fy = ((y + 1024) % 8) / 8.f;
+	auto top = Hash(cx, cy, plane) * (1 - fx) + Hash(cx + 1, cy, plane) * fx;
+	auto bottom = Hash(cx, cy + 1, plane) * (1 - fx) + Hash(cx + 1, cy + 1, plane) * fx;
+	auto detail = Hash(x + 1024, y + 1024, plane + 3);
+	return 0.1f + 0.7f * (top * (1 - fy) + bottom * fy) + 0.1f * detail;
+}
+
+// the reference pans the source right by Pan pixels, except for a static strip on the right whose blocks would clip
+// the global predictor if they were searched. noise is drawn anew for each frame.
+auto Fill(mvsf::FrameBuffer &frame, bool reference, float noise) {
+	auto view = frame.WritableView();
+	auto &format = frame.GetFormat();
+	for (auto plane = 0; plane < format.Planes; ++plane) {
+		auto scale = plane ? 2 : 1;
+		for (auto y = 0; y < format.PlaneHeight(plane); ++y) {
+			auto row = reinterpret_cast<float *>(view.Planes[plane] + y * view.Pitches[plane]);
+			for (auto x = 0; x < format.PlaneWidth(plane); ++x)
+				row[x] = Texture(reference && x * scale < StaticLeft ? x - Pan / scale : x, y, plane) + noise * Hash(x, y, plane + 6 + reference);
+		}
+	}
+}
+
+struct Case final {
+	const char *Name;
+	float Noise;
+	mvsf::AnalyzeParameters Parameters;
+};
+
+auto Differences(const Case &x) {
+	auto format = mvsf::Format{ Width, Height };
+	auto super = mvsf::Super{ format };
+	auto source = mvsf::FrameBuffer{ format };
+	auto reference = mvsf::FrameBuffer{ format };
+	auto superSource = mvsf::FrameBuffer{ super.GetSuperFormat() };
+	auto superReference = mvsf::FrameBuffer{ super.GetSuperFormat() };
+	Fill(source, false, x.Noise);
+	Fill(reference, true, x.Noise);
+	super.Process(source.View(), superSource.WritableView());
+	super.Process(reference.View(), superReference.WritableView());
+	auto parameters = x.Parameters;
+	parameters.Wavefront = 0;
+	auto serial = mvsf::Analyze{ super.GetInfo(), parameters };
+	parameters.Wavefront = 4;
+	auto wavefront = mvsf::Analyze{ super.GetInfo(), parameters };
+	auto expected = std::vector<std::int32_t>(serial.GetVectorSize());
+	auto actual = std::vector<std::int32_t>(wavefront.GetVectorSize());
+	serial.Search(superSource.View(), superReference.View(), 1, true, expected.data());
+	wavefront.Search(superSource.View(), superReference.View(), 1, true, actual.data());
+	auto count = 0;
+	for (auto i = std::size_t{ 0 }; i < expected.size(); ++i)
+		count += expected[i] != actual[i];
+	return count;
+}
+
+}
+
+int main() try {
+	auto cases = std::vector<Case>{};
+	auto parameters = mvsf::AnalyzeParameters{};
+	parameters.Meander = false;
+	parameters.Prepass = 2.;
+	// the pre-pass only looks at the smallest level, it must be fine enough to hold blocks inside the static strip.
+	parameters.Levels = 3;
+	cases.push_back({ "prepass", 0.f, parameters });
+	// enough noise to leave many vectors bad, each of them counts the bad blocks before it in scan order.
+	parameters = {};
+	parameters.Meander = false;
+	parameters.BadSAD = 200.;
+	cases.push_back({ "badsad", 0.1f, parameters });
+	cases.push_back({ "meander", 0.f, {} });
+
+	auto failed = false;
+	for (auto &x : cases) {
+		auto count = Differences(x);
+		std::printf("%-12s %s", x.Name, count ? "FAIL" : "ok");
+		if (count)
+			std::printf(", %d ints differ", count);
+		std::printf("\n");
+		failed |= count != 0;
+	}
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+catch (const std::exception &error) {
+	std::fprintf(stderr, "wavefront: %s\n", error.what());
+	return EXIT_FAILURE;
+}